@@ -0,0 +1,417 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "../test/test_data.h"
+#include "bench.h"
+
+#include <zix/digest.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Throughput is measured by hashing many keys of each size, packed end to end
+  in a large buffer.  The quality checks only look at the low bits of the
+  result, since that's all ZixHash uses to choose a bucket.
+*/
+
+#define MAX_KEY_SIZE (1U << 20U)   ///< Size of the largest key
+#define BENCH_BYTES (1U << 24U)    ///< Bytes hashed for each measurement
+#define N_AVALANCHE_SAMPLES 1000U  ///< Keys hashed for each avalanche test
+#define N_DISTRIBUTION_KEYS 65536U ///< Keys hashed for distribution tests
+#define N_COLLISION_KEYS 262144U   ///< Keys hashed for collision tests
+#define N_LOW_BITS 32U             ///< Number of low hash bits checked
+
+typedef uint64_t (*DigestFunc)(uint64_t seed, const void* buf, size_t len);
+
+typedef struct {
+  const char* name;      ///< Name of the function
+  DigestFunc  func;      ///< Wrapper to call the function
+  size_t      alignment; ///< Required alignment, or 0 for any
+  bool        check;     ///< True if the quality of this function is checked
+} Digest;
+
+typedef void (*KeyFunc)(size_t i, uint8_t* key, size_t len);
+
+typedef struct {
+  const char* name; ///< Description of the key set
+  KeyFunc     func; ///< Function to write the ith key
+  size_t      len;  ///< Length of every key in bytes
+} KeySet;
+
+static uint64_t
+digest32(const uint64_t seed, const void* const buf, const size_t len)
+{
+  return zix_digest32((uint32_t)seed, buf, len);
+}
+
+static uint64_t
+digest32_aligned(const uint64_t seed, const void* const buf, const size_t len)
+{
+  return zix_digest32_aligned((uint32_t)seed, buf, len);
+}
+
+static uint64_t
+digest(const uint64_t seed, const void* const buf, const size_t len)
+{
+  return zix_digest((size_t)seed, buf, len);
+}
+
+static uint64_t
+digest_aligned(const uint64_t seed, const void* const buf, const size_t len)
+{
+  return zix_digest_aligned((size_t)seed, buf, len);
+}
+
+static const Digest digests[] = {
+  {"zix_digest32", digest32, 0U, true},
+  {"zix_digest32_aligned", digest32_aligned, 4U, false},
+  {"zix_digest64", zix_digest64, 0U, true},
+  {"zix_digest64_aligned", zix_digest64_aligned, 8U, false},
+  {"zix_digest64_wide", zix_digest64_wide, 0U, false},
+  {"zix_digest", digest, 0U, true},
+  {"zix_digest_aligned", digest_aligned, sizeof(size_t), false},
+};
+
+#define N_DIGESTS (sizeof(digests) / sizeof(Digest))
+
+static void
+sequential_key(const size_t i, uint8_t* const key, const size_t len)
+{
+  const uint64_t n = i;
+  memset(key, 0, len);
+  memcpy(key, &n, len < sizeof(n) ? len : sizeof(n));
+}
+
+static void
+random_key(const size_t i, uint8_t* const key, const size_t len)
+{
+  uint64_t state = lcg64(i + 1U);
+  for (size_t j = 0U; j < len; ++j) {
+    state  = lcg64(state);
+    key[j] = (uint8_t)(state >> 56U);
+  }
+}
+
+static void
+uri_key(const size_t i, uint8_t* const key, const size_t len)
+{
+  char uri[64] = {0};
+  snprintf(uri, sizeof(uri), "http://example.org/ns/things/%08zu", i);
+  memcpy(key, uri, len);
+}
+
+static const KeySet key_sets[] = {
+  {"sequential 4-byte integers", sequential_key, 4U},
+  {"sequential 8-byte integers", sequential_key, 8U},
+  {"random 16-byte keys", random_key, 16U},
+  {"random 64-byte keys", random_key, 64U},
+  {"37-byte URIs", uri_key, 37U},
+};
+
+#define N_KEY_SETS (sizeof(key_sets) / sizeof(KeySet))
+
+/// Return the throughput of a digest in bytes per second
+static double
+measure(const Digest* const  d,
+        const uint8_t* const buf,
+        const size_t         key_size,
+        const size_t         offset)
+{
+  if (d->alignment && (key_size % d->alignment || offset % d->alignment)) {
+    return 0.0;
+  }
+
+  const size_t n_keys = MAX_KEY_SIZE / key_size;
+  const size_t n_reps = BENCH_BYTES / MAX_KEY_SIZE;
+
+  uint64_t            sum   = 0U;
+  const BenchmarkTime start = bench_start();
+  for (size_t r = 0U; r < n_reps; ++r) {
+    for (size_t i = 0U; i < n_keys; ++i) {
+      sum += d->func(r, buf + offset + (i * key_size), key_size);
+    }
+  }
+
+  const double elapsed = bench_end(&start);
+
+  volatile uint64_t sink = sum;
+  (void)sink;
+
+  return (double)(n_reps * n_keys * key_size) / elapsed;
+}
+
+/// Return the throughput of zix_digest64_batch() in bytes per second
+static double
+measure_batch(const uint8_t* const buf,
+              const void** const   bufs,
+              size_t* const        lens,
+              uint64_t* const      out,
+              const size_t         key_size)
+{
+  const size_t n_keys = MAX_KEY_SIZE / key_size;
+  const size_t n_reps = BENCH_BYTES / MAX_KEY_SIZE;
+  for (size_t i = 0U; i < n_keys; ++i) {
+    bufs[i] = buf + (i * key_size);
+    lens[i] = key_size;
+  }
+
+  uint64_t            sum   = 0U;
+  const BenchmarkTime start = bench_start();
+  for (size_t r = 0U; r < n_reps; ++r) {
+    zix_digest64_batch(r, bufs, lens, n_keys, out);
+    sum += out[r % n_keys];
+  }
+
+  const double elapsed = bench_end(&start);
+
+  volatile uint64_t sink = sum;
+  (void)sink;
+
+  return (double)(n_reps * n_keys * key_size) / elapsed;
+}
+
+static int
+bench_throughput(const size_t max_key_size)
+{
+  FILE* const dat = fopen("digest_throughput.txt", "w");
+  if (!dat) {
+    fprintf(stderr, "error: Failed to open digest_throughput.txt\n");
+    return 1;
+  }
+
+  uint8_t* const  buf  = (uint8_t*)calloc(1U, MAX_KEY_SIZE + 8U);
+  const void**    bufs = (const void**)calloc(MAX_KEY_SIZE, sizeof(void*));
+  size_t* const   lens = (size_t*)calloc(MAX_KEY_SIZE, sizeof(size_t));
+  uint64_t* const out  = (uint64_t*)calloc(MAX_KEY_SIZE, sizeof(uint64_t));
+  if (!buf || !bufs || !lens || !out) {
+    fprintf(stderr, "error: Failed to allocate buffers\n");
+    free(out);
+    free(lens);
+    free(bufs);
+    free(buf);
+    fclose(dat);
+    return 1;
+  }
+
+  random_key(0U, buf, MAX_KEY_SIZE + 8U);
+
+  // Write header with a column for each function and alignment
+  fprintf(dat, "# size");
+  for (size_t i = 0U; i < N_DIGESTS; ++i) {
+    fprintf(dat, "\t%s", digests[i].name);
+    if (!digests[i].alignment) {
+      fprintf(dat, "\t%s_unaligned", digests[i].name);
+    }
+  }
+  fprintf(dat, "\tzix_digest64_batch\n");
+
+  // Write a row of throughputs in GB/s for each size, or 0 if unsupported
+  for (size_t size = 1U; size <= max_key_size; size *= 2U) {
+    fprintf(stderr, "Benchmarking %zu byte keys\n", size);
+    fprintf(dat, "%zu", size);
+    for (size_t i = 0U; i < N_DIGESTS; ++i) {
+      fprintf(dat, "\t%lf", measure(&digests[i], buf, size, 0U) * 1.0e-9);
+      if (!digests[i].alignment) {
+        fprintf(dat, "\t%lf", measure(&digests[i], buf, size, 1U) * 1.0e-9);
+      }
+    }
+
+    fprintf(dat, "\t%lf\n", measure_batch(buf, bufs, lens, out, size) * 1.0e-9);
+  }
+
+  free(out);
+  free(lens);
+  free(bufs);
+  free(buf);
+  fclose(dat);
+  fprintf(stderr, "Wrote digest_throughput.txt\n");
+  return 0;
+}
+
+/// Return the largest bias of any input bit flip on any low output bit
+static double
+avalanche_bias(const Digest* const d, const KeySet* const keys)
+{
+  static unsigned counts[64U * 8U][N_LOW_BITS];
+  memset(counts, 0, sizeof(counts));
+
+  const size_t n_in_bits = keys->len * 8U;
+  uint8_t      key[64]   = {0U};
+  for (size_t s = 0U; s < N_AVALANCHE_SAMPLES; ++s) {
+    random_key(s, key, keys->len);
+
+    const uint64_t h = d->func(0U, key, keys->len);
+    for (size_t b = 0U; b < n_in_bits; ++b) {
+      key[b / 8U] ^= (uint8_t)(1U << (b % 8U));
+      const uint64_t diff = h ^ d->func(0U, key, keys->len);
+      key[b / 8U] ^= (uint8_t)(1U << (b % 8U));
+
+      for (unsigned o = 0U; o < N_LOW_BITS; ++o) {
+        counts[b][o] += (unsigned)((diff >> o) & 1U);
+      }
+    }
+  }
+
+  double max_bias = 0.0;
+  for (size_t b = 0U; b < n_in_bits; ++b) {
+    for (unsigned o = 0U; o < N_LOW_BITS; ++o) {
+      const double p    = (double)counts[b][o] / N_AVALANCHE_SAMPLES;
+      const double bias = (p > 0.5) ? p - 0.5 : 0.5 - p;
+      max_bias          = (bias > max_bias) ? bias : max_bias;
+    }
+  }
+
+  return max_bias;
+}
+
+/// Return the chi-squared deviation (in standard deviations) of bucket loads
+static double
+distribution_score(const Digest* const d,
+                   const KeySet* const keys,
+                   const unsigned      n_bucket_bits)
+{
+  const size_t n_buckets = (size_t)1U << n_bucket_bits;
+  const size_t mask      = n_buckets - 1U;
+  size_t*      counts    = (size_t*)calloc(n_buckets, sizeof(size_t));
+  if (!counts) {
+    return 0.0;
+  }
+
+  uint8_t key[64] = {0U};
+  for (size_t i = 0U; i < N_DISTRIBUTION_KEYS; ++i) {
+    keys->func(i, key, keys->len);
+    ++counts[d->func(0U, key, keys->len) & mask];
+  }
+
+  const double expected = (double)N_DISTRIBUTION_KEYS / (double)n_buckets;
+  double       chi2     = 0.0;
+  for (size_t i = 0U; i < n_buckets; ++i) {
+    const double delta = (double)counts[i] - expected;
+    chi2 += delta * delta / expected;
+  }
+
+  free(counts);
+
+  // Normal approximation of the chi-squared distribution
+  const double dof = (double)(n_buckets - 1U);
+  return (chi2 - dof) / sqrt(2.0 * dof);
+}
+
+static int
+compare_u32(const void* const a, const void* const b)
+{
+  const uint32_t ia = *(const uint32_t*)a;
+  const uint32_t ib = *(const uint32_t*)b;
+
+  return (ia < ib) ? -1 : (ia > ib) ? 1 : 0;
+}
+
+/// Return the number of collisions in the low 32 bits of hashes
+static size_t
+count_collisions(const Digest* const d, const KeySet* const keys)
+{
+  uint32_t* const hashes =
+    (uint32_t*)calloc(N_COLLISION_KEYS, sizeof(uint32_t));
+  if (!hashes) {
+    return 0U;
+  }
+
+  uint8_t key[64] = {0U};
+  for (size_t i = 0U; i < N_COLLISION_KEYS; ++i) {
+    keys->func(i, key, keys->len);
+    hashes[i] = (uint32_t)d->func(0U, key, keys->len);
+  }
+
+  qsort(hashes, N_COLLISION_KEYS, sizeof(uint32_t), compare_u32);
+
+  size_t n_collisions = 0U;
+  for (size_t i = 1U; i < N_COLLISION_KEYS; ++i) {
+    n_collisions += (hashes[i] == hashes[i - 1U]);
+  }
+
+  free(hashes);
+  return n_collisions;
+}
+
+static bool
+check_quality(const Digest* const d, const KeySet* const keys)
+{
+  // Expected number of collisions among random 32-bit values
+  static const double expected_collisions =
+    (double)N_COLLISION_KEYS * (N_COLLISION_KEYS - 1U) / 2.0 / 4294967296.0;
+
+  // Generous limits which any decent hash should easily meet
+  static const double   max_bias       = 0.1;
+  static const double   max_score      = 6.0;
+  static const unsigned max_collisions = 64U;
+  static const unsigned bucket_bits[]  = {4U, 8U, 12U};
+
+  bool success = true;
+
+  const double bias = avalanche_bias(d, keys);
+  printf("%-14s %-28s avalanche bias %.4f", d->name, keys->name, bias);
+  success = success && bias <= max_bias;
+
+  double worst_score = 0.0;
+  for (size_t i = 0U; i < sizeof(bucket_bits) / sizeof(unsigned); ++i) {
+    const double score = distribution_score(d, keys, bucket_bits[i]);
+    worst_score        = (score > worst_score) ? score : worst_score;
+  }
+
+  printf("  bucket score %6.2f", worst_score);
+  success = success && worst_score <= max_score;
+
+  const size_t n_collisions = count_collisions(d, keys);
+  printf("  collisions %zu (expected %.1f)\n",
+         n_collisions,
+         expected_collisions);
+  success = success && n_collisions <= max_collisions;
+
+  if (!success) {
+    fprintf(stderr, "error: %s fails on %s\n", d->name, keys->name);
+  }
+
+  return success;
+}
+
+static int
+bench_quality(void)
+{
+  int st = 0;
+  for (size_t i = 0U; i < N_DIGESTS; ++i) {
+    if (digests[i].check) {
+      for (size_t k = 0U; k < N_KEY_SETS; ++k) {
+        st = check_quality(&digests[i], &key_sets[k]) ? st : 1;
+      }
+    }
+  }
+
+  return st;
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 2) {
+    fprintf(stderr, "Usage: %s [MAX_KEY_SIZE]\n", argv[0]);
+    return 1;
+  }
+
+  const unsigned long max_key_size =
+    (argc > 1) ? strtoul(argv[1], NULL, 10) : MAX_KEY_SIZE;
+
+  if (!max_key_size || max_key_size > MAX_KEY_SIZE) {
+    fprintf(stderr, "error: Key size must be between 1 and %u\n", MAX_KEY_SIZE);
+    return 1;
+  }
+
+  const int st = bench_quality();
+
+  return bench_throughput(max_key_size) || st;
+}
@@ -0,0 +1,112 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_ARENA_ALLOCATOR_H
+#define ZIX_ARENA_ALLOCATOR_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <stddef.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_arena_allocator Arena Allocator
+   @ingroup zix_allocation
+   @{
+*/
+
+/**
+   A growable bump-pointer allocator that frees everything at once.
+
+   This works like a ZixBumpAllocator, but when the current block is full, a
+   new one is allocated from a parent allocator and chained to the previous
+   ones.  Memory is only returned to the parent when the arena is rewound or
+   reset, which releases everything allocated since some point in a single
+   call.  This makes it a good fit for temporary data structures with a
+   well-defined lifetime, like everything allocated while handling a request.
+
+   Allocation is very fast and has no per-allocation overhead, but individual
+   deallocation is as limited as with the bump allocator:
+
+   - All allocations are aligned to at least sizeof(uintmax_t).
+
+   - Calling free() only reclaims the space of the most recent allocation, and
+     otherwise does nothing.
+
+   - Calling realloc() on the most recent allocation extends it in place if
+     there is space, otherwise it moves the data to a new allocation and
+     leaves the old space unused until the arena is rewound.
+*/
+typedef struct ZixArenaAllocatorImpl ZixArenaAllocator;
+
+/**
+   A position in an arena that can later be rewound to.
+
+   Members are private and should not be accessed directly.
+*/
+typedef struct {
+  void* ZIX_NULLABLE block; ///< Block that was current when marked
+  size_t             top;   ///< Stack top offset within block
+} ZixArenaMark;
+
+/**
+   Create a new arena allocator.
+
+   The arena is created with an initial block of the given size, which is
+   never released until the arena itself is freed, so typical use within that
+   size doesn't need to allocate from the parent at all.
+
+   @param parent Allocator for the arena and its blocks.
+   @param block_size Size of each block in bytes.  Larger allocations are made
+   in a dedicated block of sufficient size.
+   @return A new arena, or null if memory allocation failed.
+*/
+ZIX_API ZIX_NODISCARD ZixArenaAllocator* ZIX_ALLOCATED
+zix_arena_allocator_new(ZixAllocator* ZIX_NULLABLE parent, size_t block_size);
+
+/**
+   Free an arena allocator.
+
+   This returns all of the memory used by the arena to the parent, so any
+   remaining allocations made with it are invalidated.
+*/
+ZIX_API void
+zix_arena_allocator_free(ZixArenaAllocator* ZIX_NULLABLE arena);
+
+/// Return the allocator interface of an arena
+ZIX_PURE_API ZixAllocator* ZIX_NONNULL
+zix_arena_allocator_base(ZixArenaAllocator* ZIX_NONNULL arena);
+
+/// Return the current position of an arena for later rewinding
+ZIX_PURE_API ZIX_REALTIME ZixArenaMark
+zix_arena_allocator_mark(const ZixArenaAllocator* ZIX_NONNULL arena);
+
+/**
+   Free everything allocated since a mark.
+
+   Blocks allocated since the mark was made are returned to the parent
+   allocator.  Rewinding invalidates any marks made after the given one, so
+   marks must be rewound in stack order.
+*/
+ZIX_API void
+zix_arena_allocator_rewind(ZixArenaAllocator* ZIX_NONNULL arena,
+                           ZixArenaMark                  mark);
+
+/**
+   Free everything allocated with an arena.
+
+   This is equivalent to rewinding to a mark made immediately after the arena
+   was created, so the initial block is kept for reuse.
+*/
+ZIX_API void
+zix_arena_allocator_reset(ZixArenaAllocator* ZIX_NONNULL arena);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_ARENA_ALLOCATOR_H
@@ -0,0 +1,82 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_CACHING_ALLOCATOR_H
+#define ZIX_CACHING_ALLOCATOR_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_caching_allocator Caching Allocator
+   @ingroup zix_allocation
+   @{
+*/
+
+/**
+   A general-purpose allocator with per-thread caches.
+
+   This allocator is designed for multi-threaded programs that frequently
+   allocate and free small objects, where a general-purpose malloc() can
+   become a bottleneck due to contention between threads.
+
+   Small allocations (up to 4 KiB) are rounded up to one of several size
+   classes, and carved out of 64 KiB slabs allocated from the parent
+   allocator.  Each thread is assigned one of a fixed number of caches, which
+   has its own slabs and free lists.  Memory freed by the thread that
+   allocated it is returned to the cache's free list immediately, and memory
+   freed by another thread is pushed to a lock-free queue which the owning
+   cache reclaims later.  A thread that finds its cache in use by another
+   switches to a free one, so threads spread out over the caches.
+
+   Larger allocations are made individually from the parent, but with a 64 KiB
+   alignment so that they can be recognized when freed, which may waste some
+   memory in the parent.  These are tracked in a shared list, so they are
+   freed along with the allocator if they are still live.
+
+   If there are at least as many caches as threads, then threads never contend
+   with each other except when freeing memory allocated by another.  Slabs are
+   never returned to the parent until the allocator is destroyed, so this is
+   best suited to workloads where memory usage is reasonably stable.
+
+   Requested alignments of up to 4 KiB are supported for small allocations,
+   and up to 32 KiB for large ones.
+
+   The parent allocator must be thread-safe.
+*/
+typedef struct ZixCachingAllocatorImpl ZixCachingAllocator;
+
+/**
+   Create a new caching allocator.
+
+   @param parent Allocator for the allocator itself, and its slabs.
+   @param n_caches Number of independent caches, which should typically be at
+   least the number of threads that will use the allocator.
+   @return A new allocator, or null if `n_caches` is zero or memory allocation
+   failed.
+*/
+ZIX_API ZIX_NODISCARD ZixCachingAllocator* ZIX_ALLOCATED
+zix_caching_allocator_new(ZixAllocator* ZIX_NULLABLE parent, unsigned n_caches);
+
+/**
+   Destroy a caching allocator.
+
+   This frees all the memory owned by the allocator, so any remaining
+   allocations made with it are invalidated.
+*/
+ZIX_API void
+zix_caching_allocator_free(ZixCachingAllocator* ZIX_NULLABLE allocator);
+
+/// Return the allocator interface of a caching allocator
+ZIX_PURE_API ZixAllocator* ZIX_NONNULL
+zix_caching_allocator_base(ZixCachingAllocator* ZIX_NONNULL allocator);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_CACHING_ALLOCATOR_H
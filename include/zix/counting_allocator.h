@@ -0,0 +1,127 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_COUNTING_ALLOCATOR_H
+#define ZIX_COUNTING_ALLOCATOR_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_counting_allocator Counting Allocator
+   @ingroup zix_allocation
+   @{
+*/
+
+/// Number of size classes in allocation statistics
+#define ZIX_ALLOCATION_N_CLASSES 32U
+
+/**
+   Statistics about the allocations made with an allocator.
+
+   Size classes are powers of two, where class 0 counts allocations of up to 1
+   byte, and every later class `i` counts allocations larger than `2^(i-1)`
+   bytes and up to `2^i` bytes.  The last class counts all larger allocations.
+*/
+typedef struct {
+  uint64_t live_bytes;    ///< Total size of live allocations
+  uint64_t peak_bytes;    ///< Maximum total size of live allocations
+  uint64_t n_live;        ///< Number of live allocations
+  uint64_t n_allocations; ///< Total number of successful allocations
+  uint64_t n_failures;    ///< Total number of failed allocations
+
+  /// Total number of successful allocations in each size class
+  uint64_t class_counts[ZIX_ALLOCATION_N_CLASSES];
+} ZixAllocationStats;
+
+/**
+   Function called for a sampled allocation.
+
+   This is called synchronously within the allocation function, so it can
+   record the call stack to find where allocations are made, but must not use
+   the allocator it's sampling.
+
+   @param handle Opaque user data passed to zix_counting_allocator_sample().
+   @param ptr Pointer to the newly allocated memory.
+   @param size Size of the allocation in bytes.
+*/
+typedef void (*ZixAllocationSampleFunc)(void* ZIX_UNSPECIFIED   handle,
+                                        const void* ZIX_NONNULL ptr,
+                                        size_t                  size);
+
+/**
+   An allocator that forwards to a parent and counts allocations.
+
+   This is useful for measuring the memory used by some data structure, for
+   example by giving each ZixHash or ZixBTree in a program its own counting
+   allocator with a shared parent.  Counters are updated with relaxed atomic
+   operations, so the overhead is small enough to leave enabled in production.
+
+   Every allocation is prefixed with a small header that records its size, so
+   allocations made with a counting allocator must be freed with it, and not
+   directly with the parent.
+*/
+typedef struct ZixCountingAllocatorImpl ZixCountingAllocator;
+
+/**
+   Create a new counting allocator.
+
+   @param parent Allocator for the allocator itself, and all allocations.
+   @return A new allocator, or null if memory allocation failed.
+*/
+ZIX_API ZIX_NODISCARD ZixCountingAllocator* ZIX_ALLOCATED
+zix_counting_allocator_new(ZixAllocator* ZIX_NULLABLE parent);
+
+/**
+   Free a counting allocator.
+
+   Any allocations made with it must have been freed first.
+*/
+ZIX_API void
+zix_counting_allocator_free(ZixCountingAllocator* ZIX_NULLABLE allocator);
+
+/// Return the allocator interface of a counting allocator
+ZIX_PURE_API ZixAllocator* ZIX_NONNULL
+zix_counting_allocator_base(ZixCountingAllocator* ZIX_NONNULL allocator);
+
+/**
+   Return the current statistics of a counting allocator.
+
+   Each counter is read atomically, but if allocations are being made
+   concurrently, the counters may be slightly inconsistent with each other.
+*/
+ZIX_API ZixAllocationStats
+zix_counting_allocator_stats(const ZixCountingAllocator* ZIX_NONNULL allocator);
+
+/**
+   Enable sampling of allocations.
+
+   Once enabled, the sample function is called for about one allocation in
+   every `interval` bytes allocated, so larger allocations are more likely to
+   be sampled.  This must not be called while the allocator is in use by
+   another thread.
+
+   @param allocator Allocator to sample.
+   @param interval Average number of allocated bytes between samples, or zero
+   to disable sampling.
+   @param func Function to call for each sample.
+   @param handle Pointer passed to the function.
+*/
+ZIX_API void
+zix_counting_allocator_sample(ZixCountingAllocator* ZIX_NONNULL    allocator,
+                              uint64_t                             interval,
+                              ZixAllocationSampleFunc ZIX_NULLABLE func,
+                              void* ZIX_UNSPECIFIED                handle);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_COUNTING_ALLOCATOR_H
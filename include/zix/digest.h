@@ -5,6 +5,7 @@
 #define ZIX_DIGEST_H
 
 #include <zix/attributes.h>
+#include <zix/status.h>
 
 #include <stddef.h>
 #include <stdint.h>
@@ -58,6 +59,41 @@ zix_digest64(uint64_t seed, const void* ZIX_NONNULL buf, size_t len);
 ZIX_PURE_API ZIX_NONBLOCKING uint64_t
 zix_digest64_aligned(uint64_t seed, const void* ZIX_NONNULL buf, size_t len);
 
+/**
+   Return a 64-bit hash of a large buffer.
+
+   This is a variant of zix_digest64() that's faster for large inputs.  It
+   splits the data into 4 interleaved lanes which are hashed independently,
+   so the processor can work on them in parallel, then combines the results.
+
+   For inputs shorter than 256 bytes, this returns the same result as
+   zix_digest64().  For longer inputs, the result is different, so the same
+   function must be used consistently for the same data.
+
+   This can be used for any size or alignment.
+*/
+ZIX_PURE_API ZIX_NONBLOCKING uint64_t
+zix_digest64_wide(uint64_t seed, const void* ZIX_NONNULL buf, size_t len);
+
+/**
+   Return the 64-bit hashes of many buffers.
+
+   This is equivalent to calling zix_digest64() on each buffer, but faster for
+   many short keys, since the hashes of several keys are computed in parallel.
+
+   @param seed The seed used for every hash.
+   @param bufs Array of `n` pointers to the start of each buffer.
+   @param lens Array of `n` buffer lengths in bytes.
+   @param n The number of buffers to hash.
+   @param[out] out Array of `n` hashes, set to the hash of each buffer.
+*/
+ZIX_API ZIX_NONBLOCKING void
+zix_digest64_batch(uint64_t                                   seed,
+                   const void* ZIX_NONNULL const* ZIX_NONNULL bufs,
+                   const size_t* ZIX_NONNULL                  lens,
+                   size_t                                     n,
+                   uint64_t* ZIX_NONNULL                      out);
+
 /**
    Return a pointer-sized hash of a buffer.
 
@@ -82,6 +118,166 @@ zix_digest(size_t seed, const void* ZIX_NONNULL buf, size_t len);
 ZIX_PURE_API ZIX_NONBLOCKING size_t
 zix_digest_aligned(size_t seed, const void* ZIX_NONNULL buf, size_t len);
 
+/**
+   The state of an incremental 32-bit hash.
+
+   This allows data to be hashed in several pieces, with the same result as
+   calling zix_digest32() on all of the data at once.  The contents of this
+   structure are an implementation detail and must not be manipulated by the
+   user.
+*/
+typedef struct {
+  uint32_t h;        ///< Hash of all complete blocks so far
+  uint8_t  block[4]; ///< Data of an incomplete block
+  size_t   len;      ///< Total number of bytes added so far
+} ZixDigest32State;
+
+/**
+   The state of an incremental 64-bit hash.
+
+   This allows data to be hashed in several pieces, with the same result as
+   calling zix_digest64() on all of the data at once.  The contents of this
+   structure are an implementation detail and must not be manipulated by the
+   user.
+*/
+typedef struct {
+  uint64_t h;        ///< Hash of all complete blocks so far
+  uint8_t  block[8]; ///< Data of an incomplete block
+  size_t   len;      ///< Total number of bytes added so far
+  size_t   total;    ///< Total number of bytes declared at initialization
+} ZixDigest64State;
+
+/// The state of an incremental pointer-sized hash
+#if UINTPTR_MAX >= UINT64_MAX
+typedef ZixDigest64State ZixDigestState;
+#else
+typedef ZixDigest32State ZixDigestState;
+#endif
+
+/**
+   Begin an incremental 32-bit hash.
+
+   @param state The hash state to initialize.
+   @param seed The seed, as would be passed to zix_digest32().
+*/
+ZIX_API ZIX_REALTIME void
+zix_digest32_init(ZixDigest32State* ZIX_NONNULL state, uint32_t seed);
+
+/**
+   Add data to an incremental 32-bit hash.
+
+   This can be called any number of times, with any size or alignment.
+*/
+ZIX_API ZIX_NONBLOCKING void
+zix_digest32_update(ZixDigest32State* ZIX_NONNULL state,
+                    const void* ZIX_NONNULL       buf,
+                    size_t                        len);
+
+/**
+   Return the 32-bit hash of all the data added to an incremental hash.
+
+   The result is the same as zix_digest32() with the same seed and the
+   concatenation of all data passed to zix_digest32_update().
+*/
+ZIX_PURE_API ZIX_REALTIME uint32_t
+zix_digest32_final(const ZixDigest32State* ZIX_NONNULL state);
+
+/**
+   Begin an incremental 64-bit hash.
+
+   Unlike the 32-bit hash, the 64-bit hash mixes the total length into its
+   initial state, so the total length of the data must be known in advance.
+   To hash a stream of unknown length, use the 32-bit hash instead.
+
+   @param state The hash state to initialize.
+   @param seed The seed, as would be passed to zix_digest64().
+   @param len The total length of the data that will be added, which must be
+   exactly the number of bytes passed to zix_digest64_update().
+*/
+ZIX_API ZIX_REALTIME void
+zix_digest64_init(ZixDigest64State* ZIX_NONNULL state,
+                  uint64_t                      seed,
+                  size_t                        len);
+
+/**
+   Add data to an incremental 64-bit hash.
+
+   This can be called any number of times, with any size or alignment.
+*/
+ZIX_API ZIX_NONBLOCKING void
+zix_digest64_update(ZixDigest64State* ZIX_NONNULL state,
+                    const void* ZIX_NONNULL       buf,
+                    size_t                        len);
+
+/**
+   Return the 64-bit hash of all the data added to an incremental hash.
+
+   The result is the same as zix_digest64() with the same seed and the
+   concatenation of all data passed to zix_digest64_update().  The total
+   length of the data must match the length passed to zix_digest64_init(),
+   which is checked by an assertion.
+*/
+ZIX_PURE_API ZIX_REALTIME uint64_t
+zix_digest64_final(const ZixDigest64State* ZIX_NONNULL state);
+
+/**
+   Begin an incremental pointer-sized hash.
+
+   Internally, this simply dispatches to zix_digest32_init() or
+   zix_digest64_init() as appropriate, so the total length of the data must be
+   known in advance to get the same result as zix_digest().
+*/
+ZIX_API ZIX_REALTIME void
+zix_digest_init(ZixDigestState* ZIX_NONNULL state, size_t seed, size_t len);
+
+/// Add data to an incremental pointer-sized hash
+ZIX_API ZIX_NONBLOCKING void
+zix_digest_update(ZixDigestState* ZIX_NONNULL state,
+                  const void* ZIX_NONNULL     buf,
+                  size_t                      len);
+
+/// Return the pointer-sized hash of all the data added to an incremental hash
+ZIX_PURE_API ZIX_REALTIME size_t
+zix_digest_final(const ZixDigestState* ZIX_NONNULL state);
+
+/**
+   A secret 128-bit key for a keyed hash.
+
+   The key should be random and kept private, so that it's impractical for an
+   attacker to find inputs that collide.
+*/
+typedef struct {
+  uint64_t k0; ///< First 64 bits of key
+  uint64_t k1; ///< Last 64 bits of key
+} ZixDigestKey;
+
+/**
+   Set a key to random bytes from the system.
+
+   @return #ZIX_STATUS_SUCCESS, or an error if the system random number
+   generator failed, in which case `key` is unchanged.
+*/
+ZIX_API ZixStatus
+zix_digest_random_key(ZixDigestKey* ZIX_NONNULL key);
+
+/**
+   Return a 64-bit keyed hash of a buffer.
+
+   This is SipHash-2-4, which is much slower than the other digest functions,
+   but is designed so that collisions can't be predicted without knowing the
+   key.  It should be used, with a random key, for hash tables with keys that
+   are chosen by an untrusted party, to prevent denial of service attacks that
+   make most lookups collide.
+
+   Unlike the other digest functions, the result is the same on all platforms.
+
+   This can be used for any size or alignment.
+*/
+ZIX_PURE_API ZIX_NONBLOCKING uint64_t
+zix_digest64_keyed(const ZixDigestKey* ZIX_NONNULL key,
+                   const void* ZIX_NONNULL         buf,
+                   size_t                          len);
+
 /**
    @}
 */
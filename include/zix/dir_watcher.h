@@ -0,0 +1,171 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_DIR_WATCHER_H
+#define ZIX_DIR_WATCHER_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/ring.h>
+#include <zix/status.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_dir_watcher Directory Watcher
+   @ingroup zix_file_system
+   @{
+*/
+
+/**
+   A watcher for changes to the files in a directory.
+
+   A watcher reports changes to the entries of a single directory, but not to
+   the contents of its subdirectories.  On Linux, changes are reported by the
+   system with inotify, so checking for events is cheap and they are available
+   immediately.  Elsewhere, or if #ZIX_DIR_WATCH_POLL is given, the directory
+   is rescanned every time events are read, and changes are found by comparing
+   the status of every file with the previous scan.
+
+   Events are read in batches, either by calling a function or by writing them
+   to a ring.  Several changes to a file may be reported as a single event,
+   and a rename may be reported as a deletion and a creation, for example if
+   the file is moved in or out of the directory.
+*/
+typedef struct ZixDirWatcherImpl ZixDirWatcher;
+
+/// Options for watching a directory
+typedef enum {
+  ZIX_DIR_WATCH_POLL = 1U << 0U, ///< Poll even if the system can notify
+} ZixDirWatchOption;
+
+/// Bitwise OR of #ZixDirWatchOption values
+typedef uint32_t ZixDirWatchOptions;
+
+/// The kind of change to a file in a watched directory
+typedef enum {
+  ZIX_DIR_EVENT_CREATED,  ///< File was created or moved into the directory
+  ZIX_DIR_EVENT_MODIFIED, ///< File contents or metadata were modified
+  ZIX_DIR_EVENT_DELETED,  ///< File was deleted or moved out of the directory
+  ZIX_DIR_EVENT_RENAMED,  ///< File was renamed within the directory
+} ZixDirEventType;
+
+/// A change to a file in a watched directory
+typedef struct {
+  ZixDirEventType          type;     ///< Kind of change
+  const char* ZIX_NONNULL  name;     ///< Name of the file in the directory
+  const char* ZIX_NULLABLE old_name; ///< Previous name if renamed, or null
+} ZixDirEvent;
+
+/**
+   The header of an event written to a ring.
+
+   Each event is written as a single record that starts with this header,
+   followed by the name, then the old name if there is one, each with a null
+   terminator.
+*/
+typedef struct {
+  uint32_t type;          ///< Kind of change, a #ZixDirEventType
+  uint32_t name_size;     ///< Size of the name, including the terminator
+  uint32_t old_name_size; ///< Size of the old name, or zero if there is none
+} ZixDirEventHeader;
+
+/**
+   Function called with a batch of events.
+
+   @param data Opaque user data passed to zix_dir_watcher_read().
+   @param n_events Number of events in the batch, which is at least one.
+   @param events Array of events, which are only valid during the call.
+*/
+typedef void (*ZixDirEventsFunc)(void* ZIX_UNSPECIFIED         data,
+                                 size_t                        n_events,
+                                 const ZixDirEvent* ZIX_NONNULL events);
+
+/**
+   Start watching a directory.
+
+   Changes are reported relative to the state of the directory when this is
+   called, so no events are reported for files that already exist.
+
+   @param allocator Allocator for the watcher and its internal buffers.
+   @param path Path to the directory to watch.
+   @param options Options to control how the directory is watched.
+   @return A new watcher, or null if the directory couldn't be watched.
+*/
+ZIX_API ZIX_NODISCARD ZixDirWatcher* ZIX_ALLOCATED
+zix_dir_watcher_new(ZixAllocator* ZIX_NULLABLE allocator,
+                    const char* ZIX_NONNULL    path,
+                    ZixDirWatchOptions         options);
+
+/// Stop watching a directory and free the watcher
+ZIX_API void
+zix_dir_watcher_free(ZixDirWatcher* ZIX_NULLABLE watcher);
+
+/**
+   Wait until events may be available to read.
+
+   When the system notifies changes, this returns as soon as there are events
+   to read.  Otherwise, it simply sleeps for the timeout, so the timeout is the
+   interval between scans of the directory.
+
+   @param watcher The directory watcher.
+   @param seconds Maximum number of whole seconds to wait.
+   @param nanoseconds Maximum number of additional nanoseconds to wait.
+
+   @return #ZIX_STATUS_SUCCESS if events may be available,
+   #ZIX_STATUS_TIMEOUT if there are none, or an error.
+*/
+ZIX_API ZixStatus
+zix_dir_watcher_wait(ZixDirWatcher* ZIX_NONNULL watcher,
+                     uint32_t                   seconds,
+                     uint32_t                   nanoseconds);
+
+/**
+   Read all available events without blocking.
+
+   The function is called once with every event that's available, or not at
+   all if there are none.
+
+   @param watcher The directory watcher.
+   @param f Function called with the batch of events.
+   @param data Opaque user data that is passed to `f`.
+
+   @return #ZIX_STATUS_SUCCESS, #ZIX_STATUS_OVERFLOW if some events were lost
+   and the directory should be rescanned, #ZIX_STATUS_NOT_FOUND if the
+   directory itself was removed, or an error.
+*/
+ZIX_API ZixStatus
+zix_dir_watcher_read(ZixDirWatcher* ZIX_NONNULL   watcher,
+                     ZixDirEventsFunc ZIX_NONNULL f,
+                     void* ZIX_UNSPECIFIED        data);
+
+/**
+   Read all available events without blocking, and write them to a ring.
+
+   This is useful for passing events to another thread.  Each event is written
+   as a record that starts with a #ZixDirEventHeader.  If the ring becomes
+   full, then the remaining events are kept, and written first the next time
+   this or zix_dir_watcher_read() is called.  An event that's larger than the
+   capacity of the ring is discarded, and reported as an overflow.
+
+   @param watcher The directory watcher.
+   @param ring Ring to write events to.
+
+   @return #ZIX_STATUS_NO_MEM if the ring is full and some events are still
+   pending, otherwise the same as zix_dir_watcher_read(), where the status is
+   returned once every event that was read along with it has been written.
+*/
+ZIX_API ZixStatus
+zix_dir_watcher_read_ring(ZixDirWatcher* ZIX_NONNULL watcher,
+                          ZixRing* ZIX_NONNULL       ring);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_DIR_WATCHER_H
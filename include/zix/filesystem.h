@@ -29,10 +29,19 @@ ZIX_BEGIN_DECLS
    @{
 */
 
-/// Options to control filesystem copy operations
+/**
+   Options to control filesystem copy operations.
+
+   By default, copying a file waits until its data has been written to
+   storage.  The sync options can be used to change this, for example to copy
+   many files without syncing, then sync them all at once with
+   zix_sync_files().
+*/
 typedef enum {
   ZIX_COPY_OPTION_NONE               = 0U,       ///< Report any error
   ZIX_COPY_OPTION_OVERWRITE_EXISTING = 1U << 0U, ///< Replace existing file
+  ZIX_COPY_OPTION_NO_SYNC            = 1U << 1U, ///< Don't wait for storage
+  ZIX_COPY_OPTION_FULL_SYNC          = 1U << 2U, ///< Sync metadata and caches
 } ZixCopyOption;
 
 /// Bitwise OR of ZixCopyOptions values
@@ -57,6 +66,64 @@ zix_copy_file(ZixAllocator* ZIX_NULLABLE allocator,
               const char* ZIX_NONNULL    dst,
               ZixCopyOptions             options);
 
+/**
+   Copy the directory tree at path `src` to path `dst`.
+
+   This recreates every directory in `src` with the same permissions using
+   zix_create_directory_like(), then copies every regular file with
+   zix_copy_file() using several threads.  Copying many small files is
+   dominated by per-file system call latency, so doing several at once can be
+   much faster, particularly on network or solid-state storage.
+
+   Symbolic links aren't followed, but recreated with the same target, so
+   relative links within the tree point to the copied files.  Other kinds of
+   files are skipped.  Copying links isn't supported on Windows.
+
+   Files are copied without syncing, then all synced together at the end,
+   followed by every destination directory, unless #ZIX_COPY_OPTION_NO_SYNC is
+   given.  If reading a directory or copying any file fails, no further copies
+   are started, and the first error is returned.  Files and directories that
+   were already created are left in place.
+
+   @param allocator Allocator used for paths and copy buffers, which must be
+   thread-safe if `n_threads` is greater than 1.
+   @param src Path to source directory to copy.
+   @param dst Path to destination directory to create.
+   @param options Options to control the kind of copy and error conditions.
+   If #ZIX_COPY_OPTION_OVERWRITE_EXISTING is given, then `dst` and any
+   directories within it may already exist, and existing files are replaced.
+   @param n_threads Number of threads to copy files with, including the calling
+   thread.  If threads aren't supported, all files are copied by the calling
+   thread.
+   @return #ZIX_STATUS_SUCCESS if the tree was successfully copied, or an
+   error.
+*/
+ZIX_API ZixStatus
+zix_copy_tree(ZixAllocator* ZIX_NULLABLE allocator,
+              const char* ZIX_NONNULL    src,
+              const char* ZIX_NONNULL    dst,
+              ZixCopyOptions             options,
+              unsigned                   n_threads);
+
+/**
+   Wait until files have been written to storage.
+
+   This makes the contents of many files durable at once, which is much faster
+   than syncing each file as it's written, since the system can write them all
+   back concurrently.  A path may also be a directory, which makes the
+   creation, removal, or renaming of entries in that directory durable.
+
+   @param n_paths Number of elements in `paths`.
+   @param paths Array of paths to files or directories to sync.
+   @param options Copy options, where only #ZIX_COPY_OPTION_FULL_SYNC is used
+   to also sync all metadata and flush drive caches, as zix_copy_file() does.
+   @return #ZIX_STATUS_SUCCESS if every file was synced, or the first error.
+*/
+ZIX_API ZixStatus
+zix_sync_files(size_t                                     n_paths,
+               const char* ZIX_NONNULL const* ZIX_NONNULL paths,
+               ZixCopyOptions                             options);
+
 /**
    Create the directory `dir_path` with all available permissions.
 
@@ -147,6 +214,28 @@ zix_create_temporary_directory(ZixAllocator* ZIX_NULLABLE allocator,
 ZIX_API ZixStatus
 zix_remove(const char* ZIX_NONNULL path);
 
+/**
+   Remove the file or directory at `path`, and everything in it.
+
+   Symbolic links are removed, but not followed, so nothing outside of the
+   tree is removed.
+
+   @param allocator Allocator used for paths and internal state.
+
+   @param path Path to the file or directory to remove.
+
+   @param n_threads Number of threads (including the calling thread) to use.
+   If this is greater than one, then subdirectories are removed in parallel.
+   This may be ignored if threads aren't supported.
+
+   @return #ZIX_STATUS_SUCCESS, or an error if anything couldn't be removed,
+   in which case some files may remain.
+*/
+ZIX_API ZixStatus
+zix_remove_all(ZixAllocator* ZIX_NULLABLE allocator,
+               const char* ZIX_NONNULL    path,
+               unsigned                   n_threads);
+
 /**
    @}
    @defgroup zix_fs_access Access
@@ -183,6 +272,16 @@ zix_dir_for_each(const char* ZIX_NONNULL          path,
 /**
    Return whether the given paths point to files with identical contents.
 
+   Large files are compared by mapping them into memory if possible, which
+   avoids copying their contents, otherwise the files are read and compared a
+   block at a time.  In either case, this returns as soon as a difference is
+   found.
+
+   Since large files may be mapped, neither file may be truncated while they
+   are being compared.  On POSIX systems, accessing the part of a mapping past
+   the new end of a truncated file raises `SIGBUS`, which terminates the
+   process by default.
+
    @param allocator Allocator used for a memory block for comparison if
    necessary.
 
@@ -197,6 +296,49 @@ zix_file_equals(ZixAllocator* ZIX_NULLABLE allocator,
                 const char* ZIX_NONNULL    a_path,
                 const char* ZIX_NONNULL    b_path);
 
+/// A kind of whole file transfer
+typedef enum {
+  ZIX_FILE_TRANSFER_READ,  ///< Read the start of a file into a buffer
+  ZIX_FILE_TRANSFER_WRITE, ///< Create or replace a file with a buffer
+} ZixFileTransferType;
+
+/**
+   A request to read or write a file, as part of a batch.
+
+   The first four fields are set by the caller, and the last two are set by
+   zix_transfer_files().
+*/
+typedef struct {
+  ZixFileTransferType     type;    ///< Kind of transfer
+  const char* ZIX_NONNULL path;    ///< Path to file
+  void* ZIX_NONNULL       buffer;  ///< Buffer to read into or write from
+  size_t                  size;    ///< Size of buffer in bytes
+  size_t                  n_bytes; ///< Number of bytes transferred
+  ZixStatus               status;  ///< Status of this transfer
+} ZixFileTransfer;
+
+/**
+   Read or write many files at once.
+
+   A read transfer reads a file from the start until either the end of the
+   file or the end of the buffer is reached.  A write transfer creates a file,
+   or truncates an existing one, and writes the entire buffer to it.
+
+   On systems that support it (Linux with io_uring), the system calls for
+   many transfers are submitted together, which avoids most of the overhead of
+   making them one at a time.  Otherwise, transfers are simply made in order.
+   Either way, the order that transfers are made in is unspecified, so a batch
+   shouldn't access the same file more than once.
+
+   @param n_transfers Number of elements in `transfers`.
+   @param transfers Array of transfers, where each is updated with its result.
+   @return #ZIX_STATUS_SUCCESS if every transfer succeeded, or the status of
+   the first that failed.
+*/
+ZIX_API ZixStatus
+zix_transfer_files(size_t                       n_transfers,
+                   ZixFileTransfer* ZIX_NONNULL transfers);
+
 /**
    @}
    @defgroup zix_fs_resolution Resolution
@@ -265,6 +407,75 @@ zix_file_lock(FILE* ZIX_NONNULL file, ZixFileLockMode mode);
 ZIX_API ZixStatus
 zix_file_unlock(FILE* ZIX_NONNULL file, ZixFileLockMode mode);
 
+/**
+   @}
+   @defgroup zix_fs_mapping Mapping
+   @{
+*/
+
+/// A mode for mapping files into memory
+typedef enum {
+  ZIX_FILE_MAP_READ,       ///< Map for reading only
+  ZIX_FILE_MAP_READ_WRITE, ///< Map for reading and writing back to the file
+} ZixFileMapMode;
+
+/// Hints about how a mapped file will be accessed
+typedef enum {
+  ZIX_FILE_MAP_HINT_NONE       = 0U,       ///< No particular pattern
+  ZIX_FILE_MAP_HINT_SEQUENTIAL = 1U << 0U, ///< Read ahead aggressively
+  ZIX_FILE_MAP_HINT_RANDOM     = 1U << 1U, ///< Don't read ahead
+  ZIX_FILE_MAP_HINT_WILL_NEED  = 1U << 2U, ///< Start reading everything now
+  ZIX_FILE_MAP_HINT_HUGE       = 1U << 3U, ///< Use huge pages if possible
+} ZixFileMapHint;
+
+/// Bitwise OR of ZixFileMapHint values
+typedef uint32_t ZixFileMapHints;
+
+/// The contents of a file mapped into memory
+typedef struct {
+  void* ZIX_NULLABLE data; ///< Start of file contents, or null if empty
+  size_t             size; ///< Size of file contents in bytes
+} ZixFileView;
+
+/**
+   Map the contents of a file into memory.
+
+   This allows a file to be accessed like an array in memory, without copying
+   it into a buffer first.  Pages are loaded lazily when they're first
+   accessed, and shared with the system's page cache, so mapping large files
+   that are only partially used, or used by several processes, can be much
+   faster than reading them.
+
+   The size of the mapping is the size of the file when it was mapped, so the
+   file must not be truncated while it's mapped.  An empty file is
+   successfully mapped to a view with a null pointer and a size of zero.
+
+   @param allocator Allocator used for temporary data if necessary.
+   @param path Path to the file to map.
+   @param mode Whether the mapping is read-only or can be written to.
+   @param hints Hints about how the contents will be accessed, which are
+   ignored if they aren't supported.
+   @param[out] view Set to the mapped file contents on success.
+   @return #ZIX_STATUS_SUCCESS, #ZIX_STATUS_NOT_SUPPORTED if mapping files
+   isn't supported on this system, or an error.
+*/
+ZIX_API ZixStatus
+zix_file_map(ZixAllocator* ZIX_NULLABLE allocator,
+             const char* ZIX_NONNULL    path,
+             ZixFileMapMode             mode,
+             ZixFileMapHints            hints,
+             ZixFileView* ZIX_NONNULL   view);
+
+/**
+   Unmap a file that was mapped with zix_file_map().
+
+   Any changes to a read-write view are written back to the file eventually,
+   but not synchronously, so zix_sync_files() can be used to make them
+   durable.  The view is reset to empty.
+*/
+ZIX_API ZixStatus
+zix_file_unmap(ZixFileView* ZIX_NONNULL view);
+
 /**
    @}
    @defgroup zix_fs_queries Queries
@@ -327,6 +538,136 @@ zix_symlink_type(const char* ZIX_NONNULL path);
 ZIX_API ZixFileOffset
 zix_file_size(const char* ZIX_NONNULL path);
 
+/**
+   Status information about a file.
+
+   Fields that the system doesn't provide are zero.
+*/
+typedef struct {
+  ZixFileType   type;     ///< Type of file
+  ZixFileOffset size;     ///< Size in bytes
+  int64_t       modified; ///< Modification time in nanoseconds since 1970
+  uint64_t      inode;    ///< File serial number, unique on a device
+  uint64_t      device;   ///< ID of device containing the file
+} ZixFileStatus;
+
+/**
+   Get the status of a file, resolving symlinks.
+
+   This gets all the information in a #ZixFileStatus with a single query, so
+   it's faster than calling several functions like zix_file_type() and
+   zix_file_size() for the same file.
+
+   @param path Path to the file.
+
+   @param status Set to the status of the file, or to zero with type
+   #ZIX_FILE_TYPE_NONE on error.
+
+   @return #ZIX_STATUS_SUCCESS, or an error like #ZIX_STATUS_NOT_FOUND.
+*/
+ZIX_API ZixStatus
+zix_file_status(const char* ZIX_NONNULL    path,
+                ZixFileStatus* ZIX_NONNULL status);
+
+/**
+   Get the status of many files, resolving symlinks.
+
+   This is equivalent to calling zix_file_status() for every path, and
+   reports the first error as well as the status of every file.
+
+   @param n_paths Number of paths and statuses.
+
+   @param paths Array of paths to files.
+
+   @param statuses Array of statuses set to the status of every file, where
+   files that couldn't be queried have type #ZIX_FILE_TYPE_NONE.
+
+   @return #ZIX_STATUS_SUCCESS if every file was queried, otherwise the error
+   for the first file that couldn't be.
+*/
+ZIX_API ZixStatus
+zix_file_status_many(size_t                                     n_paths,
+                     const char* ZIX_NONNULL const* ZIX_NONNULL paths,
+                     ZixFileStatus* ZIX_NONNULL                 statuses);
+
+/**
+   @}
+   @defgroup zix_fs_traversal Traversal
+   @{
+*/
+
+/// Options for walking a directory tree
+typedef enum {
+  ZIX_DIR_WALK_POST_ORDER = 1U << 0U, ///< Visit directories after contents
+  ZIX_DIR_WALK_STATUS     = 1U << 1U, ///< Get the full status of every file
+} ZixDirWalkOption;
+
+/// Bitwise OR of #ZixDirWalkOption values
+typedef uint32_t ZixDirWalkOptions;
+
+/// A file visited while walking a directory tree
+typedef struct {
+  const char* ZIX_NONNULL path; ///< Path to file, starting with the root path
+  const char* ZIX_NONNULL name; ///< Name of file, the end of `path`
+
+  /// File status if #ZIX_DIR_WALK_STATUS is given, otherwise null
+  const ZixFileStatus* ZIX_NULLABLE status;
+
+  ZixFileType type;  ///< Type of file, where symlinks aren't followed
+  unsigned    depth; ///< Depth in the tree, where root entries have depth 1
+} ZixDirWalkEntry;
+
+/**
+   Function called for every file while walking a directory tree.
+
+   @param data Opaque user data passed to zix_dir_walk().
+   @param entry The file being visited, which is only valid during the call.
+   @return #ZIX_STATUS_SUCCESS to continue, or an error to stop the walk.
+*/
+typedef ZixStatus (*ZixDirWalkFunc)(void* ZIX_UNSPECIFIED             data,
+                                    const ZixDirWalkEntry* ZIX_NONNULL entry);
+
+/**
+   Visit every file in a directory tree.
+
+   This is similar to calling zix_dir_for_each() recursively, but much faster
+   for large trees.  Where possible, directories are opened relative to their
+   parent, and the file type is taken from the directory entry, so files are
+   only individually queried if #ZIX_DIR_WALK_STATUS is given.  Symbolic links
+   are visited, but not followed.
+
+   By default, directories are visited before their contents.  The root itself
+   isn't visited, and the order of files within a directory is unspecified.
+
+   @param allocator Allocator used for paths and internal state.
+
+   @param path Path to the root directory.
+
+   @param options Bitwise OR of #ZixDirWalkOption flags.
+
+   @param n_threads Number of threads (including the calling thread) to use.
+   If this is greater than one, then subdirectories are walked in parallel,
+   and `f` may be called concurrently from several threads.  The tree is split
+   into jobs by walking the top levels first, until there are several
+   subdirectories per thread or the subdirectories are 8 levels deep, so
+   deeper directories are always walked by a single thread.  This may be
+   ignored if threads aren't supported.
+
+   @param f Function called for every file in the tree.
+
+   @param data Opaque user data that is passed to `f`.
+
+   @return #ZIX_STATUS_SUCCESS, the error returned by `f` if it stopped the
+   walk, or an error if a directory couldn't be read.
+*/
+ZIX_API ZixStatus
+zix_dir_walk(ZixAllocator* ZIX_NULLABLE allocator,
+             const char* ZIX_NONNULL    path,
+             ZixDirWalkOptions          options,
+             unsigned                   n_threads,
+             ZixDirWalkFunc ZIX_NONNULL f,
+             void* ZIX_UNSPECIFIED      data);
+
 /**
    @}
    @defgroup zix_fs_environment Environment
@@ -6,6 +6,7 @@
 
 #include <zix/allocator.h>
 #include <zix/attributes.h>
+#include <zix/digest.h>
 #include <zix/status.h>
 
 #include <stdbool.h>
@@ -84,6 +85,10 @@ typedef const ZixHashKey* ZIX_NONNULL (*ZixKeyFunc)(
 /// User function for computing the hash of a key
 typedef ZixHashCode (*ZixHashFunc)(const ZixHashKey* ZIX_NONNULL key);
 
+/// User function for computing the hash of a key with a secret seed
+typedef ZixHashCode (*ZixKeyedHashFunc)(const ZixHashKey* ZIX_NONNULL   key,
+                                        const ZixDigestKey* ZIX_NONNULL seed);
+
 /// User function for determining if two keys are truly equal
 typedef bool (*ZixKeyEqualFunc)(const ZixHashKey* ZIX_NONNULL a,
                                 const ZixHashKey* ZIX_NONNULL b);
@@ -108,6 +113,30 @@ zix_hash_new(ZixAllocator* ZIX_NULLABLE  allocator,
              ZixHashFunc ZIX_NONNULL     hash_func,
              ZixKeyEqualFunc ZIX_NONNULL equal_func);
 
+/**
+   Create a new hash table that resists collision attacks.
+
+   This is like zix_hash_new(), but the hash function is given a secret seed,
+   which is initially random.  If a record is ever inserted abnormally far from
+   its ideal position, which can happen if an attacker has found many keys that
+   collide, then the table is automatically rehashed with a new random seed.
+
+   For this to be effective, the hash function must be a keyed hash which
+   makes collisions unpredictable without the seed, like zix_digest64_keyed().
+
+   @param allocator Allocator used for the internal array.
+   @param key_func A function to retrieve the key from a record.
+   @param hash_func The keyed hashing function.
+   @param equal_func A function to test keys for equality.
+   @return A new hash table, or null if memory allocation or random seed
+   generation failed.
+*/
+ZIX_API ZIX_NODISCARD ZixHash* ZIX_ALLOCATED
+zix_hash_new_keyed(ZixAllocator* ZIX_NULLABLE   allocator,
+                   ZixKeyFunc ZIX_NONNULL       key_func,
+                   ZixKeyedHashFunc ZIX_NONNULL hash_func,
+                   ZixKeyEqualFunc ZIX_NONNULL  equal_func);
+
 /// Free `hash`
 ZIX_API void
 zix_hash_free(ZixHash* ZIX_NULLABLE hash);
@@ -116,6 +145,19 @@ zix_hash_free(ZixHash* ZIX_NULLABLE hash);
 ZIX_PURE_API ZIX_REALTIME size_t
 zix_hash_size(const ZixHash* ZIX_NONNULL hash);
 
+/**
+   Return the current seed of a keyed hash table.
+
+   This is only needed to calculate hash codes for
+   zix_hash_plan_insert_prehashed().  The seed may change whenever the table is
+   modified.
+
+   @return The seed passed to the hash function, or null if the table was not
+   created with zix_hash_new_keyed().
+*/
+ZIX_PURE_API ZIX_REALTIME const ZixDigestKey* ZIX_NULLABLE
+zix_hash_seed(const ZixHash* ZIX_NONNULL hash);
+
 /**
    @}
    @defgroup zix_hash_iteration Iteration
@@ -202,8 +244,9 @@ zix_hash_plan_insert(const ZixHash* ZIX_NONNULL    hash,
 
    Note that care must be taken when using this function: improper use can
    corrupt the hash table.  The hash code given must be correct for the key to
-   be inserted, and the predicate must return true only if the key it is called
-   with (the first argument) matches the key to be inserted.
+   be inserted (using the current zix_hash_seed() for keyed tables), and the
+   predicate must return true only if the key it is called with (the first
+   argument) matches the key to be inserted.
 */
 ZIX_API ZixHashInsertPlan
 zix_hash_plan_insert_prehashed(const ZixHash* ZIX_NONNULL            hash,
@@ -0,0 +1,224 @@
+// Copyright 2011-2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_MPMC_RING_H
+#define ZIX_MPMC_RING_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/status.h>
+
+#include <stdint.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_mpmc_ring Multi-Producer Multi-Consumer Ring
+   @ingroup zix_data_structures
+   @{
+*/
+
+/**
+   @defgroup zix_mpmc_ring_types Types
+   @{
+*/
+
+/**
+   A ring buffer of variable-length records for any number of threads.
+
+   Unlike #ZixRing, which is a stream of bytes for a single reader and a single
+   writer, this ring stores discrete records and may be used by any number of
+   concurrent readers and writers.  Each record is written in a single
+   transaction and read in its entirety by exactly one reader.
+
+   Writers reserve space by atomically advancing a shared cursor, then commit
+   in the order that space was reserved, so a commit waits until any earlier
+   writers have committed.  Readers claim and release records in the same way.
+   Reserving and claiming never block, but committing and reading do: if a
+   thread is preempted in the middle of a write or read, then every later
+   writer or reader spins (and eventually yields) until it finishes.  The ring
+   is therefore not lock-free, and is best suited to threads that run at
+   similar priorities and hold few records in flight at once.
+*/
+typedef struct ZixMpmcRingImpl ZixMpmcRing;
+
+/**
+   A transaction for writing a record in multiple parts.
+
+   The contents of this structure are an implementation detail and must not be
+   manipulated by the user.
+*/
+typedef struct {
+  uint32_t begin;  ///< Position of the record header
+  uint32_t cursor; ///< Position to write the next amended data to
+  uint32_t end;    ///< Position one past the end of the record
+} ZixMpmcRingTransaction;
+
+/**
+   @}
+   @defgroup zix_mpmc_ring_setup Setup
+   @{
+*/
+
+/**
+   Create a new multi-producer multi-consumer ring.
+
+   @param allocator Allocator for the ring object and its array.
+
+   @param size Minimum size of the ring array in bytes.  This must be between 8
+   and 2147483648 inclusive, and is rounded up to the next power of 2
+   internally.  Each record uses 4 bytes of space in addition to its contents.
+*/
+ZIX_API ZIX_NODISCARD ZixMpmcRing* ZIX_ALLOCATED
+zix_mpmc_ring_new(ZixAllocator* ZIX_NULLABLE allocator, uint32_t size);
+
+/**
+   Destroy a ring.
+
+   This frees the ring structure and its buffer, discarding its contents.
+*/
+ZIX_API void
+zix_mpmc_ring_free(ZixMpmcRing* ZIX_NULLABLE ring);
+
+/**
+   Lock the ring data into physical memory.
+
+   This function is NOT thread safe or real-time safe, but it should be called
+   after zix_mpmc_ring_new() to lock all ring memory to avoid page faults while
+   using the ring.
+*/
+ZIX_API ZixStatus
+zix_mpmc_ring_mlock(ZixMpmcRing* ZIX_NONNULL ring);
+
+/**
+   Reset (empty) a ring.
+
+   This function is NOT thread-safe, it may only be called when there are no
+   readers or writers.
+*/
+ZIX_API ZIX_REALTIME void
+zix_mpmc_ring_reset(ZixMpmcRing* ZIX_NONNULL ring);
+
+/**
+   Return the capacity, the size of the largest record that can be written.
+
+   This function returns a constant for any given ring, and may be called
+   anywhere.
+*/
+ZIX_PURE_API ZIX_REALTIME uint32_t
+zix_mpmc_ring_capacity(const ZixMpmcRing* ZIX_NONNULL ring);
+
+/**
+   @}
+   @defgroup zix_mpmc_ring_read Reading
+   Functions that may be called by any number of reader threads.
+   @{
+*/
+
+/**
+   Read the next record from the ring.
+
+   This may wait for earlier readers to finish reading their records.
+
+   @param ring The ring to read a record from.
+   @param dst The buffer to write the record to.
+   @param capacity The size of `dst` in bytes.
+   @param[out] size Set to the size of the record in bytes.
+
+   @return #ZIX_STATUS_SUCCESS if a record was read, #ZIX_STATUS_UNAVAILABLE if
+   the ring contains no records, or #ZIX_STATUS_NO_SPACE if the next record
+   is larger than `capacity` (in which case it remains in the ring and `size`
+   is set to its size).
+*/
+ZIX_API ZixStatus
+zix_mpmc_ring_read(ZixMpmcRing* ZIX_NONNULL ring,
+                   void* ZIX_NONNULL        dst,
+                   uint32_t                 capacity,
+                   uint32_t* ZIX_NONNULL    size);
+
+/**
+   @}
+   @defgroup zix_mpmc_ring_write Writing
+   Functions that may be called by any number of writer threads.
+   @{
+*/
+
+/**
+   Write a record to the ring.
+
+   @param ring The ring to write the record to.
+   @param src The buffer to read the record from.
+   @param size The size of the record in bytes, which must be at least 1.
+
+   @return The number of bytes written, which is either `size` on success, or
+   zero on failure.
+*/
+ZIX_API uint32_t
+zix_mpmc_ring_write(ZixMpmcRing* ZIX_NONNULL ring,
+                    const void* ZIX_NONNULL  src,
+                    uint32_t                 size);
+
+/**
+   Begin a write.
+
+   This reserves space for a record of exactly `size` bytes.  The record must
+   then be filled by calling zix_mpmc_ring_amend_write() one or more times,
+   and finished with zix_mpmc_ring_commit_write().
+
+   Once this function succeeds, the transaction MUST be committed, since later
+   records from other writers won't become readable until it is.  Like
+   #ZixRingTransaction, a transaction is not meant to be long-lived.
+
+   @param ring The ring to write data to.
+   @param size The total size of the record in bytes, which must be at least 1.
+   @param[out] tx Set to the new empty transaction.
+   @return #ZIX_STATUS_SUCCESS, #ZIX_STATUS_BAD_ARG if `size` is zero, or
+   #ZIX_STATUS_NO_MEM if there isn't enough space in the ring.
+*/
+ZIX_API ZIX_NONBLOCKING ZixStatus
+zix_mpmc_ring_begin_write(ZixMpmcRing* ZIX_NONNULL            ring,
+                          uint32_t                            size,
+                          ZixMpmcRingTransaction* ZIX_NONNULL tx);
+
+/**
+   Amend the current write with some data.
+
+   The data is written immediately after the previously amended data, as if
+   they were written contiguously with a single write call.  This data is not
+   visible to readers until zix_mpmc_ring_commit_write() is called.
+
+   @param ring The ring this transaction is writing to.
+   @param tx The active transaction, from zix_mpmc_ring_begin_write().
+   @param src Pointer to the data to write.
+   @param size Length of data to write in bytes.
+   @return #ZIX_STATUS_SUCCESS, or #ZIX_STATUS_NO_MEM if this would exceed the
+   size of the record given to zix_mpmc_ring_begin_write().
+*/
+ZIX_API ZIX_REALTIME ZixStatus
+zix_mpmc_ring_amend_write(ZixMpmcRing* ZIX_NONNULL            ring,
+                          ZixMpmcRingTransaction* ZIX_NONNULL tx,
+                          const void* ZIX_NONNULL             src,
+                          uint32_t                            size);
+
+/**
+   Commit the current write.
+
+   This waits until all previously begun transactions are committed, then
+   atomically publishes the record so that it may be read.
+
+   @param ring The ring this transaction is writing to.
+   @param tx The active transaction, from zix_mpmc_ring_begin_write().
+   @return #ZIX_STATUS_SUCCESS.
+*/
+ZIX_API ZixStatus
+zix_mpmc_ring_commit_write(ZixMpmcRing* ZIX_NONNULL                  ring,
+                           const ZixMpmcRingTransaction* ZIX_NONNULL tx);
+
+/**
+   @}
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif /* ZIX_MPMC_RING_H */
@@ -0,0 +1,87 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_PAGE_ALLOCATOR_H
+#define ZIX_PAGE_ALLOCATOR_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <stdint.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_page_allocator Page Allocator
+   @ingroup zix_allocation
+   @{
+*/
+
+/// Options for how a page allocator gets memory from the system
+typedef enum {
+  ZIX_PAGE_OPTION_NONE             = 0U,       ///< Use normal pages
+  ZIX_PAGE_OPTION_HUGE             = 1U << 0U, ///< Use reserved huge pages
+  ZIX_PAGE_OPTION_TRANSPARENT_HUGE = 1U << 1U, ///< Advise use of huge pages
+} ZixPageOption;
+
+/// Bitwise OR of ZixPageOption values
+typedef uint32_t ZixPageOptions;
+
+/**
+   An allocator for large data structures that maps memory in 2 MiB regions.
+
+   This is intended for large data structures, like a ZixBTree or ZixHash with
+   many millions of entries, where the cost of TLB misses can be significant.
+   Memory is mapped from the system in regions of 2 MiB, which is the size of
+   a huge page on common architectures, and optionally bound to a NUMA node.
+
+   Small allocations (up to 256 KiB) are rounded up to a power of two and
+   carved out of shared regions, so many objects share a single huge page.
+   Objects are naturally aligned, so, for example, a #ZIX_BTREE_PAGE_SIZE
+   allocation will be aligned to its size.  Larger allocations are mapped
+   individually, rounded up to a multiple of the region size.
+
+   Where huge pages or NUMA binding aren't supported or available, the
+   allocator falls back to normal pages, and if mapping memory isn't supported
+   at all, regions are allocated from the parent instead.
+
+   Memory in small regions is reused for allocations of the same size class,
+   but only returned to the system when the allocator is freed.
+
+   This allocator is thread-safe, provided the parent is.
+*/
+typedef struct ZixPageAllocatorImpl ZixPageAllocator;
+
+/**
+   Create a new page allocator.
+
+   @param parent Allocator for the allocator itself, and fallback regions.
+   @param options Options for how memory is mapped from the system.
+   @param numa_node Index of the NUMA node to prefer memory from, or -1.
+   @return A new allocator, or null if memory allocation failed.
+*/
+ZIX_API ZIX_NODISCARD ZixPageAllocator* ZIX_ALLOCATED
+zix_page_allocator_new(ZixAllocator* ZIX_NULLABLE parent,
+                       ZixPageOptions             options,
+                       int                        numa_node);
+
+/**
+   Free a page allocator.
+
+   This unmaps all shared regions, so any remaining small allocations made with
+   it are invalidated.  Large allocations must be freed individually.
+*/
+ZIX_API void
+zix_page_allocator_free(ZixPageAllocator* ZIX_NULLABLE allocator);
+
+/// Return the allocator interface of a page allocator
+ZIX_PURE_API ZixAllocator* ZIX_NONNULL
+zix_page_allocator_base(ZixPageAllocator* ZIX_NONNULL allocator);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_PAGE_ALLOCATOR_H
@@ -0,0 +1,87 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_POOL_ALLOCATOR_H
+#define ZIX_POOL_ALLOCATOR_H
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/status.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+ZIX_BEGIN_DECLS
+
+/**
+   @defgroup zix_pool_allocator Pool Allocator
+   @ingroup zix_allocation
+   @{
+*/
+
+/**
+   An allocator for objects of a single fixed size.
+
+   This allocates objects from large aligned chunks, which are requested from
+   a parent allocator as needed, with each chunk twice the size of the last.
+   Freed objects are pushed to a lock-free free list, so both allocation and
+   deallocation are constant-time and may be called concurrently from any
+   number of threads.  This is useful for data structures with many nodes of
+   the same size, like a ZixBTree, whose pages are all #ZIX_BTREE_PAGE_SIZE.
+
+   Allocation and deallocation are real-time safe as long as the pool doesn't
+   need to grow, which can be avoided by creating it with enough capacity up
+   front.  Memory is only returned to the parent when the pool is freed.
+
+   Requests for more than the object size, or a greater alignment than the
+   pool was created with, fail.  Since all objects are the same size, realloc()
+   simply returns the input pointer if the new size fits.
+*/
+typedef struct ZixPoolAllocatorImpl ZixPoolAllocator;
+
+/**
+   Create a new pool allocator.
+
+   @param parent Allocator for the pool itself, and its chunks.
+   @param object_size Size of each object in bytes.
+   @param alignment Minimum alignment of objects, which must be a power of two.
+   @param n_objects Number of objects to allocate space for up front.
+   @return A new pool, or null if the parameters are invalid or memory
+   allocation failed.
+*/
+ZIX_API ZIX_NODISCARD ZixPoolAllocator* ZIX_ALLOCATED
+zix_pool_allocator_new(ZixAllocator* ZIX_NULLABLE parent,
+                       size_t                     object_size,
+                       size_t                     alignment,
+                       uint32_t                   n_objects);
+
+/**
+   Free a pool allocator.
+
+   This returns all of the memory used by the pool to the parent, so any
+   remaining objects allocated from it are invalidated.
+*/
+ZIX_API void
+zix_pool_allocator_free(ZixPoolAllocator* ZIX_NULLABLE pool);
+
+/// Return the allocator interface of a pool
+ZIX_PURE_API ZixAllocator* ZIX_NONNULL
+zix_pool_allocator_base(ZixPoolAllocator* ZIX_NONNULL pool);
+
+/**
+   Lock the pool memory into physical memory.
+
+   This locks all chunks into memory to avoid page faults, and also locks any
+   chunks allocated later as the pool grows.  Like zix_ring_mlock(), this is
+   not real-time safe, and should be called after creating the pool.
+*/
+ZIX_API ZixStatus
+zix_pool_allocator_mlock(ZixPoolAllocator* ZIX_NONNULL pool);
+
+/**
+   @}
+*/
+
+ZIX_END_DECLS
+
+#endif // ZIX_POOL_ALLOCATOR_H
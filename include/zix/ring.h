@@ -28,9 +28,37 @@ ZIX_BEGIN_DECLS
 
    Thread-safe (with a few noted exceptions) for a single reader and single
    writer, and realtime-safe on both ends.
+
+   The reader and writer each remember the last position of the other that
+   they saw, and only synchronize with the other thread when that isn't enough
+   to complete an operation.  So, it's more efficient to simply attempt to
+   read or write, and check the result, than to check for space first.
 */
 typedef struct ZixRingImpl ZixRing;
 
+/**
+   A contiguous region of memory inside a ring.
+
+   This is used to access the ring's contents directly, without copying.
+*/
+typedef struct {
+  void* ZIX_NONNULL data; ///< Pointer to the start of the region
+  uint32_t          size; ///< Size of the region in bytes
+} ZixRingRegion;
+
+/**
+   A view of a span of ring memory.
+
+   Since the span may wrap around the end of the ring's buffer, it is
+   described by two regions.  The first region starts at the current head,
+   and the second (which is empty if the span doesn't wrap around) starts at
+   the beginning of the buffer.
+*/
+typedef struct {
+  ZixRingRegion first;  ///< Region from the head towards the end of the buffer
+  ZixRingRegion second; ///< Region from the start of the buffer, or empty
+} ZixRingVector;
+
 /**
    @}
    @defgroup zix_ring_setup Setup
@@ -50,6 +78,26 @@ typedef struct ZixRingImpl ZixRing;
 ZIX_API ZIX_NODISCARD ZixRing* ZIX_ALLOCATED
 zix_ring_new(ZixAllocator* ZIX_NULLABLE allocator, uint32_t size);
 
+/**
+   Create a new ring with a mirrored buffer, if possible.
+
+   This is like zix_ring_new(), but where supported, the ring's buffer is
+   mapped into virtual memory twice, back to back, so that any span of data in
+   the ring (even one that wraps around the end of the buffer) is contiguous
+   in memory.  A vector returned by zix_ring_read_vector() or
+   zix_ring_write_vector() then always has an empty second region, and reads
+   and writes never need to be split.
+
+   The size of a mirrored buffer is also rounded up to the system page size.
+   If mirroring isn't supported, then this falls back to a normal buffer
+   exactly like zix_ring_new().
+
+   @param allocator Allocator for the ring object.
+   @param size Minimum size of the ring array in bytes, as in zix_ring_new().
+*/
+ZIX_API ZIX_NODISCARD ZixRing* ZIX_ALLOCATED
+zix_ring_new_mirrored(ZixAllocator* ZIX_NULLABLE allocator, uint32_t size);
+
 /**
    Destroy a ring.
 
@@ -136,6 +184,51 @@ zix_ring_read(ZixRing* ZIX_NONNULL ring, void* ZIX_NONNULL dst, uint32_t size);
 ZIX_API ZIX_REALTIME uint32_t
 zix_ring_skip(ZixRing* ZIX_NONNULL ring, uint32_t size);
 
+/**
+   Return a view of all the data available for reading.
+
+   This allows data to be read in place, without copying it to another buffer.
+   The data remains in the ring until the read head is advanced past it by
+   calling zix_ring_skip(), which makes the space available for writing again.
+
+   The returned view is only valid until the read head is advanced.
+
+   @param ring The ring to access data in.
+   @return A view of the readable data, with a total size equal to
+   zix_ring_read_space().
+*/
+ZIX_API ZIX_REALTIME ZixRingVector
+zix_ring_read_vector(ZixRing* ZIX_NONNULL ring);
+
+/**
+   Wait until some amount of data is available for reading.
+
+   This is an alternative to polling zix_ring_read_space() in a loop, for
+   readers that may block.  It first spins briefly, then announces that the
+   reader is sleeping and blocks until the writer calls zix_ring_notify(), or
+   the timeout expires.  Where the system has no suitable way for the writer
+   to wake the reader, this falls back to sleeping in short intervals and
+   checking for data.
+
+   This function is NOT real-time safe, and should only be used if the writer
+   calls zix_ring_notify() after every write, otherwise it only wakes up when
+   the timeout expires.
+
+   @param ring The ring to wait on.
+   @param size The number of bytes to wait for.
+   @param seconds Maximum number of seconds to wait.
+   @param nanoseconds Maximum number of nanoseconds to wait, in addition to
+   `seconds`.
+
+   @return #ZIX_STATUS_SUCCESS if at least `size` bytes are available for
+   reading, or #ZIX_STATUS_TIMEOUT if there weren't enough by the timeout.
+*/
+ZIX_API ZixStatus
+zix_ring_wait_read(ZixRing* ZIX_NONNULL ring,
+                   uint32_t             size,
+                   uint32_t             seconds,
+                   uint32_t             nanoseconds);
+
 /**
    @}
    @defgroup zix_ring_write Writing
@@ -243,6 +336,45 @@ ZIX_API ZIX_REALTIME ZixStatus
 zix_ring_commit_write(ZixRing* ZIX_NONNULL                  ring,
                       const ZixRingTransaction* ZIX_NONNULL tx);
 
+/**
+   Return a view of all the space available for writing.
+
+   This allows data to be written in place, without copying it from another
+   buffer.  Data written to this space isn't visible to the reader until it is
+   published by calling zix_ring_advance_write().
+
+   The returned view is only valid until the write head is advanced.
+
+   @param ring The ring to access space in.
+   @return A view of the writable space, with a total size equal to
+   zix_ring_write_space().
+*/
+ZIX_API ZIX_REALTIME ZixRingVector
+zix_ring_write_vector(ZixRing* ZIX_NONNULL ring);
+
+/**
+   Advance the write head, publishing data that was written in place.
+
+   This is used after writing to the regions returned by
+   zix_ring_write_vector(), and atomically makes the first `size` bytes of that
+   space visible to the reader.
+
+   @return Either `size` on success, or zero if there isn't enough space.
+*/
+ZIX_API ZIX_REALTIME uint32_t
+zix_ring_advance_write(ZixRing* ZIX_NONNULL ring, uint32_t size);
+
+/**
+   Notify the reader that data has been written.
+
+   This should be called after writing or committing a write, if the reader
+   uses zix_ring_wait_read().  It never blocks, and only makes a system call
+   if the reader is actually sleeping, so the common case when the reader is
+   busy is cheap.
+*/
+ZIX_API ZIX_NONBLOCKING void
+zix_ring_notify(ZixRing* ZIX_NONNULL ring);
+
 /**
    @}
    @}
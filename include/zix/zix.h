@@ -28,7 +28,12 @@
 */
 
 #include <zix/allocator.h>
+#include <zix/arena_allocator.h>
 #include <zix/bump_allocator.h>
+#include <zix/caching_allocator.h>
+#include <zix/counting_allocator.h>
+#include <zix/page_allocator.h>
+#include <zix/pool_allocator.h>
 
 /**
    @}
@@ -46,6 +51,7 @@
 
 #include <zix/btree.h>
 #include <zix/hash.h>
+#include <zix/mpmc_ring.h>
 #include <zix/ring.h>
 #include <zix/tree.h>
 
@@ -64,6 +70,7 @@
    @{
 */
 
+#include <zix/dir_watcher.h>
 #include <zix/filesystem.h>
 #include <zix/path.h>
 
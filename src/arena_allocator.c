@@ -0,0 +1,264 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/arena_allocator.h>
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/bump_allocator.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const size_t min_alignment = sizeof(uintmax_t);
+
+typedef struct ZixArenaBlockImpl ZixArenaBlock;
+
+/// A block of memory, followed by the buffer its bump allocator works within
+struct ZixArenaBlockImpl {
+  ZixArenaBlock*   prev; ///< Previous block, or null for the initial one
+  ZixBumpAllocator bump; ///< Allocator for this block's buffer
+};
+
+struct ZixArenaAllocatorImpl {
+  ZixAllocator   base;       ///< Base allocator instance
+  ZixAllocator*  parent;     ///< Allocator for the arena and its blocks
+  size_t         block_size; ///< Default capacity of new blocks
+  ZixArenaBlock* current;    ///< Block allocations are currently made from
+  ZixArenaMark   start;      ///< Mark of the empty initial block
+};
+
+ZIX_PURE_FUNC static size_t
+round_up_multiple(const size_t number, const size_t factor)
+{
+  assert(factor);                         // Factor must be non-zero
+  assert((factor & (factor - 1U)) == 0U); // Factor must be a power of two
+
+  return (number + factor - 1U) & ~(factor - 1U);
+}
+
+static size_t
+block_header_size(void)
+{
+  return round_up_multiple(sizeof(ZixArenaBlock), min_alignment);
+}
+
+static ZixArenaBlock*
+init_block(void* const memory, ZixArenaBlock* const prev, const size_t size)
+{
+  ZixArenaBlock* const block = (ZixArenaBlock*)memory;
+
+  block->prev = prev;
+  block->bump = zix_bump_allocator(size, (char*)memory + block_header_size());
+  return block;
+}
+
+static ZixArenaBlock*
+push_block(ZixArenaAllocator* const arena, const size_t min_size)
+{
+  const size_t header_size = block_header_size();
+  const size_t size =
+    (min_size > arena->block_size) ? min_size : arena->block_size;
+
+  if (size > SIZE_MAX - header_size) {
+    return NULL;
+  }
+
+  void* const memory = zix_malloc(arena->parent, header_size + size);
+  if (!memory) {
+    return NULL;
+  }
+
+  return (arena->current = init_block(memory, arena->current, size));
+}
+
+static ZixArenaBlock*
+find_block(const ZixArenaAllocator* const arena, const void* const ptr)
+{
+  const uintptr_t addr = (uintptr_t)ptr;
+
+  for (ZixArenaBlock* b = arena->current; b; b = b->prev) {
+    const uintptr_t begin = (uintptr_t)b->bump.buffer;
+    if (addr >= begin && addr < begin + b->bump.top) {
+      return b;
+    }
+  }
+
+  return NULL;
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_arena_aligned_alloc(ZixAllocator* const allocator,
+                        const size_t        alignment,
+                        const size_t        size)
+{
+  ZixArenaAllocator* const arena = (ZixArenaAllocator*)allocator;
+
+  const size_t align = (alignment > min_alignment) ? alignment : min_alignment;
+  if (size > SIZE_MAX / 2U || align > SIZE_MAX / 4U) {
+    return NULL;
+  }
+
+  // The bump allocator requires the size to be a multiple of the alignment
+  const size_t real_size = round_up_multiple(size, align);
+
+  void* ptr = zix_aligned_alloc(&arena->current->bump.base, align, real_size);
+  if (!ptr && push_block(arena, real_size + align - min_alignment)) {
+    ptr = zix_aligned_alloc(&arena->current->bump.base, align, real_size);
+  }
+
+  return ptr;
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_arena_malloc(ZixAllocator* const allocator, const size_t size)
+{
+  return zix_arena_aligned_alloc(allocator, min_alignment, size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_arena_calloc(ZixAllocator* const allocator,
+                 const size_t        nmemb,
+                 const size_t        size)
+{
+  if (size && nmemb > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  const size_t total_size = nmemb * size;
+  void* const  ptr        = zix_arena_malloc(allocator, total_size);
+  if (ptr) {
+    memset(ptr, 0, total_size);
+  }
+
+  return ptr;
+}
+
+static void*
+zix_arena_realloc(ZixAllocator* const allocator,
+                  void* const         ptr,
+                  const size_t        size)
+{
+  ZixArenaAllocator* const arena = (ZixArenaAllocator*)allocator;
+  if (!ptr) {
+    return zix_arena_malloc(allocator, size);
+  }
+
+  if (size > SIZE_MAX / 2U) {
+    return NULL;
+  }
+
+  // Resize in place if this is the last allocation and there is space
+  const size_t real_size = round_up_multiple(size, min_alignment);
+
+  void* const resized = zix_realloc(&arena->current->bump.base, ptr, real_size);
+  if (resized) {
+    return resized;
+  }
+
+  // Otherwise, copy to a new allocation, at most up to the end of the block
+  const ZixArenaBlock* const block = find_block(arena, ptr);
+  if (!block) {
+    return NULL;
+  }
+
+  const uintptr_t end      = (uintptr_t)block->bump.buffer + block->bump.top;
+  const size_t    max_size = (size_t)(end - (uintptr_t)ptr);
+
+  void* const new_ptr = zix_arena_malloc(allocator, size);
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, (size < max_size) ? size : max_size);
+  }
+
+  return new_ptr;
+}
+
+static void
+zix_arena_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixArenaAllocator* const arena = (ZixArenaAllocator*)allocator;
+
+  zix_free(&arena->current->bump.base, ptr);
+}
+
+static void
+zix_arena_aligned_free(ZixAllocator* const allocator, void* const ptr)
+{
+  zix_arena_free(allocator, ptr);
+}
+
+ZixArenaAllocator*
+zix_arena_allocator_new(ZixAllocator* const parent, const size_t block_size)
+{
+  const size_t arena_size =
+    round_up_multiple(sizeof(ZixArenaAllocator), min_alignment);
+
+  if (block_size > SIZE_MAX - arena_size - block_header_size()) {
+    return NULL;
+  }
+
+  // Allocate the arena and its initial block together
+  ZixArenaAllocator* const arena = (ZixArenaAllocator*)zix_malloc(
+    parent, arena_size + block_header_size() + block_size);
+  if (!arena) {
+    return NULL;
+  }
+
+  arena->base.malloc        = zix_arena_malloc;
+  arena->base.calloc        = zix_arena_calloc;
+  arena->base.realloc       = zix_arena_realloc;
+  arena->base.free          = zix_arena_free;
+  arena->base.aligned_alloc = zix_arena_aligned_alloc;
+  arena->base.aligned_free  = zix_arena_aligned_free;
+  arena->parent             = parent;
+  arena->block_size         = block_size;
+  arena->current = init_block((char*)arena + arena_size, NULL, block_size);
+  arena->start   = zix_arena_allocator_mark(arena);
+  return arena;
+}
+
+void
+zix_arena_allocator_free(ZixArenaAllocator* const arena)
+{
+  if (arena) {
+    zix_arena_allocator_reset(arena);
+    zix_free(arena->parent, arena);
+  }
+}
+
+ZixAllocator*
+zix_arena_allocator_base(ZixArenaAllocator* const arena)
+{
+  return &arena->base;
+}
+
+ZixArenaMark
+zix_arena_allocator_mark(const ZixArenaAllocator* const arena)
+{
+  const ZixArenaMark mark = {arena->current, arena->current->bump.top};
+  return mark;
+}
+
+void
+zix_arena_allocator_rewind(ZixArenaAllocator* const arena,
+                           const ZixArenaMark       mark)
+{
+  while (arena->current != mark.block) {
+    ZixArenaBlock* const prev = arena->current->prev;
+    assert(prev); // Mark must be from this arena
+
+    zix_free(arena->parent, arena->current);
+    arena->current = prev;
+  }
+
+  arena->current->bump.last = mark.top;
+  arena->current->bump.top  = mark.top;
+}
+
+void
+zix_arena_allocator_reset(ZixArenaAllocator* const arena)
+{
+  zix_arena_allocator_rewind(arena, arena->start);
+}
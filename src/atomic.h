@@ -0,0 +1,213 @@
+// Copyright 2011-2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_ATOMIC_H
+#define ZIX_ATOMIC_H
+
+/*
+  Minimal atomic operations on integers and pointers used by the lock-free
+  data structures.
+
+  Note that for simplicity, only x86 and x64 are supported with MSVC.
+  Hopefully stdatomic.h support arrives before anyone cares about running this
+  code on Windows on ARM.
+*/
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Size of a cache line, which is the granularity of sharing between cores
+#ifndef ZIX_CACHE_LINE_SIZE
+#  if defined(__APPLE__) && defined(__aarch64__)
+#    define ZIX_CACHE_LINE_SIZE 128U
+#  else
+#    define ZIX_CACHE_LINE_SIZE 64U
+#  endif
+#endif
+
+/// Load a value with acquire semantics
+static inline uint32_t
+zix_atomic_load(const uint32_t* const ptr)
+{
+#ifdef _MSC_VER
+  const uint32_t val = *ptr;
+  _ReadBarrier();
+  return val;
+#else
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Store a value with release semantics
+static inline void
+zix_atomic_store(uint32_t* const ptr, // NOLINT(readability-non-const-parameter)
+                 const uint32_t  val)
+{
+#ifdef _MSC_VER
+  _WriteBarrier();
+  *ptr = val;
+#else
+  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+   Replace `*ptr` with `desired` if it equals `*expected`.
+
+   On failure, `*expected` is updated to the current value of `*ptr`.
+
+   @return True if the value was replaced.
+*/
+static inline bool
+zix_atomic_cas(uint32_t* const ptr,
+               uint32_t* const expected,
+               const uint32_t  desired)
+{
+#ifdef _MSC_VER
+  const long prev = _InterlockedCompareExchange(
+    (volatile long*)ptr, (long)desired, (long)*expected);
+
+  if ((uint32_t)prev == *expected) {
+    return true;
+  }
+
+  *expected = (uint32_t)prev;
+  return false;
+#else
+  return __atomic_compare_exchange_n(
+    ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Load a 64-bit value with acquire semantics
+static inline uint64_t
+zix_atomic_load64(const uint64_t* const ptr)
+{
+#ifdef _MSC_VER
+  // Compare-exchange with the same value to get an atomic load on x86
+  return (uint64_t)_InterlockedCompareExchange64(
+    (volatile long long*)ptr, 0LL, 0LL);
+#else
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+   Replace the 64-bit `*ptr` with `desired` if it equals `*expected`.
+
+   On failure, `*expected` is updated to the current value of `*ptr`.
+
+   @return True if the value was replaced.
+*/
+static inline bool
+zix_atomic_cas64(uint64_t* const ptr,
+                 uint64_t* const expected,
+                 const uint64_t  desired)
+{
+#ifdef _MSC_VER
+  const long long prev = _InterlockedCompareExchange64(
+    (volatile long long*)ptr, (long long)desired, (long long)*expected);
+
+  if ((uint64_t)prev == *expected) {
+    return true;
+  }
+
+  *expected = (uint64_t)prev;
+  return false;
+#else
+  return __atomic_compare_exchange_n(
+    ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Add to a 64-bit value and return the previous value
+static inline uint64_t
+zix_atomic_add64(uint64_t* const ptr, const uint64_t val)
+{
+#ifdef _MSC_VER
+  return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)ptr,
+                                             (long long)val);
+#else
+  return __atomic_fetch_add(ptr, val, __ATOMIC_RELAXED);
+#endif
+}
+
+/// Load a pointer with acquire semantics
+static inline void*
+zix_atomic_load_ptr(void* const* const ptr)
+{
+#ifdef _MSC_VER
+  void* const val = *(void* const volatile*)ptr;
+  _ReadBarrier();
+  return val;
+#else
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+   Replace `*ptr` with `desired` if it equals `*expected`.
+
+   On failure, `*expected` is updated to the current value of `*ptr`.
+
+   @return True if the pointer was replaced.
+*/
+static inline bool
+zix_atomic_cas_ptr(void** const ptr, void** const expected, void* const desired)
+{
+#ifdef _MSC_VER
+  void* const prev = _InterlockedCompareExchangePointer(
+    (void* volatile*)ptr, desired, *expected);
+
+  if (prev == *expected) {
+    return true;
+  }
+
+  *expected = prev;
+  return false;
+#else
+  return __atomic_compare_exchange_n(
+    ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Replace a pointer and return the previous value
+static inline void*
+zix_atomic_exchange_ptr(void** const ptr, void* const val)
+{
+#ifdef _MSC_VER
+  return _InterlockedExchangePointer((void* volatile*)ptr, val);
+#else
+  return __atomic_exchange_n(ptr, val, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/// Order all earlier loads and stores before all later ones
+static inline void
+zix_atomic_fence(void)
+{
+#ifdef _MSC_VER
+  _mm_mfence();
+#else
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+/// Hint to the CPU that the caller is busy-waiting
+static inline void
+zix_atomic_pause(void)
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  _mm_pause();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // ZIX_ATOMIC_H
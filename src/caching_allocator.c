@@ -0,0 +1,505 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/caching_allocator.h>
+
+#include "atomic.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  Every small allocation is within a slab which is aligned to its size, so the
+  slab header can be found by masking the address.  Large allocations are also
+  made with a header at the start of a slab-aligned block, but with no owner,
+  so freeing doesn't need to know where a pointer came from.  Live large
+  allocations are kept in a list so they can be freed with the allocator.
+
+  Each cache has a lock which is only contended if several threads share it.
+  A thread that finds its cache locked tries the others, and keeps using the
+  first free one it finds, so threads spread out over the caches even as
+  threads come and go.  Freeing to another cache pushes to its lock-free
+  queue of remote frees, which the owner drains into its free lists when it
+  runs out of memory.
+*/
+
+#define SLAB_SIZE 65536U     ///< Size and alignment of a slab
+#define HEADER_SIZE 64U      ///< Space reserved for slab header
+#define N_CLASSES 28U        ///< Number of small size classes
+#define MAX_SMALL_SIZE 4096U ///< Largest small size class
+#define LARGE_CLASS 0xFFU    ///< Class of large allocations
+
+#if defined(_MSC_VER)
+#  define THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#  define THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct BlockImpl Block;
+
+/// A free block, which stores a link to the next one in the same list
+struct BlockImpl {
+  Block* next;
+};
+
+typedef struct CacheImpl Cache;
+
+/// The header at the start of every slab
+typedef struct SlabImpl Slab;
+
+struct SlabImpl {
+  Cache*  owner;      ///< Owning cache, or null for large allocations
+  Slab*   next;       ///< Next slab in the allocator's list of all slabs
+  Slab*   prev;       ///< Previous large allocation in the allocator's list
+  size_t  size;       ///< Size of objects (or the large allocation)
+  uint8_t size_class; ///< Index of the size class, or LARGE_CLASS
+};
+
+/// A cache used by one or more threads
+struct CacheImpl {
+  uint32_t lock;                  ///< Non-zero while a thread is using cache
+  char*    tops[N_CLASSES];       ///< Next unused object in current slab
+  char*    ends[N_CLASSES];       ///< End of objects in current slab
+  Block*   free_lists[N_CLASSES]; ///< Free objects for each class
+  char     pad[ZIX_CACHE_LINE_SIZE];
+  Block*   remote_frees; ///< Objects freed by other caches
+  char     remote_pad[ZIX_CACHE_LINE_SIZE];
+};
+
+struct ZixCachingAllocatorImpl {
+  ZixAllocator  base;     ///< Base allocator instance
+  ZixAllocator* parent;   ///< Allocator for slabs and large allocations
+  Slab*         slabs;    ///< List of all slabs
+  Slab*         large;    ///< List of live large allocations
+  uint32_t      lock;     ///< Lock for the list of large allocations
+  unsigned      n_caches; ///< Number of caches
+  Cache*        caches;   ///< Array of caches
+};
+
+static const uint16_t class_sizes[N_CLASSES] = {
+  16U,   32U,   48U,   64U,   80U,   96U,   112U,  128U,  160U,  192U,
+  224U,  256U,  320U,  384U,  448U,  512U,  640U,  768U,  896U,  1024U,
+  1280U, 1536U, 1792U, 2048U, 2560U, 3072U, 3584U, 4096U,
+};
+
+#ifdef THREAD_LOCAL
+static THREAD_LOCAL uint32_t thread_number = 0U; // Zero if unassigned
+static uint32_t              n_threads     = 0U;
+#endif
+
+static inline size_t
+class_alignment(const unsigned c)
+{
+  return (size_t)class_sizes[c] & (0U - (size_t)class_sizes[c]);
+}
+
+static inline size_t
+class_offset(const unsigned c)
+{
+  // Objects are aligned to the largest power of two that divides their size
+  const size_t align = class_alignment(c);
+
+  return (align > HEADER_SIZE) ? align : HEADER_SIZE;
+}
+
+/// Return the smallest class with at least the given size and alignment
+static unsigned
+find_class(const size_t alignment, const size_t size)
+{
+  unsigned c = (size <= 128U) ? (unsigned)((size + 15U) / 16U) : 8U;
+  c          = c ? c - 1U : 0U;
+
+  while (c < N_CLASSES &&
+         (class_sizes[c] < size || class_alignment(c) < alignment)) {
+    ++c;
+  }
+
+  return c;
+}
+
+static inline Slab*
+slab_of(const void* const ptr)
+{
+  return (Slab*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_SIZE - 1U));
+}
+
+static unsigned
+thread_cache_index(const ZixCachingAllocator* const allocator)
+{
+#ifdef THREAD_LOCAL
+  if (!thread_number) {
+    // Assign numbers in order, so the first threads all get their own cache
+    uint32_t n = zix_atomic_load(&n_threads);
+    while (!zix_atomic_cas(&n_threads, &n, n + 1U)) {
+    }
+
+    thread_number = n + 1U;
+  }
+
+  return (thread_number - 1U) % allocator->n_caches;
+#else
+  (void)allocator;
+  return 0U;
+#endif
+}
+
+static Cache*
+thread_cache(ZixCachingAllocator* const allocator)
+{
+  return &allocator->caches[thread_cache_index(allocator)];
+}
+
+static bool
+try_lock(uint32_t* const flag)
+{
+  uint32_t unlocked = 0U;
+  return zix_atomic_cas(flag, &unlocked, 1U);
+}
+
+static void
+lock(uint32_t* const flag)
+{
+  while (!try_lock(flag)) {
+    zix_atomic_pause();
+  }
+}
+
+static void
+unlock(uint32_t* const flag)
+{
+  zix_atomic_store(flag, 0U);
+}
+
+static void
+lock_cache(Cache* const cache)
+{
+  lock(&cache->lock);
+}
+
+static void
+unlock_cache(Cache* const cache)
+{
+  unlock(&cache->lock);
+}
+
+/// Lock the thread's cache, or switch to another if it's in use
+static Cache*
+acquire_cache(ZixCachingAllocator* const allocator)
+{
+  const unsigned n_caches = allocator->n_caches;
+  const unsigned first    = thread_cache_index(allocator);
+
+  for (unsigned i = 0U; i < n_caches; ++i) {
+    const unsigned index = (first + i) % n_caches;
+    Cache* const   cache = &allocator->caches[index];
+    if (try_lock(&cache->lock)) {
+#ifdef THREAD_LOCAL
+      thread_number = index + 1U;
+#endif
+      return cache;
+    }
+  }
+
+  Cache* const cache = &allocator->caches[first];
+  lock_cache(cache);
+  return cache;
+}
+
+static void
+push_block(Block** const list, Block* const block)
+{
+  block->next = *list;
+  *list       = block;
+}
+
+static void
+drain_remote_frees(Cache* const cache)
+{
+  Block* block =
+    (Block*)zix_atomic_exchange_ptr((void**)&cache->remote_frees, NULL);
+
+  while (block) {
+    Block* const next = block->next;
+    push_block(&cache->free_lists[slab_of(block)->size_class], block);
+    block = next;
+  }
+}
+
+static void
+push_slab(ZixCachingAllocator* const allocator, Slab* const slab)
+{
+  void** const head = (void**)&allocator->slabs;
+
+  slab->next = (Slab*)zix_atomic_load_ptr(head);
+  while (!zix_atomic_cas_ptr(head, (void**)&slab->next, slab)) {
+  }
+}
+
+static bool
+refill(ZixCachingAllocator* const allocator,
+       Cache* const               cache,
+       const unsigned             c)
+{
+  Slab* const slab =
+    (Slab*)zix_aligned_alloc(allocator->parent, SLAB_SIZE, SLAB_SIZE);
+  if (!slab) {
+    return false;
+  }
+
+  const size_t offset  = class_offset(c);
+  const size_t n_items = (SLAB_SIZE - offset) / class_sizes[c];
+
+  slab->owner      = cache;
+  slab->next       = NULL;
+  slab->prev       = NULL;
+  slab->size       = class_sizes[c];
+  slab->size_class = (uint8_t)c;
+  cache->tops[c]   = (char*)slab + offset;
+  cache->ends[c]   = cache->tops[c] + (n_items * class_sizes[c]);
+
+  push_slab(allocator, slab);
+  return true;
+}
+
+static void*
+small_alloc(ZixCachingAllocator* const allocator, const unsigned c)
+{
+  Cache* const cache = acquire_cache(allocator);
+  void*        ptr   = NULL;
+
+  if (!cache->free_lists[c]) {
+    drain_remote_frees(cache);
+  }
+
+  if (cache->free_lists[c]) {
+    ptr                  = cache->free_lists[c];
+    cache->free_lists[c] = cache->free_lists[c]->next;
+  } else if (cache->tops[c] != cache->ends[c] || refill(allocator, cache, c)) {
+    ptr = cache->tops[c];
+    cache->tops[c] += class_sizes[c];
+  }
+
+  unlock_cache(cache);
+  return ptr;
+}
+
+static void*
+large_alloc(ZixCachingAllocator* const allocator,
+            const size_t               alignment,
+            const size_t               size)
+{
+  const size_t offset = (alignment > HEADER_SIZE) ? alignment : HEADER_SIZE;
+  if (offset >= SLAB_SIZE || size > SIZE_MAX - offset) {
+    return NULL;
+  }
+
+  Slab* const slab =
+    (Slab*)zix_aligned_alloc(allocator->parent, SLAB_SIZE, offset + size);
+  if (!slab) {
+    return NULL;
+  }
+
+  slab->owner      = NULL;
+  slab->prev       = NULL;
+  slab->size       = size;
+  slab->size_class = LARGE_CLASS;
+
+  lock(&allocator->lock);
+  slab->next = allocator->large;
+  if (slab->next) {
+    slab->next->prev = slab;
+  }
+  allocator->large = slab;
+  unlock(&allocator->lock);
+
+  return (char*)slab + offset;
+}
+
+static void
+large_free(ZixCachingAllocator* const allocator, Slab* const slab)
+{
+  lock(&allocator->lock);
+  if (slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    allocator->large = slab->next;
+  }
+
+  if (slab->next) {
+    slab->next->prev = slab->prev;
+  }
+  unlock(&allocator->lock);
+
+  zix_aligned_free(allocator->parent, slab);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_caching_aligned_alloc(ZixAllocator* const allocator,
+                          const size_t        alignment,
+                          const size_t        size)
+{
+  ZixCachingAllocator* const state = (ZixCachingAllocator*)allocator;
+
+  const unsigned c = (size <= MAX_SMALL_SIZE && alignment <= MAX_SMALL_SIZE)
+                       ? find_class(alignment, size)
+                       : N_CLASSES;
+
+  return (c < N_CLASSES) ? small_alloc(state, c)
+                         : large_alloc(state, alignment, size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_caching_malloc(ZixAllocator* const allocator, const size_t size)
+{
+  return zix_caching_aligned_alloc(allocator, sizeof(uintmax_t), size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_caching_calloc(ZixAllocator* const allocator,
+                   const size_t        nmemb,
+                   const size_t        size)
+{
+  if (size && nmemb > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  const size_t total_size = nmemb * size;
+  void* const  ptr        = zix_caching_malloc(allocator, total_size);
+  if (ptr) {
+    memset(ptr, 0, total_size);
+  }
+
+  return ptr;
+}
+
+static void
+zix_caching_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixCachingAllocator* const state = (ZixCachingAllocator*)allocator;
+  if (!ptr) {
+    return;
+  }
+
+  Slab* const  slab  = slab_of(ptr);
+  Cache* const owner = slab->owner;
+  if (!owner) {
+    large_free(state, slab);
+    return;
+  }
+
+  Block* const block = (Block*)ptr;
+  if (owner == thread_cache(state)) {
+    lock_cache(owner);
+    push_block(&owner->free_lists[slab->size_class], block);
+    unlock_cache(owner);
+  } else {
+    void** const head = (void**)&owner->remote_frees;
+
+    block->next = (Block*)zix_atomic_load_ptr(head);
+    while (!zix_atomic_cas_ptr(head, (void**)&block->next, block)) {
+    }
+  }
+}
+
+static void*
+zix_caching_realloc(ZixAllocator* const allocator,
+                    void* const         ptr,
+                    const size_t        size)
+{
+  if (!ptr) {
+    return zix_caching_malloc(allocator, size);
+  }
+
+  // Keep the same memory if it's large enough and in the best small class
+  const Slab* const slab     = slab_of(ptr);
+  const size_t      old_size = slab->size;
+  if (slab->owner && size <= old_size &&
+      find_class(sizeof(uintmax_t), size) == slab->size_class) {
+    return ptr;
+  }
+
+  void* const new_ptr = zix_caching_malloc(allocator, size);
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, (size < old_size) ? size : old_size);
+    zix_caching_free(allocator, ptr);
+  }
+
+  return new_ptr;
+}
+
+static void
+zix_caching_aligned_free(ZixAllocator* const allocator, void* const ptr)
+{
+  zix_caching_free(allocator, ptr);
+}
+
+ZixCachingAllocator*
+zix_caching_allocator_new(ZixAllocator* const parent, const unsigned n_caches)
+{
+  if (!n_caches) {
+    return NULL;
+  }
+
+  ZixCachingAllocator* const allocator = (ZixCachingAllocator*)zix_malloc(
+    parent, sizeof(ZixCachingAllocator));
+  if (!allocator) {
+    return NULL;
+  }
+
+  allocator->caches = (Cache*)zix_aligned_alloc(
+    parent, ZIX_CACHE_LINE_SIZE, n_caches * sizeof(Cache));
+  if (!allocator->caches) {
+    zix_free(parent, allocator);
+    return NULL;
+  }
+
+  memset(allocator->caches, 0, n_caches * sizeof(Cache));
+
+  allocator->base.malloc        = zix_caching_malloc;
+  allocator->base.calloc        = zix_caching_calloc;
+  allocator->base.realloc       = zix_caching_realloc;
+  allocator->base.free          = zix_caching_free;
+  allocator->base.aligned_alloc = zix_caching_aligned_alloc;
+  allocator->base.aligned_free  = zix_caching_aligned_free;
+  allocator->parent             = parent;
+  allocator->slabs              = NULL;
+  allocator->large              = NULL;
+  allocator->lock               = 0U;
+  allocator->n_caches           = n_caches;
+  return allocator;
+}
+
+void
+zix_caching_allocator_free(ZixCachingAllocator* const allocator)
+{
+  if (allocator) {
+    for (Slab* s = allocator->slabs; s;) {
+      Slab* const next = s->next;
+      zix_aligned_free(allocator->parent, s);
+      s = next;
+    }
+
+    for (Slab* s = allocator->large; s;) {
+      Slab* const next = s->next;
+      zix_aligned_free(allocator->parent, s);
+      s = next;
+    }
+
+    zix_aligned_free(allocator->parent, allocator->caches);
+    zix_free(allocator->parent, allocator);
+  }
+}
+
+ZixAllocator*
+zix_caching_allocator_base(ZixCachingAllocator* const allocator)
+{
+  return &allocator->base;
+}
@@ -0,0 +1,285 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/counting_allocator.h>
+
+#include "atomic.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  Every allocation is prefixed with a header that records its size, and its
+  offset from the start of the parent's allocation, which is larger than the
+  header size for allocations with a greater alignment.
+*/
+
+typedef struct {
+  size_t size;   ///< Size of the user allocation
+  size_t offset; ///< Offset of the user allocation from the parent's
+} Header;
+
+struct ZixCountingAllocatorImpl {
+  ZixAllocator            base;          ///< Base allocator instance
+  ZixAllocator*           parent;        ///< Allocator to forward to
+  ZixAllocationStats      stats;         ///< Counters
+  uint64_t                sample_bytes;  ///< Total bytes allocated for sampling
+  uint64_t                sample_every;  ///< Sample interval in bytes
+  ZixAllocationSampleFunc sample_func;   ///< Sample function
+  void*                   sample_handle; ///< Sample function user data
+};
+
+static const size_t header_size = 2U * sizeof(uintmax_t);
+
+static inline Header*
+header_of(void* const ptr)
+{
+  return (Header*)((char*)ptr - sizeof(Header));
+}
+
+static unsigned
+size_class(const size_t size)
+{
+  if (size <= 1U) {
+    return 0U;
+  }
+
+  // Calculate ceil(log2(size)) as one more than the index of the top bit
+  size_t   n = size - 1U;
+  unsigned c = 0U;
+  while (n) {
+    n >>= 1U;
+    ++c;
+  }
+
+  return (c < ZIX_ALLOCATION_N_CLASSES) ? c : ZIX_ALLOCATION_N_CLASSES - 1U;
+}
+
+static void
+count_allocation(ZixCountingAllocator* const allocator,
+                 const void* const           ptr,
+                 const size_t                size)
+{
+  ZixAllocationStats* const stats = &allocator->stats;
+
+  zix_atomic_add64(&stats->n_allocations, 1U);
+  zix_atomic_add64(&stats->n_live, 1U);
+  zix_atomic_add64(&stats->class_counts[size_class(size)], 1U);
+
+  // Update the live total, and the peak if it's been exceeded
+  const uint64_t live = zix_atomic_add64(&stats->live_bytes, size) + size;
+  uint64_t       peak = zix_atomic_load64(&stats->peak_bytes);
+  while (peak < live && !zix_atomic_cas64(&stats->peak_bytes, &peak, live)) {
+  }
+
+  // Sample if this allocation crossed a sampling interval boundary
+  const uint64_t every = allocator->sample_every;
+  if (every) {
+    const uint64_t before = zix_atomic_add64(&allocator->sample_bytes, size);
+    if (before / every != (before + size) / every) {
+      allocator->sample_func(allocator->sample_handle, ptr, size);
+    }
+  }
+}
+
+static void
+count_free(ZixCountingAllocator* const allocator, const size_t size)
+{
+  ZixAllocationStats* const stats = &allocator->stats;
+
+  zix_atomic_add64(&stats->n_live, UINT64_MAX);
+  zix_atomic_add64(&stats->live_bytes, 0U - (uint64_t)size);
+}
+
+static void
+count_failure(ZixCountingAllocator* const allocator)
+{
+  zix_atomic_add64(&allocator->stats.n_failures, 1U);
+}
+
+static void*
+finish_allocation(ZixCountingAllocator* const allocator,
+                  void* const                 raw,
+                  const size_t                offset,
+                  const size_t                size)
+{
+  if (!raw) {
+    count_failure(allocator);
+    return NULL;
+  }
+
+  void* const   ptr    = (char*)raw + offset;
+  Header* const header = header_of(ptr);
+
+  header->size   = size;
+  header->offset = offset;
+  count_allocation(allocator, ptr, size);
+  return ptr;
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_counting_malloc(ZixAllocator* const allocator, const size_t size)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+
+  void* const raw =
+    (size <= SIZE_MAX - header_size)
+      ? zix_malloc(state->parent, header_size + size)
+      : NULL;
+
+  return finish_allocation(state, raw, header_size, size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_counting_calloc(ZixAllocator* const allocator,
+                    const size_t        nmemb,
+                    const size_t        size)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+
+  const size_t total = nmemb * size;
+  void* const  raw =
+    ((!size || nmemb <= SIZE_MAX / size) && total <= SIZE_MAX - header_size)
+      ? zix_calloc(state->parent, 1U, header_size + total)
+      : NULL;
+
+  return finish_allocation(state, raw, header_size, total);
+}
+
+static void*
+zix_counting_realloc(ZixAllocator* const allocator,
+                     void* const         ptr,
+                     const size_t        size)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+  if (!ptr) {
+    return zix_counting_malloc(allocator, size);
+  }
+
+  if (size > SIZE_MAX - header_size) {
+    count_failure(state);
+    return NULL;
+  }
+
+  const size_t old_size = header_of(ptr)->size;
+  void* const  raw =
+    zix_realloc(state->parent, (char*)ptr - header_size, header_size + size);
+  if (!raw) {
+    count_failure(state);
+    return NULL;
+  }
+
+  // Count as a free of the old allocation and a new allocation
+  count_free(state, old_size);
+  return finish_allocation(state, raw, header_size, size);
+}
+
+static void
+zix_counting_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+
+  if (ptr) {
+    const Header* const header = header_of(ptr);
+
+    count_free(state, header->size);
+    zix_free(state->parent, (char*)ptr - header->offset);
+  }
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_counting_aligned_alloc(ZixAllocator* const allocator,
+                           const size_t        alignment,
+                           const size_t        size)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+
+  // Put the header in the space before the first aligned address after it
+  const size_t offset = (alignment > header_size) ? alignment : header_size;
+  void* const  raw =
+    (size <= SIZE_MAX - offset)
+      ? zix_aligned_alloc(state->parent, offset, offset + size)
+      : NULL;
+
+  return finish_allocation(state, raw, offset, size);
+}
+
+static void
+zix_counting_aligned_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixCountingAllocator* const state = (ZixCountingAllocator*)allocator;
+
+  if (ptr) {
+    const Header* const header = header_of(ptr);
+
+    count_free(state, header->size);
+    zix_aligned_free(state->parent, (char*)ptr - header->offset);
+  }
+}
+
+ZixCountingAllocator*
+zix_counting_allocator_new(ZixAllocator* const parent)
+{
+  ZixCountingAllocator* const allocator = (ZixCountingAllocator*)zix_calloc(
+    parent, 1U, sizeof(ZixCountingAllocator));
+
+  if (allocator) {
+    allocator->base.malloc        = zix_counting_malloc;
+    allocator->base.calloc        = zix_counting_calloc;
+    allocator->base.realloc       = zix_counting_realloc;
+    allocator->base.free          = zix_counting_free;
+    allocator->base.aligned_alloc = zix_counting_aligned_alloc;
+    allocator->base.aligned_free  = zix_counting_aligned_free;
+    allocator->parent             = parent;
+  }
+
+  return allocator;
+}
+
+void
+zix_counting_allocator_free(ZixCountingAllocator* const allocator)
+{
+  if (allocator) {
+    zix_free(allocator->parent, allocator);
+  }
+}
+
+ZixAllocator*
+zix_counting_allocator_base(ZixCountingAllocator* const allocator)
+{
+  return &allocator->base;
+}
+
+ZixAllocationStats
+zix_counting_allocator_stats(const ZixCountingAllocator* const allocator)
+{
+  const ZixAllocationStats* const counters = &allocator->stats;
+  ZixAllocationStats              stats;
+
+  stats.live_bytes    = zix_atomic_load64(&counters->live_bytes);
+  stats.peak_bytes    = zix_atomic_load64(&counters->peak_bytes);
+  stats.n_live        = zix_atomic_load64(&counters->n_live);
+  stats.n_allocations = zix_atomic_load64(&counters->n_allocations);
+  stats.n_failures    = zix_atomic_load64(&counters->n_failures);
+  for (unsigned i = 0U; i < ZIX_ALLOCATION_N_CLASSES; ++i) {
+    stats.class_counts[i] = zix_atomic_load64(&counters->class_counts[i]);
+  }
+
+  return stats;
+}
+
+void
+zix_counting_allocator_sample(ZixCountingAllocator* const   allocator,
+                              const uint64_t                interval,
+                              const ZixAllocationSampleFunc func,
+                              void* const                   handle)
+{
+  allocator->sample_every  = func ? interval : 0U;
+  allocator->sample_func   = func;
+  allocator->sample_handle = handle;
+  allocator->sample_bytes  = 0U;
+}
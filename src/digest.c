@@ -3,8 +3,10 @@
 
 #include <zix/attributes.h>
 #include <zix/digest.h>
+#include <zix/status.h>
 
 #include "qualifiers.h"
+#include "system.h"
 
 #include <assert.h>
 #include <stdint.h>
@@ -32,28 +34,11 @@ mix64(uint64_t h)
   return h;
 }
 
-ZIX_NONBLOCKING uint64_t
-zix_digest64(const uint64_t seed, const void* const buf, const size_t len)
+static inline uint64_t
+load_tail64(const uint8_t* const tail, const size_t n_bytes)
 {
-  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
-
-  // Process as many 64-bit blocks as possible
-  const size_t         n_blocks   = len / sizeof(uint64_t);
-  const uint8_t*       data       = (const uint8_t*)buf;
-  const uint8_t* const blocks_end = data + (n_blocks * sizeof(uint64_t));
-  uint64_t             h          = seed ^ (len * m);
-  for (; data != blocks_end; data += sizeof(uint64_t)) {
-    uint64_t k = 0U;
-    memcpy(&k, data, sizeof(uint64_t));
-
-    h ^= mix64(k);
-    h *= m;
-  }
-
-  // Process any trailing bytes
-  const uint8_t* const tail = blocks_end;
-  uint64_t             v    = 0U;
-  switch (len & 7U) {
+  uint64_t v = 0U;
+  switch (n_bytes) {
   case 7:
     v |= (uint64_t)tail[6] << 48U;
     FALLTHROUGH();
@@ -74,14 +59,53 @@ zix_digest64(const uint64_t seed, const void* const buf, const size_t len)
     FALLTHROUGH();
   case 1:
     v |= (uint64_t)tail[0];
+  }
+
+  return v;
+}
+
+/// Mix a block into a hash state
+static inline uint64_t
+step64(const uint64_t h, const uint8_t* const data)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  uint64_t k = 0U;
+  memcpy(&k, data, sizeof(uint64_t));
+
+  return (h ^ mix64(k)) * m;
+}
+
+/// Hash the remaining data after an initial state and return the result
+static inline uint64_t
+finish64(uint64_t h, const uint8_t* data, const size_t len)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  // Process as many 64-bit blocks as possible
+  const size_t         n_blocks   = len / sizeof(uint64_t);
+  const uint8_t* const blocks_end = data + (n_blocks * sizeof(uint64_t));
+  for (; data != blocks_end; data += sizeof(uint64_t)) {
+    h = step64(h, data);
+  }
 
-    h ^= mix64(v);
+  // Process any trailing bytes
+  if (len & 7U) {
+    h ^= mix64(load_tail64(blocks_end, len & 7U));
     h *= m;
   }
 
   return mix64(h);
 }
 
+ZIX_NONBLOCKING uint64_t
+zix_digest64(const uint64_t seed, const void* const buf, const size_t len)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  return finish64(seed ^ (len * m), (const uint8_t*)buf, len);
+}
+
 ZIX_NONBLOCKING uint64_t
 zix_digest64_aligned(const uint64_t seed, const void* const buf, size_t len)
 {
@@ -102,6 +126,156 @@ zix_digest64_aligned(const uint64_t seed, const void* const buf, size_t len)
   return mix64(h);
 }
 
+ZIX_NONBLOCKING uint64_t
+zix_digest64_wide(const uint64_t seed, const void* const buf, const size_t len)
+{
+  ZIX_CONSTEXPR uint64_t m          = 0x880355F21E6D1965ULL;
+  ZIX_CONSTEXPR size_t   stripe_len = 4U * sizeof(uint64_t);
+  ZIX_CONSTEXPR size_t   min_len    = 256U;
+
+  if (len < min_len) {
+    return zix_digest64(seed, buf, len);
+  }
+
+  // Start each lane with a different state so identical lanes don't cancel
+  uint64_t h0 = seed ^ (len * m);
+  uint64_t h1 = mix64(h0 + 1U);
+  uint64_t h2 = mix64(h0 + 2U);
+  uint64_t h3 = mix64(h0 + 3U);
+
+  // Process as many stripes as possible, one block per lane at a time
+  const size_t         n_stripes   = len / stripe_len;
+  const uint8_t*       data        = (const uint8_t*)buf;
+  const uint8_t* const stripes_end = data + (n_stripes * stripe_len);
+  for (; data != stripes_end; data += stripe_len) {
+    h0 = step64(h0, data);
+    h1 = step64(h1, data + 8U);
+    h2 = step64(h2, data + 16U);
+    h3 = step64(h3, data + 24U);
+  }
+
+  // Fold the lanes together
+  uint64_t h = h0;
+  h          = (h ^ mix64(h1)) * m;
+  h          = (h ^ mix64(h2)) * m;
+  h          = (h ^ mix64(h3)) * m;
+
+  // Process any remaining data
+  return finish64(h, data, len % stripe_len);
+}
+
+ZIX_NONBLOCKING void
+zix_digest64_batch(const uint64_t           seed,
+                   const void* const* const bufs,
+                   const size_t* const      lens,
+                   const size_t             n,
+                   uint64_t* const          out)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  size_t i = 0U;
+  for (; i + 4U <= n; i += 4U) {
+    const uint8_t* const d0 = (const uint8_t*)bufs[i];
+    const uint8_t* const d1 = (const uint8_t*)bufs[i + 1U];
+    const uint8_t* const d2 = (const uint8_t*)bufs[i + 2U];
+    const uint8_t* const d3 = (const uint8_t*)bufs[i + 3U];
+
+    // Find the number of blocks that every key has
+    const size_t n01 = (lens[i] < lens[i + 1U]) ? lens[i] : lens[i + 1U];
+    const size_t n23 = (lens[i + 2U] < lens[i + 3U]) ? lens[i + 2U]
+                                                     : lens[i + 3U];
+    const size_t n_common = ((n01 < n23) ? n01 : n23) / sizeof(uint64_t);
+    const size_t done     = n_common * sizeof(uint64_t);
+
+    // Interleave the independent mix chains of the common blocks
+    uint64_t h0 = seed ^ (lens[i] * m);
+    uint64_t h1 = seed ^ (lens[i + 1U] * m);
+    uint64_t h2 = seed ^ (lens[i + 2U] * m);
+    uint64_t h3 = seed ^ (lens[i + 3U] * m);
+    for (size_t offset = 0U; offset < done; offset += sizeof(uint64_t)) {
+      h0 = step64(h0, d0 + offset);
+      h1 = step64(h1, d1 + offset);
+      h2 = step64(h2, d2 + offset);
+      h3 = step64(h3, d3 + offset);
+    }
+
+    // Finish each key separately
+    out[i]      = finish64(h0, d0 + done, lens[i] - done);
+    out[i + 1U] = finish64(h1, d1 + done, lens[i + 1U] - done);
+    out[i + 2U] = finish64(h2, d2 + done, lens[i + 2U] - done);
+    out[i + 3U] = finish64(h3, d3 + done, lens[i + 3U] - done);
+  }
+
+  // Hash any remaining keys individually
+  for (; i < n; ++i) {
+    out[i] = zix_digest64(seed, bufs[i], lens[i]);
+  }
+}
+
+ZIX_REALTIME void
+zix_digest64_init(ZixDigest64State* const state,
+                  const uint64_t          seed,
+                  const size_t            len)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  state->h     = seed ^ (len * m);
+  state->len   = 0U;
+  state->total = len;
+  memset(state->block, 0, sizeof(state->block));
+}
+
+ZIX_NONBLOCKING void
+zix_digest64_update(ZixDigest64State* const state,
+                    const void* const       buf,
+                    const size_t            len)
+{
+  const uint8_t*       data      = (const uint8_t*)buf;
+  const uint8_t* const end       = data + len;
+  const size_t         n_pending = state->len & 7U;
+  uint64_t             h         = state->h;
+
+  state->len += len;
+
+  // Complete a pending partial block if possible
+  if (n_pending) {
+    const size_t n_needed = sizeof(uint64_t) - n_pending;
+    if (len < n_needed) {
+      memcpy(state->block + n_pending, data, len);
+      return;
+    }
+
+    memcpy(state->block + n_pending, data, n_needed);
+    data += n_needed;
+    h = step64(h, state->block);
+  }
+
+  // Process as many 64-bit blocks as possible
+  for (; (size_t)(end - data) >= sizeof(uint64_t); data += sizeof(uint64_t)) {
+    h = step64(h, data);
+  }
+
+  // Save any trailing bytes for later
+  memcpy(state->block, data, (size_t)(end - data));
+  state->h = h;
+}
+
+ZIX_REALTIME uint64_t
+zix_digest64_final(const ZixDigest64State* const state)
+{
+  ZIX_CONSTEXPR uint64_t m = 0x880355F21E6D1965ULL;
+
+  assert(state->len == state->total);
+
+  uint64_t h = state->h;
+  if (state->len & 7U) {
+    h ^= mix64(load_tail64(state->block, state->len & 7U));
+    h *= m;
+  }
+
+  return mix64(h);
+}
+
 /*
   32-bit hash: Essentially murmur3, reimplemented here in an aligned/padded and
   a general UB-free variant.
@@ -119,6 +293,43 @@ rotl32(const uint32_t val, const uint32_t bits)
   return ((val << bits) | (val >> (32U - bits)));
 }
 
+static inline uint32_t
+scramble32(uint32_t k)
+{
+  k *= 0xCC9E2D51U;
+  k = rotl32(k, 15U);
+  k *= 0x1B873593U;
+  return k;
+}
+
+/// Mix a block into a hash state
+static inline uint32_t
+step32(const uint32_t h, const uint8_t* const data)
+{
+  uint32_t k = 0U;
+  memcpy(&k, data, sizeof(uint32_t));
+
+  return (rotl32(h ^ scramble32(k), 13U) * 5U) + 0xE6546B64U;
+}
+
+static inline uint32_t
+load_tail32(const uint8_t* const tail, const size_t n_bytes)
+{
+  uint32_t k = 0U;
+  switch (n_bytes) {
+  case 3U:
+    k ^= (uint32_t)tail[2U] << 16U;
+    FALLTHROUGH();
+  case 2U:
+    k ^= (uint32_t)tail[1U] << 8U;
+    FALLTHROUGH();
+  case 1U:
+    k ^= (uint32_t)tail[0U];
+  }
+
+  return k;
+}
+
 static inline uint32_t
 mix32(uint32_t h)
 {
@@ -133,43 +344,18 @@ mix32(uint32_t h)
 ZIX_NONBLOCKING uint32_t
 zix_digest32(const uint32_t seed, const void* const buf, const size_t len)
 {
-  ZIX_CONSTEXPR uint32_t c1 = 0xCC9E2D51U;
-  ZIX_CONSTEXPR uint32_t c2 = 0x1B873593U;
-
   // Process as many 32-bit blocks as possible
   const size_t         n_blocks   = len / sizeof(uint32_t);
   const uint8_t*       data       = (const uint8_t*)buf;
   const uint8_t* const blocks_end = data + (n_blocks * sizeof(uint32_t));
   uint32_t             h          = seed;
   for (; data != blocks_end; data += sizeof(uint32_t)) {
-    uint32_t k = 0U;
-    memcpy(&k, data, sizeof(uint32_t));
-
-    k *= c1;
-    k = rotl32(k, 15);
-    k *= c2;
-
-    h ^= k;
-    h = rotl32(h, 13);
-    h = (h * 5U) + 0xE6546B64U;
+    h = step32(h, data);
   }
 
   // Process any trailing bytes
-  uint32_t k = 0U;
-  switch (len & 3U) {
-  case 3U:
-    k ^= (uint32_t)data[2U] << 16U;
-    FALLTHROUGH();
-  case 2U:
-    k ^= (uint32_t)data[1U] << 8U;
-    FALLTHROUGH();
-  case 1U:
-    k ^= (uint32_t)data[0U];
-
-    k *= c1;
-    k = rotl32(k, 15U);
-    k *= c2;
-    h ^= k;
+  if (len & 3U) {
+    h ^= scramble32(load_tail32(data, len & 3U));
   }
 
   return mix32(h ^ (uint32_t)len);
@@ -180,9 +366,6 @@ zix_digest32_aligned(const uint32_t    seed,
                      const void* const buf,
                      const size_t      len)
 {
-  ZIX_CONSTEXPR uint32_t c1 = 0xCC9E2D51U;
-  ZIX_CONSTEXPR uint32_t c2 = 0x1B873593U;
-
   assert((uintptr_t)buf % sizeof(uint32_t) == 0U);
   assert(len % sizeof(uint32_t) == 0U);
 
@@ -190,20 +373,68 @@ zix_digest32_aligned(const uint32_t    seed,
   const size_t          n_blocks = len / sizeof(uint32_t);
   uint32_t              h        = seed;
   for (size_t i = 0U; i < n_blocks; ++i) {
-    uint32_t k = blocks[i];
-
-    k *= c1;
-    k = rotl32(k, 15);
-    k *= c2;
-
-    h ^= k;
-    h = rotl32(h, 13);
+    h ^= scramble32(blocks[i]);
+    h = rotl32(h, 13U);
     h = (h * 5U) + 0xE6546B64U;
   }
 
   return mix32(h ^ (uint32_t)len);
 }
 
+ZIX_REALTIME void
+zix_digest32_init(ZixDigest32State* const state, const uint32_t seed)
+{
+  state->h   = seed;
+  state->len = 0U;
+  memset(state->block, 0, sizeof(state->block));
+}
+
+ZIX_NONBLOCKING void
+zix_digest32_update(ZixDigest32State* const state,
+                    const void* const       buf,
+                    const size_t            len)
+{
+  const uint8_t*       data      = (const uint8_t*)buf;
+  const uint8_t* const end       = data + len;
+  const size_t         n_pending = state->len & 3U;
+  uint32_t             h         = state->h;
+
+  state->len += len;
+
+  // Complete a pending partial block if possible
+  if (n_pending) {
+    const size_t n_needed = sizeof(uint32_t) - n_pending;
+    if (len < n_needed) {
+      memcpy(state->block + n_pending, data, len);
+      return;
+    }
+
+    memcpy(state->block + n_pending, data, n_needed);
+    data += n_needed;
+    h = step32(h, state->block);
+  }
+
+  // Process as many 32-bit blocks as possible
+  for (; (size_t)(end - data) >= sizeof(uint32_t); data += sizeof(uint32_t)) {
+    h = step32(h, data);
+  }
+
+  // Save any trailing bytes for later
+  memcpy(state->block, data, (size_t)(end - data));
+  state->h = h;
+}
+
+ZIX_REALTIME uint32_t
+zix_digest32_final(const ZixDigest32State* const state)
+{
+  uint32_t h = state->h;
+  if (state->len & 3U) {
+    h ^= scramble32(load_tail32(state->block, state->len & 3U));
+  }
+
+  return mix32(h ^ (uint32_t)state->len);
+}
+
 // Native word size wrapper
 
 ZIX_NONBLOCKING size_t
@@ -225,3 +456,137 @@ zix_digest_aligned(const size_t seed, const void* const buf, const size_t len)
   return zix_digest32_aligned(seed, buf, len);
 #endif
 }
+
+ZIX_REALTIME void
+zix_digest_init(ZixDigestState* const state,
+                const size_t          seed,
+                const size_t          len)
+{
+#if UINTPTR_MAX >= UINT64_MAX
+  zix_digest64_init(state, seed, len);
+#else
+  (void)len;
+  zix_digest32_init(state, seed);
+#endif
+}
+
+ZIX_NONBLOCKING void
+zix_digest_update(ZixDigestState* const state,
+                  const void* const     buf,
+                  const size_t          len)
+{
+#if UINTPTR_MAX >= UINT64_MAX
+  zix_digest64_update(state, buf, len);
+#else
+  zix_digest32_update(state, buf, len);
+#endif
+}
+
+ZIX_REALTIME size_t
+zix_digest_final(const ZixDigestState* const state)
+{
+#if UINTPTR_MAX >= UINT64_MAX
+  return zix_digest64_final(state);
+#else
+  return zix_digest32_final(state);
+#endif
+}
+
+/*
+  Keyed 64-bit hash: SipHash-2-4, which reads data in little-endian order so
+  the result is independent of platform.
+*/
+
+typedef struct {
+  uint64_t v0;
+  uint64_t v1;
+  uint64_t v2;
+  uint64_t v3;
+} SipState;
+
+static inline uint64_t
+rotl64(const uint64_t x, const unsigned n)
+{
+  return (x << n) | (x >> (64U - n));
+}
+
+static inline uint64_t
+load_le64(const uint8_t* const data)
+{
+  return (uint64_t)data[0] | ((uint64_t)data[1] << 8U) |
+         ((uint64_t)data[2] << 16U) | ((uint64_t)data[3] << 24U) |
+         ((uint64_t)data[4] << 32U) | ((uint64_t)data[5] << 40U) |
+         ((uint64_t)data[6] << 48U) | ((uint64_t)data[7] << 56U);
+}
+
+static inline void
+sip_round(SipState* const s)
+{
+  s->v0 += s->v1;
+  s->v1 = rotl64(s->v1, 13U);
+  s->v1 ^= s->v0;
+  s->v0 = rotl64(s->v0, 32U);
+  s->v2 += s->v3;
+  s->v3 = rotl64(s->v3, 16U);
+  s->v3 ^= s->v2;
+  s->v0 += s->v3;
+  s->v3 = rotl64(s->v3, 21U);
+  s->v3 ^= s->v0;
+  s->v2 += s->v1;
+  s->v1 = rotl64(s->v1, 17U);
+  s->v1 ^= s->v2;
+  s->v2 = rotl64(s->v2, 32U);
+}
+
+static inline void
+sip_compress(SipState* const s, const uint64_t m)
+{
+  s->v3 ^= m;
+  sip_round(s);
+  sip_round(s);
+  s->v0 ^= m;
+}
+
+ZixStatus
+zix_digest_random_key(ZixDigestKey* const key)
+{
+  uint64_t        k[2] = {0U, 0U};
+  const ZixStatus st   = zix_system_random(k, sizeof(k));
+  if (!st) {
+    key->k0 = k[0];
+    key->k1 = k[1];
+  }
+
+  return st;
+}
+
+ZIX_NONBLOCKING uint64_t
+zix_digest64_keyed(const ZixDigestKey* const key,
+                   const void* const         buf,
+                   const size_t              len)
+{
+  SipState s = {key->k0 ^ 0x736F6D6570736575ULL,
+                key->k1 ^ 0x646F72616E646F6DULL,
+                key->k0 ^ 0x6C7967656E657261ULL,
+                key->k1 ^ 0x7465646279746573ULL};
+
+  // Process as many 64-bit blocks as possible
+  const size_t         n_blocks   = len / sizeof(uint64_t);
+  const uint8_t*       data       = (const uint8_t*)buf;
+  const uint8_t* const blocks_end = data + (n_blocks * sizeof(uint64_t));
+  for (; data != blocks_end; data += sizeof(uint64_t)) {
+    sip_compress(&s, load_le64(data));
+  }
+
+  // Process the trailing bytes along with the length
+  sip_compress(&s, ((uint64_t)len << 56U) | load_tail64(blocks_end, len & 7U));
+
+  // Finalize
+  s.v2 ^= 0xFFU;
+  sip_round(&s);
+  sip_round(&s);
+  sip_round(&s);
+  sip_round(&s);
+
+  return s.v0 ^ s.v1 ^ s.v2 ^ s.v3;
+}
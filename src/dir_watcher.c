@@ -0,0 +1,794 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/dir_watcher.h>
+
+#include "system.h"
+#include "zix_config.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/filesystem.h>
+#include <zix/path.h>
+#include <zix/ring.h>
+#include <zix/status.h>
+#include <zix/string_view.h>
+
+#if USE_INOTIFY
+#  include "errno_status.h"
+
+#  include <errno.h>
+#  include <limits.h>
+#  include <poll.h>
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#endif
+
+#if USE_NANOSLEEP
+#  include <time.h>
+#elif defined(_WIN32)
+#  include <windows.h>
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NS_PER_SECOND 1000000000U
+#define NO_NAME SIZE_MAX
+
+#if USE_INOTIFY
+#  define INOTIFY_BUFFER_SIZE 4096U
+#  define INOTIFY_MASK                                                  \
+    (IN_ATTRIB | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MODIFY |   \
+     IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#endif
+
+/// An event in a batch, with names stored as offsets into the batch names
+typedef struct {
+  ZixDirEventType type;     ///< Kind of change
+  size_t          name;     ///< Offset of the name
+  size_t          old_name; ///< Offset of the old name, or NO_NAME
+  uint32_t        cookie;   ///< Inotify cookie to pair a move, or zero
+} Event;
+
+/// Events that have been collected but not yet read
+typedef struct {
+  Event*       events;      ///< Array of events
+  ZixDirEvent* views;       ///< Array of events with names, for reading
+  size_t       n_events;    ///< Number of events
+  size_t       n_read;      ///< Number of events that have been read
+  size_t       events_size; ///< Capacity of events and views
+  char*        names;       ///< Null-terminated names of every event
+  size_t       names_len;   ///< Total length of names
+  size_t       names_size;  ///< Capacity of names
+} Batch;
+
+/// The files in a directory when it was last scanned, sorted by name
+typedef struct {
+  char**         names;    ///< Array of file names
+  ZixFileStatus* statuses; ///< Array of file statuses
+  size_t         n_files;  ///< Number of files
+  size_t         size;     ///< Capacity of names
+} Scan;
+
+struct ZixDirWatcherImpl {
+  ZixAllocator* allocator; ///< Allocator for the watcher and buffers
+  char*         path;      ///< Path to the watched directory
+  Batch         batch;     ///< Pending events
+  Scan          scan;      ///< Files at the last scan, if polling
+  ZixStatus     status;    ///< Status to return once the batch is read
+  int           fd;        ///< Inotify descriptor, or -1 if polling
+  bool          gone;      ///< True if the directory itself was removed
+};
+
+/// Grow an array to fit at least `count` elements, or return null
+static void*
+grow(ZixAllocator* const allocator,
+     void* const         array,
+     size_t* const       size,
+     const size_t        count,
+     const size_t        elem_size)
+{
+  if (count <= *size) {
+    return array;
+  }
+
+  size_t new_size = *size ? *size : 16U;
+  while (new_size < count) {
+    new_size *= 2U;
+  }
+
+  void* const new_array = zix_realloc(allocator, array, new_size * elem_size);
+  if (new_array) {
+    *size = new_size;
+  }
+
+  return new_array;
+}
+
+static void
+clear_batch(Batch* const batch)
+{
+  batch->n_events  = 0U;
+  batch->n_read    = 0U;
+  batch->names_len = 0U;
+}
+
+static void
+free_batch(ZixAllocator* const allocator, Batch* const batch)
+{
+  zix_free(allocator, batch->names);
+  zix_free(allocator, batch->views);
+  zix_free(allocator, batch->events);
+}
+
+static ZixStatus
+push_name(ZixAllocator* const allocator,
+          Batch* const        batch,
+          const char* const   name,
+          size_t* const       offset)
+{
+  const size_t len = strlen(name);
+  const size_t end = batch->names_len + len + 1U;
+
+  char* const names =
+    (char*)grow(allocator, batch->names, &batch->names_size, end, 1U);
+  if (!names) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  memcpy(names + batch->names_len, name, len + 1U);
+  batch->names     = names;
+  *offset          = batch->names_len;
+  batch->names_len = end;
+  return ZIX_STATUS_SUCCESS;
+}
+
+/// Return true if a modification is redundant with an earlier event
+static bool
+is_modified(const Batch* const batch, const char* const name)
+{
+  for (size_t i = batch->n_events; i-- > batch->n_read;) {
+    const Event* const event = &batch->events[i];
+    if (!strcmp(batch->names + event->name, name)) {
+      return event->type != ZIX_DIR_EVENT_DELETED;
+    }
+  }
+
+  return false;
+}
+
+static ZixStatus
+push_event(ZixDirWatcher* const  watcher,
+           const ZixDirEventType type,
+           const char* const     name,
+           const char* const     old_name,
+           const uint32_t        cookie)
+{
+  ZixAllocator* const allocator = watcher->allocator;
+  Batch* const        batch     = &watcher->batch;
+
+  if (type == ZIX_DIR_EVENT_MODIFIED && is_modified(batch, name)) {
+    return ZIX_STATUS_SUCCESS;
+  }
+
+  // Grow the arrays of events and views, which always have the same capacity
+  const size_t count = batch->n_events + 1U;
+  size_t       size  = batch->events_size;
+  Event* const events =
+    (Event*)grow(allocator, batch->events, &size, count, sizeof(Event));
+  if (!events) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  batch->events = events;
+
+  ZixDirEvent* const views = (ZixDirEvent*)grow(
+    allocator, batch->views, &batch->events_size, count, sizeof(ZixDirEvent));
+  if (!views) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  batch->views = views;
+
+  Event* const event = &events[batch->n_events];
+  ZixStatus    st    = ZIX_STATUS_SUCCESS;
+  event->type        = type;
+  event->old_name    = NO_NAME;
+  event->cookie      = cookie;
+  if ((st = push_name(allocator, batch, name, &event->name)) ||
+      (old_name &&
+       (st = push_name(allocator, batch, old_name, &event->old_name)))) {
+    return st;
+  }
+
+  ++batch->n_events;
+  return ZIX_STATUS_SUCCESS;
+}
+
+/// Make views of the unread events in a batch, with pointers to their names
+static const ZixDirEvent*
+view_events(Batch* const batch)
+{
+  for (size_t i = batch->n_read; i < batch->n_events; ++i) {
+    const Event* const event = &batch->events[i];
+    ZixDirEvent* const view  = &batch->views[i];
+
+    view->type     = event->type;
+    view->name     = batch->names + event->name;
+    view->old_name = (event->old_name == NO_NAME)
+                       ? NULL
+                       : batch->names + event->old_name;
+  }
+
+  return batch->views + batch->n_read;
+}
+
+/*
+  Polling
+*/
+
+static void
+free_scan(ZixAllocator* const allocator, Scan* const scan)
+{
+  for (size_t i = 0U; i < scan->n_files; ++i) {
+    zix_free(allocator, scan->names[i]);
+  }
+
+  zix_free(allocator, scan->statuses);
+  zix_free(allocator, scan->names);
+}
+
+typedef struct {
+  ZixAllocator* allocator; ///< Allocator for names
+  Scan*         scan;      ///< Scan to add names to
+  ZixStatus     status;    ///< First error
+} ScanState;
+
+static void
+scan_entry(const char* const path, const char* const name, void* const data)
+{
+  ScanState* const state = (ScanState*)data;
+  Scan* const      scan  = state->scan;
+
+  (void)path;
+
+  if (state->status) {
+    return;
+  }
+
+  ZixAllocator* const allocator = state->allocator;
+  const size_t        count     = scan->n_files + 1U;
+  char** const        names =
+    (char**)grow(allocator, scan->names, &scan->size, count, sizeof(char*));
+  if (!names) {
+    state->status = ZIX_STATUS_NO_MEM;
+    return;
+  }
+
+  scan->names = names;
+  if (!(names[scan->n_files] =
+          zix_string_view_copy(allocator, zix_string(name)))) {
+    state->status = ZIX_STATUS_NO_MEM;
+    return;
+  }
+
+  ++scan->n_files;
+}
+
+static int
+compare_names(const void* const a, const void* const b)
+{
+  return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static ZixStatus
+scan_dir(ZixDirWatcher* const watcher, Scan* const scan)
+{
+  ZixAllocator* const allocator = watcher->allocator;
+
+  // List the names of files in the directory, sorted so scans can be merged
+  ScanState state = {allocator, scan, ZIX_STATUS_SUCCESS};
+  ZixStatus st    = zix_system_dir_for_each(watcher->path, &state, scan_entry);
+  if (st || (st = state.status) || !scan->n_files) {
+    return st;
+  }
+
+  qsort(scan->names, scan->n_files, sizeof(char*), compare_names);
+
+  // Make the path to every file
+  char** const paths =
+    (char**)zix_calloc(allocator, scan->n_files, sizeof(char*));
+  if (!paths) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  for (size_t i = 0U; !st && i < scan->n_files; ++i) {
+    if (!(paths[i] = zix_path_join(allocator, watcher->path, scan->names[i]))) {
+      st = ZIX_STATUS_NO_MEM;
+    }
+  }
+
+  // Get the status of every file in one batch
+  if (!st) {
+    scan->statuses = (ZixFileStatus*)zix_calloc(
+      allocator, scan->n_files, sizeof(ZixFileStatus));
+    if (!scan->statuses) {
+      st = ZIX_STATUS_NO_MEM;
+    } else {
+      // Files that have disappeared since being listed have type none
+      zix_file_status_many(
+        scan->n_files, (const char* const*)paths, scan->statuses);
+    }
+  }
+
+  for (size_t i = 0U; i < scan->n_files; ++i) {
+    zix_free(allocator, paths[i]);
+  }
+
+  zix_free(allocator, paths);
+  return st;
+}
+
+static bool
+status_changed(const ZixFileStatus* const a, const ZixFileStatus* const b)
+{
+  return a->type != b->type || a->size != b->size ||
+         a->modified != b->modified || a->inode != b->inode ||
+         a->device != b->device;
+}
+
+static bool
+same_file(const ZixFileStatus* const a, const ZixFileStatus* const b)
+{
+  return a->type != ZIX_FILE_TYPE_NONE && a->type == b->type &&
+         (a->inode || a->device) && a->inode == b->inode &&
+         a->device == b->device;
+}
+
+static ZixStatus
+diff_scans(ZixDirWatcher* const watcher,
+           const Scan* const    old_scan,
+           const Scan* const    new_scan)
+{
+  const size_t n_old = old_scan->n_files;
+  const size_t n_new = new_scan->n_files;
+
+  // Allocate arrays for the indices of deleted and created files
+  size_t* const indices = (size_t*)zix_calloc(
+    watcher->allocator, n_old + n_new + 1U, sizeof(size_t));
+  if (!indices) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  size_t* const deleted   = indices;
+  size_t* const created   = indices + n_old;
+  size_t        n_deleted = 0U;
+  size_t        n_created = 0U;
+
+  // Merge the sorted scans to find modified, deleted, and created files
+  ZixStatus st = ZIX_STATUS_SUCCESS;
+  size_t    i  = 0U;
+  size_t    j  = 0U;
+  while (!st && (i < n_old || j < n_new)) {
+    const int cmp = (i == n_old)   ? 1
+                    : (j == n_new) ? -1
+                                   : strcmp(old_scan->names[i],
+                                            new_scan->names[j]);
+    if (cmp < 0) {
+      deleted[n_deleted++] = i++;
+    } else if (cmp > 0) {
+      created[n_created++] = j++;
+    } else {
+      if (status_changed(&old_scan->statuses[i], &new_scan->statuses[j])) {
+        st = push_event(watcher,
+                        ZIX_DIR_EVENT_MODIFIED,
+                        new_scan->names[j],
+                        NULL,
+                        0U);
+      }
+
+      ++i;
+      ++j;
+    }
+  }
+
+  // Report created files, or renames if a deleted file is the same file
+  for (size_t c = 0U; !st && c < n_created; ++c) {
+    const size_t         n      = created[c];
+    const ZixFileStatus* status = &new_scan->statuses[n];
+    const char*          from   = NULL;
+    for (size_t d = 0U; d < n_deleted; ++d) {
+      const size_t o = deleted[d];
+      if (o != NO_NAME && same_file(&old_scan->statuses[o], status)) {
+        from       = old_scan->names[o];
+        deleted[d] = NO_NAME;
+        break;
+      }
+    }
+
+    st = push_event(watcher,
+                    from ? ZIX_DIR_EVENT_RENAMED : ZIX_DIR_EVENT_CREATED,
+                    new_scan->names[n],
+                    from,
+                    0U);
+  }
+
+  // Report deleted files that weren't renamed
+  for (size_t d = 0U; !st && d < n_deleted; ++d) {
+    if (deleted[d] != NO_NAME) {
+      st = push_event(
+        watcher, ZIX_DIR_EVENT_DELETED, old_scan->names[deleted[d]], NULL, 0U);
+    }
+  }
+
+  zix_free(watcher->allocator, indices);
+  return st;
+}
+
+static ZixStatus
+poll_dir(ZixDirWatcher* const watcher)
+{
+  // If the directory is gone, then report everything in it as deleted
+  const bool gone = zix_file_type(watcher->path) != ZIX_FILE_TYPE_DIRECTORY;
+
+  Scan      scan = {NULL, NULL, 0U, 0U};
+  ZixStatus st   = gone ? ZIX_STATUS_SUCCESS : scan_dir(watcher, &scan);
+  if (st || (st = diff_scans(watcher, &watcher->scan, &scan))) {
+    free_scan(watcher->allocator, &scan);
+    return st;
+  }
+
+  free_scan(watcher->allocator, &watcher->scan);
+  watcher->scan = scan;
+  watcher->gone = gone;
+  return gone ? ZIX_STATUS_NOT_FOUND : ZIX_STATUS_SUCCESS;
+}
+
+/*
+  Inotify
+*/
+
+#if USE_INOTIFY
+
+static ZixStatus
+push_moved_to(ZixDirWatcher* const watcher,
+              const char* const    name,
+              const uint32_t       cookie)
+{
+  Batch* const batch = &watcher->batch;
+
+  // Turn the matching move from this directory into a rename if there is one
+  for (size_t i = batch->n_events; cookie && i-- > batch->n_read;) {
+    Event* const event = &batch->events[i];
+    if (event->cookie == cookie) {
+      size_t          offset = 0U;
+      const ZixStatus st =
+        push_name(watcher->allocator, batch, name, &offset);
+
+      if (!st) {
+        event->type     = ZIX_DIR_EVENT_RENAMED;
+        event->old_name = event->name;
+        event->name     = offset;
+        event->cookie   = 0U;
+      }
+
+      return st;
+    }
+  }
+
+  return push_event(watcher, ZIX_DIR_EVENT_CREATED, name, NULL, 0U);
+}
+
+static ZixStatus
+push_inotify_event(ZixDirWatcher* const              watcher,
+                   const struct inotify_event* const event)
+{
+  const uint32_t mask = event->mask;
+
+  if (mask & (IN_DELETE_SELF | IN_IGNORED | IN_MOVE_SELF | IN_UNMOUNT)) {
+    watcher->gone = true;
+  }
+
+  if (!event->len) {
+    return ZIX_STATUS_SUCCESS;
+  }
+
+  const char* const name = event->name;
+  if (mask & IN_CREATE) {
+    return push_event(watcher, ZIX_DIR_EVENT_CREATED, name, NULL, 0U);
+  }
+
+  if (mask & IN_DELETE) {
+    return push_event(watcher, ZIX_DIR_EVENT_DELETED, name, NULL, 0U);
+  }
+
+  if (mask & IN_MOVED_FROM) {
+    // Report a deletion which may become a rename if it was moved to here
+    return push_event(
+      watcher, ZIX_DIR_EVENT_DELETED, name, NULL, event->cookie);
+  }
+
+  if (mask & IN_MOVED_TO) {
+    return push_moved_to(watcher, name, event->cookie);
+  }
+
+  if (mask & (IN_ATTRIB | IN_MODIFY)) {
+    return push_event(watcher, ZIX_DIR_EVENT_MODIFIED, name, NULL, 0U);
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+static ZixStatus
+read_inotify(ZixDirWatcher* const watcher)
+{
+  union {
+    struct inotify_event event;
+    char                 bytes[INOTIFY_BUFFER_SIZE];
+  } buf;
+
+  bool      overflow = false;
+  ZixStatus st       = ZIX_STATUS_SUCCESS;
+  while (!st) {
+    const ssize_t r = read(watcher->fd, buf.bytes, sizeof(buf.bytes));
+    if (r < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+#  if EAGAIN != EWOULDBLOCK
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+#  else
+      if (errno != EAGAIN) {
+#  endif
+        st = zix_errno_status(errno);
+      }
+
+      break;
+    }
+
+    if (!r) {
+      break;
+    }
+
+    // Read every complete event in the buffer (the kernel never splits them)
+    for (size_t offset = 0U; !st && offset < (size_t)r;) {
+      const struct inotify_event* const event =
+        (const struct inotify_event*)(const void*)(buf.bytes + offset);
+
+      overflow = overflow || (event->mask & IN_Q_OVERFLOW);
+      st       = push_inotify_event(watcher, event);
+      offset += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  return st              ? st
+         : watcher->gone ? ZIX_STATUS_NOT_FOUND
+         : overflow      ? ZIX_STATUS_OVERFLOW
+                         : ZIX_STATUS_SUCCESS;
+}
+
+static ZixStatus
+wait_inotify(ZixDirWatcher* const watcher,
+             const uint32_t       seconds,
+             const uint32_t       nanoseconds)
+{
+  const uint64_t ms = ((uint64_t)seconds * 1000U) +
+                      (((uint64_t)nanoseconds + 999999U) / 1000000U);
+
+  struct pollfd pfd = {watcher->fd, POLLIN, 0};
+
+  const int r = poll(&pfd, 1U, ms > INT_MAX ? INT_MAX : (int)ms);
+  if (r < 0) {
+    return (errno == EINTR) ? ZIX_STATUS_SUCCESS : zix_errno_status(errno);
+  }
+
+  return r ? ZIX_STATUS_SUCCESS : ZIX_STATUS_TIMEOUT;
+}
+
+#endif // USE_INOTIFY
+
+/*
+  API
+*/
+
+ZixDirWatcher*
+zix_dir_watcher_new(ZixAllocator* const      allocator,
+                    const char* const        path,
+                    const ZixDirWatchOptions options)
+{
+  if (zix_file_type(path) != ZIX_FILE_TYPE_DIRECTORY) {
+    return NULL;
+  }
+
+  ZixDirWatcher* const watcher =
+    (ZixDirWatcher*)zix_calloc(allocator, 1U, sizeof(ZixDirWatcher));
+  if (!watcher) {
+    return NULL;
+  }
+
+  watcher->allocator = allocator;
+  watcher->fd        = -1;
+  if (!(watcher->path = zix_string_view_copy(allocator, zix_string(path)))) {
+    zix_free(allocator, watcher);
+    return NULL;
+  }
+
+#if USE_INOTIFY
+  // Use inotify if possible, but fall back to polling (e.g. if out of watches)
+  if (!(options & ZIX_DIR_WATCH_POLL)) {
+    const int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd >= 0 && inotify_add_watch(fd, path, INOTIFY_MASK) >= 0) {
+      watcher->fd = fd;
+      return watcher;
+    }
+
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#else
+  (void)options;
+#endif
+
+  // Take an initial scan to compare the first poll with
+  if (scan_dir(watcher, &watcher->scan)) {
+    zix_dir_watcher_free(watcher);
+    return NULL;
+  }
+
+  return watcher;
+}
+
+void
+zix_dir_watcher_free(ZixDirWatcher* const watcher)
+{
+  if (watcher) {
+#if USE_INOTIFY
+    if (watcher->fd >= 0) {
+      close(watcher->fd);
+    }
+#endif
+
+    free_scan(watcher->allocator, &watcher->scan);
+    free_batch(watcher->allocator, &watcher->batch);
+    zix_free(watcher->allocator, watcher->path);
+    zix_free(watcher->allocator, watcher);
+  }
+}
+
+ZixStatus
+zix_dir_watcher_wait(ZixDirWatcher* const watcher,
+                     const uint32_t       seconds,
+                     const uint32_t       nanoseconds)
+{
+  if (watcher->gone || watcher->batch.n_read < watcher->batch.n_events) {
+    return ZIX_STATUS_SUCCESS;
+  }
+
+#if USE_INOTIFY
+  if (watcher->fd >= 0) {
+    return wait_inotify(watcher, seconds, nanoseconds);
+  }
+#endif
+
+#if USE_NANOSLEEP
+  const struct timespec duration = {
+    (time_t)(seconds + (nanoseconds / NS_PER_SECOND)),
+    (long)(nanoseconds % NS_PER_SECOND)};
+  nanosleep(&duration, NULL);
+#elif defined(_WIN32)
+  Sleep((DWORD)(((uint64_t)seconds * 1000U) +
+                (((uint64_t)nanoseconds + 999999U) / 1000000U)));
+#else
+  (void)seconds;
+  (void)nanoseconds;
+#endif
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+/**
+   Collect new events if all the pending ones have been read.
+
+   The status of collecting the batch is kept until it has been read, so that
+   it isn't lost if only some events are read at a time.
+*/
+static void
+collect_events(ZixDirWatcher* const watcher)
+{
+  Batch* const batch = &watcher->batch;
+  if (batch->n_read < batch->n_events) {
+    return;
+  }
+
+  clear_batch(batch);
+  if (watcher->gone) {
+    watcher->status = ZIX_STATUS_NOT_FOUND;
+    return;
+  }
+
+#if USE_INOTIFY
+  if (watcher->fd >= 0) {
+    watcher->status = read_inotify(watcher);
+    return;
+  }
+#endif
+
+  watcher->status = poll_dir(watcher);
+}
+
+/// Return the status of a batch that has been completely read
+static ZixStatus
+finish_batch(ZixDirWatcher* const watcher)
+{
+  const ZixStatus st = watcher->status;
+
+  watcher->status = ZIX_STATUS_SUCCESS;
+  return st;
+}
+
+ZixStatus
+zix_dir_watcher_read(ZixDirWatcher* const   watcher,
+                     const ZixDirEventsFunc f,
+                     void* const            data)
+{
+  Batch* const batch = &watcher->batch;
+
+  collect_events(watcher);
+  if (batch->n_read < batch->n_events) {
+    f(data, batch->n_events - batch->n_read, view_events(batch));
+    batch->n_read = batch->n_events;
+  }
+
+  return finish_batch(watcher);
+}
+
+ZixStatus
+zix_dir_watcher_read_ring(ZixDirWatcher* const watcher, ZixRing* const ring)
+{
+  Batch* const batch = &watcher->batch;
+
+  collect_events(watcher);
+
+  const ZixDirEvent* const events = view_events(batch);
+  for (size_t i = 0U; batch->n_read < batch->n_events; ++i) {
+    const ZixDirEvent* const event    = &events[i];
+    const char* const        old_name = event->old_name;
+
+    const ZixDirEventHeader header = {
+      (uint32_t)event->type,
+      (uint32_t)strlen(event->name) + 1U,
+      old_name ? (uint32_t)strlen(old_name) + 1U : 0U};
+
+    // Discard events that could never fit, rather than getting stuck on them
+    const size_t record_size =
+      sizeof(header) + header.name_size + header.old_name_size;
+    if (record_size > zix_ring_capacity(ring)) {
+      if (!watcher->status) {
+        watcher->status = ZIX_STATUS_OVERFLOW;
+      }
+
+      ++batch->n_read;
+      continue;
+    }
+
+    // Write the event as a single record, or stop if the ring is full
+    ZixRingTransaction tx = zix_ring_begin_write(ring);
+    if (zix_ring_amend_write(ring, &tx, &header, sizeof(header)) ||
+        zix_ring_amend_write(ring, &tx, event->name, header.name_size) ||
+        (old_name &&
+         zix_ring_amend_write(ring, &tx, old_name, header.old_name_size))) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    zix_ring_commit_write(ring, &tx);
+    ++batch->n_read;
+  }
+
+  return finish_batch(watcher);
+}
@@ -3,11 +3,21 @@
 
 #include <zix/filesystem.h>
 
+#include "atomic.h"
+#include "errno_status.h"
 #include "path_iter.h"
 #include "system.h"
+#include "uring.h"
+#include "zix_config.h"
 
 #include <zix/allocator.h>
+#include <zix/path.h>
 #include <zix/status.h>
+#include <zix/string_view.h>
+
+#if USE_THREADS
+#  include <zix/thread.h>
+#endif
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -15,8 +25,14 @@
 
 #include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#define COPY_THREAD_STACK_SIZE 65536U   ///< Stack size of tree copy threads
+#define MIN_MAP_COMPARE_SIZE 0x100000U ///< Minimum size to compare mapped files
+#define MIN_URING_TRANSFERS 128U       ///< Minimum batch size to use io_uring
+
 ZixStatus
 zix_create_directories(ZixAllocator* const allocator,
                        const char* const   dir_path)
@@ -84,6 +100,63 @@ full_read(const int fd, void* const buf, const size_t count)
   return (ssize_t)n;
 }
 
+// Compare open files of equal size by mapping them, or return false if not
+static bool
+compare_mapped(const int    fd_a,
+               const int    fd_b,
+               const size_t size,
+               bool* const  match)
+{
+  void* const data_a = zix_system_map_file(fd_a, size);
+  void* const data_b = data_a ? zix_system_map_file(fd_b, size) : NULL;
+  const bool  mapped = data_a && data_b;
+
+  if (mapped) {
+    *match = !memcmp(data_a, data_b, size);
+  }
+
+  zix_system_unmap_file(data_b, size);
+  zix_system_unmap_file(data_a, size);
+  return mapped;
+}
+
+// Compare open files of equal size by reading them a block at a time
+static bool
+compare_blocks(ZixAllocator* const      allocator,
+               const int                fd_a,
+               const int                fd_b,
+               const struct stat* const stat_a,
+               const struct stat* const stat_b)
+{
+#if USE_POSIX_FADVISE
+  (void)posix_fadvise(fd_a, 0, stat_a->st_size, POSIX_FADV_SEQUENTIAL);
+  (void)posix_fadvise(fd_b, 0, stat_b->st_size, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  // Allocate two blocks in a single buffer (to simplify error handling)
+  const uint32_t align  = zix_system_page_size();
+  const uint32_t size   = zix_system_max_block_size(stat_a, stat_b, align);
+  BlockBuffer    blocks = zix_system_new_block(allocator, align, 2U * size);
+  void* const    data   = blocks.buffer ? blocks.buffer : blocks.fallback;
+
+  // Compare files a block at a time
+  const uint32_t block_size = blocks.size / 2U;
+  void* const    block_a    = data;
+  void* const    block_b    = (void*)((char*)data + block_size);
+  bool           match      = true;
+  for (ssize_t n = 0; n < stat_a->st_size && match;) {
+    const ssize_t r = zix_system_read(fd_a, block_a, block_size);
+    if (r <= 0 || full_read(fd_b, block_b, (uint32_t)r) != r ||
+        !!memcmp(block_a, block_b, (size_t)r)) {
+      match = false;
+    }
+    n += r;
+  }
+
+  zix_system_free_block(allocator, blocks);
+  return match;
+}
+
 bool
 zix_file_equals(ZixAllocator* const allocator,
                 const char* const   path_a,
@@ -111,29 +184,370 @@ zix_file_equals(ZixAllocator* const allocator,
     match = true; // Fast path: paths refer to the same file
   } else if (stat_a.st_size == stat_b.st_size) {
     // Slow path: files have equal size, compare contents
+    const uintmax_t size = (uintmax_t)stat_a.st_size;
+    if (size < MIN_MAP_COMPARE_SIZE || size > SIZE_MAX ||
+        !compare_mapped(fd_a, fd_b, (size_t)size, &match)) {
+      match = compare_blocks(allocator, fd_a, fd_b, &stat_a, &stat_b);
+    }
+  }
 
-    // Allocate two blocks in a single buffer (to simplify error handling)
-    const uint32_t align  = zix_system_page_size();
-    const uint32_t size   = zix_system_max_block_size(&stat_a, &stat_b, align);
-    BlockBuffer    blocks = zix_system_new_block(allocator, align, 2U * size);
-    void* const    data   = blocks.buffer ? blocks.buffer : blocks.fallback;
-
-    // Compare files a block at a time
-    const uint32_t block_size = blocks.size / 2U;
-    void* const    block_a    = data;
-    void* const    block_b    = (void*)((char*)data + block_size);
-    match                     = true;
-    for (ssize_t n = 0; n < stat_a.st_size && match;) {
-      const ssize_t r = zix_system_read(fd_a, block_a, block_size);
-      if (r <= 0 || full_read(fd_b, block_b, (uint32_t)r) != r ||
-          !!memcmp(block_a, block_b, (size_t)r)) {
-        match = false;
-      }
-      n += r;
+  return !zix_system_close_fds(fd_b, fd_a) && match;
+}
+
+static void
+transfer_file(ZixFileTransfer* const transfer)
+{
+  const bool write = transfer->type == ZIX_FILE_TRANSFER_WRITE;
+  const int  flags = write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+  const int  fd    = zix_system_open(transfer->path, flags, 0644);
+
+  transfer->n_bytes = 0U;
+  if (fd < 0) {
+    transfer->status = zix_errno_status(errno);
+    return;
+  }
+
+  ssize_t r = 1;
+  while (transfer->n_bytes < transfer->size && r > 0) {
+    char* const  buf   = (char*)transfer->buffer + transfer->n_bytes;
+    const size_t count = transfer->size - transfer->n_bytes;
+
+    r = write ? zix_system_write(fd, buf, count)
+              : zix_system_read(fd, buf, count);
+    if (r > 0) {
+      transfer->n_bytes += (size_t)r;
     }
+  }
 
-    zix_system_free_block(allocator, blocks);
+  transfer->status = (r < 0) ? zix_errno_status(errno)
+                     : (write && transfer->n_bytes < transfer->size)
+                       ? ZIX_STATUS_ERROR
+                       : ZIX_STATUS_SUCCESS;
+
+  if (zix_system_close(fd) && !transfer->status) {
+    transfer->status = zix_errno_status(errno);
   }
+}
 
-  return !zix_system_close_fds(fd_b, fd_a) && match;
+ZixStatus
+zix_transfer_files(const size_t n_transfers, ZixFileTransfer* const transfers)
+{
+  // Try to submit large batches at once, since setting up a ring costs about
+  // as much as reading a hundred small cached files, or do one at a time
+  if (n_transfers < MIN_URING_TRANSFERS ||
+      zix_uring_transfer_files(n_transfers, transfers)) {
+    for (size_t i = 0U; i < n_transfers; ++i) {
+      transfer_file(&transfers[i]);
+    }
+  }
+
+  for (size_t i = 0U; i < n_transfers; ++i) {
+    if (transfers[i].status) {
+      return transfers[i].status;
+    }
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+ZixStatus
+zix_file_status_many(const size_t             n_paths,
+                     const char* const* const paths,
+                     ZixFileStatus* const     statuses)
+{
+  // Query one at a time, since stat() is faster than a ring of statx requests
+  ZixStatus first_error = ZIX_STATUS_SUCCESS;
+  for (size_t i = 0U; i < n_paths; ++i) {
+    const ZixStatus st = zix_file_status(paths[i], &statuses[i]);
+    if (st && !first_error) {
+      first_error = st;
+    }
+  }
+
+  return first_error;
+}
+
+/// A file to copy as part of a tree
+typedef struct {
+  char* src; ///< Path to source file
+  char* dst; ///< Path to destination file
+} TreeCopyJob;
+
+/// The state of copying a tree, shared between all threads
+typedef struct {
+  ZixAllocator*  allocator;  ///< Allocator for paths and copy buffers
+  ZixCopyOptions options;    ///< Options for copying directories and files
+  const char*    dst;        ///< Path to destination root directory
+  size_t         src_prefix; ///< Length of root prefix of walked source paths
+  TreeCopyJob*   jobs;       ///< Array of files to copy
+  size_t         n_jobs;     ///< Number of files to copy
+  size_t         capacity;   ///< Allocated size of jobs array
+  char**         dirs;       ///< Array of destination subdirectories
+  size_t         n_dirs;     ///< Number of destination subdirectories
+  size_t         dirs_size;  ///< Allocated size of dirs array
+  uint64_t       next_job;   ///< Index of the next job to start
+  uint32_t       status;     ///< First error, or success
+} TreeCopy;
+
+static void
+set_tree_copy_status(TreeCopy* const copy, const ZixStatus status)
+{
+  uint32_t success = 0U;
+  (void)zix_atomic_cas(&copy->status, &success, (uint32_t)status);
+}
+
+static ZixStatus
+copy_tree_directory(const TreeCopy* const copy,
+                    const char* const     src,
+                    const char* const     dst)
+{
+  const ZixStatus st = zix_create_directory_like(dst, src);
+
+  return (st == ZIX_STATUS_EXISTS &&
+          (copy->options & ZIX_COPY_OPTION_OVERWRITE_EXISTING) &&
+          zix_file_type(dst) == ZIX_FILE_TYPE_DIRECTORY)
+           ? ZIX_STATUS_SUCCESS
+           : st;
+}
+
+static ZixStatus
+copy_tree_link(const TreeCopy* const copy,
+               const char* const     src,
+               const char* const     dst)
+{
+  ZixStatus st = zix_system_copy_link(copy->allocator, src, dst);
+
+  // Replace an existing link or file, but never a directory
+  if (st == ZIX_STATUS_EXISTS &&
+      (copy->options & ZIX_COPY_OPTION_OVERWRITE_EXISTING) &&
+      zix_symlink_type(dst) != ZIX_FILE_TYPE_DIRECTORY &&
+      !(st = zix_remove(dst))) {
+    st = zix_system_copy_link(copy->allocator, src, dst);
+  }
+
+  return st;
+}
+
+static ZixStatus
+push_tree_copy_job(TreeCopy* const copy, char* const src, char* const dst)
+{
+  if (copy->n_jobs == copy->capacity) {
+    const size_t       capacity = copy->capacity ? (copy->capacity * 2U) : 64U;
+    TreeCopyJob* const jobs     = (TreeCopyJob*)zix_realloc(
+      copy->allocator, copy->jobs, capacity * sizeof(TreeCopyJob));
+    if (!jobs) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    copy->jobs     = jobs;
+    copy->capacity = capacity;
+  }
+
+  copy->jobs[copy->n_jobs].src = src;
+  copy->jobs[copy->n_jobs].dst = dst;
+  ++copy->n_jobs;
+  return ZIX_STATUS_SUCCESS;
+}
+
+static ZixStatus
+push_tree_copy_dir(TreeCopy* const copy, char* const dst)
+{
+  if (copy->n_dirs == copy->dirs_size) {
+    const size_t size = copy->dirs_size ? (copy->dirs_size * 2U) : 16U;
+    char** const dirs =
+      (char**)zix_realloc(copy->allocator, copy->dirs, size * sizeof(char*));
+    if (!dirs) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    copy->dirs      = dirs;
+    copy->dirs_size = size;
+  }
+
+  copy->dirs[copy->n_dirs++] = dst;
+  return ZIX_STATUS_SUCCESS;
+}
+
+static ZixStatus
+visit_tree_entry(void* const data, const ZixDirWalkEntry* const entry)
+{
+  TreeCopy* const copy = (TreeCopy*)data;
+
+  // Every walked path starts with the same prefix as the first top-level one
+  if (entry->depth == 1U) {
+    copy->src_prefix = (size_t)(entry->name - entry->path);
+  }
+
+  char* const dst = zix_path_join(
+    copy->allocator, copy->dst, entry->path + copy->src_prefix);
+  if (!dst) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  // Directories are visited before their contents, so create them now
+  ZixStatus st = ZIX_STATUS_SUCCESS;
+  if (entry->type == ZIX_FILE_TYPE_DIRECTORY) {
+    if (!(st = copy_tree_directory(copy, entry->path, dst)) &&
+        !(st = push_tree_copy_dir(copy, dst))) {
+      return st; // Destination path is now owned by the copy
+    }
+  } else if (entry->type == ZIX_FILE_TYPE_REGULAR) {
+    char* const src =
+      zix_string_view_copy(copy->allocator, zix_string(entry->path));
+    if (!src) {
+      st = ZIX_STATUS_NO_MEM;
+    } else if (!(st = push_tree_copy_job(copy, src, dst))) {
+      return st; // Paths are now owned by the job
+    }
+
+    zix_free(copy->allocator, src);
+  } else if (entry->type == ZIX_FILE_TYPE_SYMLINK) {
+    st = copy_tree_link(copy, entry->path, dst);
+  }
+
+  zix_free(copy->allocator, dst);
+  return st;
+}
+
+static void
+run_tree_copy_jobs(TreeCopy* const copy)
+{
+  while (!zix_atomic_load(&copy->status)) {
+    const uint64_t i = zix_atomic_add64(&copy->next_job, 1U);
+    if (i >= copy->n_jobs) {
+      break;
+    }
+
+    const TreeCopyJob* const job = &copy->jobs[i];
+    const ZixStatus          st =
+      zix_copy_file(copy->allocator, job->src, job->dst, copy->options);
+    if (st) {
+      set_tree_copy_status(copy, st);
+    }
+  }
+}
+
+static ZixStatus
+sync_tree_copy(const TreeCopy* const copy, const char* const dst)
+{
+  // Sync all files first, then the directories that contain them
+  ZixStatus st = ZIX_STATUS_SUCCESS;
+  if (copy->n_jobs) {
+    const char** const paths = (const char**)zix_malloc(
+      copy->allocator, copy->n_jobs * sizeof(const char*));
+    if (!paths) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    for (size_t i = 0U; i < copy->n_jobs; ++i) {
+      paths[i] = copy->jobs[i].dst;
+    }
+
+    st = zix_sync_files(copy->n_jobs, paths, copy->options);
+    zix_free(copy->allocator, paths);
+  }
+
+  if (!st) {
+    st = zix_sync_files(
+      copy->n_dirs, (const char* const*)copy->dirs, copy->options);
+  }
+
+  return st ? st : zix_sync_files(1U, &dst, copy->options);
+}
+
+#if USE_THREADS
+
+static ZixThreadResult ZIX_THREAD_FUNC
+tree_copy_thread(void* const arg)
+{
+  run_tree_copy_jobs((TreeCopy*)arg);
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+run_tree_copy_threads(TreeCopy* const copy, const unsigned n_threads)
+{
+  // Launch extra threads, but never more than there are files to copy
+  size_t n_extra = n_threads - 1U;
+  if (n_extra > copy->n_jobs) {
+    n_extra = copy->n_jobs;
+  }
+
+  ZixThread* const threads =
+    (ZixThread*)zix_calloc(copy->allocator, n_extra, sizeof(ZixThread));
+
+  size_t n_launched = 0U;
+  while (threads && n_launched < n_extra &&
+         !zix_thread_create(&threads[n_launched],
+                            COPY_THREAD_STACK_SIZE,
+                            tree_copy_thread,
+                            copy)) {
+    ++n_launched;
+  }
+
+  // Copy in this thread as well, which does everything if no threads launched
+  run_tree_copy_jobs(copy);
+
+  for (size_t i = 0U; i < n_launched; ++i) {
+    zix_thread_join(threads[i]);
+  }
+
+  zix_free(copy->allocator, threads);
+}
+
+#endif
+
+ZixStatus
+zix_copy_tree(ZixAllocator* const  allocator,
+              const char* const    src,
+              const char* const    dst,
+              const ZixCopyOptions options,
+              const unsigned       n_threads)
+{
+  if (zix_file_type(src) != ZIX_FILE_TYPE_DIRECTORY) {
+    return ZIX_STATUS_BAD_ARG;
+  }
+
+  // Copy files without syncing, then sync them all at the end if necessary
+  const ZixCopyOptions file_options = options | ZIX_COPY_OPTION_NO_SYNC;
+
+  TreeCopy copy = {
+    allocator, file_options, dst, 0U, NULL, 0U, 0U, NULL, 0U, 0U, 0U, 0U};
+
+  // Create all directories and links, and gather files to copy
+  ZixStatus st = copy_tree_directory(&copy, src, dst);
+  if (!st) {
+    st = zix_dir_walk(allocator, src, 0U, 1U, visit_tree_entry, &copy);
+  }
+
+  // Copy all files
+  if (!st && !copy.status) {
+#if USE_THREADS
+    if (n_threads > 1U) {
+      run_tree_copy_threads(&copy, n_threads);
+    } else {
+      run_tree_copy_jobs(&copy);
+    }
+#else
+    (void)n_threads;
+    run_tree_copy_jobs(&copy);
+#endif
+
+    if (!copy.status && !(options & ZIX_COPY_OPTION_NO_SYNC)) {
+      st = sync_tree_copy(&copy, dst);
+    }
+  }
+
+  for (size_t i = 0U; i < copy.n_jobs; ++i) {
+    zix_free(allocator, copy.jobs[i].dst);
+    zix_free(allocator, copy.jobs[i].src);
+  }
+
+  for (size_t i = 0U; i < copy.n_dirs; ++i) {
+    zix_free(allocator, copy.dirs[i]);
+  }
+
+  zix_free(allocator, copy.dirs);
+  zix_free(allocator, copy.jobs);
+  return st ? st : (ZixStatus)copy.status;
 }
@@ -7,6 +7,7 @@
 
 #include <zix/allocator.h>
 #include <zix/attributes.h>
+#include <zix/digest.h>
 #include <zix/status.h>
 
 #include <assert.h>
@@ -18,27 +19,31 @@ typedef struct ZixHashEntry {
 } ZixHashEntry;
 
 struct ZixHashImpl {
-  ZixAllocator*   allocator;  ///< User allocator
-  ZixKeyFunc      key_func;   ///< User key accessor
-  ZixHashFunc     hash_func;  ///< User hashing function
-  ZixKeyEqualFunc equal_func; ///< User equality comparison function
-  size_t          count;      ///< Number of records stored in the table
-  size_t          mask;       ///< Bit mask for fast modulo (n_entries - 1)
-  size_t          n_entries;  ///< Power of two table size
-  ZixHashEntry*   entries;    ///< Pointer to dynamically allocated table
+  ZixAllocator*    allocator;       ///< User allocator
+  ZixKeyFunc       key_func;        ///< User key accessor
+  ZixHashFunc      hash_func;       ///< User hashing function, or null
+  ZixKeyedHashFunc keyed_hash_func; ///< User keyed hashing function, or null
+  ZixKeyEqualFunc  equal_func;      ///< User equality comparison function
+  ZixDigestKey     seed;            ///< Seed for keyed_hash_func
+  size_t           reseed_count;    ///< Number of records at last reseed
+  size_t           count;           ///< Number of records stored in the table
+  size_t           mask;            ///< Mask for fast modulo (n_entries - 1)
+  size_t           n_entries;       ///< Power of two table size
+  ZixHashEntry*    entries;         ///< Pointer to dynamically allocated table
 };
 
 static ZIX_CONSTEXPR size_t min_n_entries = 4U;
 static ZIX_CONSTEXPR size_t tombstone     = 0xDEADU;
 
-ZixHash*
-zix_hash_new(ZixAllocator* const   allocator,
-             const ZixKeyFunc      key_func,
-             const ZixHashFunc     hash_func,
-             const ZixKeyEqualFunc equal_func)
+static ZixHash*
+new_hash(ZixAllocator* const    allocator,
+         const ZixKeyFunc       key_func,
+         const ZixHashFunc      hash_func,
+         const ZixKeyedHashFunc keyed_hash_func,
+         const ZixKeyEqualFunc  equal_func)
 {
   assert(key_func);
-  assert(hash_func);
+  assert(hash_func || keyed_hash_func);
   assert(equal_func);
 
   ZixHash* const hash = (ZixHash*)zix_malloc(allocator, sizeof(ZixHash));
@@ -46,13 +51,22 @@ zix_hash_new(ZixAllocator* const   allocator,
     return NULL;
   }
 
-  hash->allocator  = allocator;
-  hash->key_func   = key_func;
-  hash->hash_func  = hash_func;
-  hash->equal_func = equal_func;
-  hash->count      = 0U;
-  hash->n_entries  = min_n_entries;
-  hash->mask       = hash->n_entries - 1U;
+  hash->allocator       = allocator;
+  hash->key_func        = key_func;
+  hash->hash_func       = hash_func;
+  hash->keyed_hash_func = keyed_hash_func;
+  hash->equal_func      = equal_func;
+  hash->seed.k0         = 0U;
+  hash->seed.k1         = 0U;
+  hash->reseed_count    = 0U;
+  hash->count           = 0U;
+  hash->n_entries       = min_n_entries;
+  hash->mask            = hash->n_entries - 1U;
+
+  if (keyed_hash_func && zix_digest_random_key(&hash->seed)) {
+    zix_free(allocator, hash);
+    return NULL;
+  }
 
   hash->entries =
     (ZixHashEntry*)zix_calloc(allocator, hash->n_entries, sizeof(ZixHashEntry));
@@ -65,6 +79,24 @@ zix_hash_new(ZixAllocator* const   allocator,
   return hash;
 }
 
+ZixHash*
+zix_hash_new(ZixAllocator* const   allocator,
+             const ZixKeyFunc      key_func,
+             const ZixHashFunc     hash_func,
+             const ZixKeyEqualFunc equal_func)
+{
+  return new_hash(allocator, key_func, hash_func, NULL, equal_func);
+}
+
+ZixHash*
+zix_hash_new_keyed(ZixAllocator* const    allocator,
+                   const ZixKeyFunc       key_func,
+                   const ZixKeyedHashFunc hash_func,
+                   const ZixKeyEqualFunc  equal_func)
+{
+  return new_hash(allocator, key_func, NULL, hash_func, equal_func);
+}
+
 void
 zix_hash_free(ZixHash* const hash)
 {
@@ -115,6 +147,20 @@ zix_hash_size(const ZixHash* const hash)
   return hash->count;
 }
 
+ZIX_REALTIME const ZixDigestKey*
+zix_hash_seed(const ZixHash* const hash)
+{
+  assert(hash);
+  return hash->keyed_hash_func ? &hash->seed : NULL;
+}
+
+static inline ZixHashCode
+hash_code(const ZixHash* const hash, const ZixHashKey* const key)
+{
+  return hash->keyed_hash_func ? hash->keyed_hash_func(key, &hash->seed)
+                               : hash->hash_func(key);
+}
+
 static inline size_t
 fold_hash(const ZixHashCode h_nomod, const size_t mask)
 {
@@ -163,7 +209,7 @@ find_entry(const ZixHash* const    hash,
 }
 
 static ZixStatus
-rehash(ZixHash* const hash, const size_t old_n_entries)
+rehash(ZixHash* const hash, const size_t old_n_entries, const bool recode)
 {
   ZixHashEntry* const old_entries   = hash->entries;
   const size_t        new_n_entries = hash->n_entries;
@@ -181,14 +227,18 @@ rehash(ZixHash* const hash, const size_t old_n_entries)
 
   // Reinsert every element into the new array
   for (size_t i = 0U; i < old_n_entries; ++i) {
-    const ZixHashEntry* const entry = &old_entries[i];
+    ZixHashEntry entry = old_entries[i];
+
+    if (entry.value) {
+      if (recode) {
+        entry.hash = hash_code(hash, hash->key_func(entry.value));
+      }
 
-    if (entry->value) {
       assert(hash->mask == hash->n_entries - 1U);
-      const size_t new_h = fold_hash(entry->hash, hash->mask);
-      const size_t new_i = find_entry(hash, entry->value, new_h, entry->hash);
+      const size_t new_h = fold_hash(entry.hash, hash->mask);
+      const size_t new_i = find_entry(hash, entry.value, new_h, entry.hash);
 
-      hash->entries[new_i] = *entry;
+      hash->entries[new_i] = entry;
     }
   }
 
@@ -205,7 +255,7 @@ grow(ZixHash* const hash)
   hash->n_entries <<= 1U;
   hash->mask = hash->n_entries - 1U;
 
-  const ZixStatus st = rehash(hash, old_n_entries);
+  const ZixStatus st = rehash(hash, old_n_entries, false);
   if (st) {
     hash->n_entries = old_n_entries;
     hash->mask      = old_mask;
@@ -223,19 +273,48 @@ shrink(ZixHash* const hash)
     hash->n_entries >>= 1U;
     hash->mask = hash->n_entries - 1U;
 
-    return rehash(hash, old_n_entries);
+    return rehash(hash, old_n_entries, false);
   }
 
   return ZIX_STATUS_SUCCESS;
 }
 
+/// Return the probe distance which suggests that keys are being attacked
+static size_t
+max_probe_distance(const ZixHash* const hash)
+{
+  /* The longest run in a table with random hashes grows with the logarithm of
+     its size, so this is a few times longer than any run that should occur
+     naturally at the maximum load. */
+
+  size_t n_bits = 0U;
+  for (size_t n = hash->n_entries; n > 1U; n >>= 1U) {
+    ++n_bits;
+  }
+
+  return 64U + (16U * n_bits);
+}
+
+static void
+reseed(ZixHash* const hash)
+{
+  const ZixDigestKey old_seed = hash->seed;
+
+  if (!zix_digest_random_key(&hash->seed) &&
+      rehash(hash, hash->n_entries, true)) {
+    hash->seed = old_seed; // Failed to allocate, so keep the old table
+  }
+
+  hash->reseed_count = hash->count;
+}
+
 ZixHashIter
 zix_hash_find(const ZixHash* const hash, const ZixHashKey* const key)
 {
   assert(hash);
   assert(key);
 
-  const ZixHashCode h_nomod = hash->hash_func(key);
+  const ZixHashCode h_nomod = hash_code(hash, key);
   const size_t      h       = fold_hash(h_nomod, hash->mask);
   const ZixHashIter i       = find_entry(hash, key, h, h_nomod);
 
@@ -248,7 +327,7 @@ zix_hash_find_record(const ZixHash* const hash, const ZixHashKey* const key)
   assert(hash);
   assert(key);
 
-  const ZixHashCode h_nomod = hash->hash_func(key);
+  const ZixHashCode h_nomod = hash_code(hash, key);
   const size_t      h       = fold_hash(h_nomod, hash->mask);
 
   return hash->entries[find_entry(hash, key, h, h_nomod)].value;
@@ -303,7 +382,7 @@ zix_hash_plan_insert(const ZixHash* const hash, const ZixHashKey* const key)
   assert(key);
 
   return zix_hash_plan_insert_prehashed(
-    hash, hash->hash_func(key), hash->equal_func, key);
+    hash, hash_code(hash, key), hash->equal_func, key);
 }
 
 ZIX_REALTIME ZixHashRecord*
@@ -325,6 +404,10 @@ zix_hash_insert_at(ZixHash* const          hash,
     return ZIX_STATUS_EXISTS;
   }
 
+  // Calculate how far the position is from the ideal one before any resize
+  const size_t distance =
+    (position.index - fold_hash(position.code, hash->mask)) & hash->mask;
+
   // Set entry to new value
   ZixHashEntry* const entry      = &hash->entries[position.index];
   const ZixHashEntry  orig_entry = *entry;
@@ -344,6 +427,13 @@ zix_hash_insert_at(ZixHash* const          hash,
   }
 
   hash->count = new_count;
+
+  // Rehash with a new seed if keys seem to be chosen to collide
+  if (hash->keyed_hash_func && distance > max_probe_distance(hash) &&
+      new_count > 2U * hash->reseed_count) {
+    reseed(hash); // Failure is harmless, the table is only slower
+  }
+
   return ZIX_STATUS_SUCCESS;
 }
 
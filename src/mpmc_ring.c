@@ -0,0 +1,299 @@
+// Copyright 2011-2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/mpmc_ring.h>
+
+#include "atomic.h"
+#include "errno_status.h"
+#include "zix_config.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/status.h>
+
+#if USE_VIRTUALLOCK
+#  include <windows.h>
+#elif USE_MLOCK
+#  include <sys/mman.h>
+#endif
+
+#if USE_SCHED_YIELD
+#  include <sched.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+  Positions are free-running byte counters which are only masked when
+  accessing the buffer, so the distance between any two of them is simply
+  their difference.  The heads always satisfy:
+
+  read_head <= claim_head <= write_head <= reserve_head <= read_head + size
+*/
+
+#define HEADER_SIZE ((uint32_t)sizeof(uint32_t))
+#define MAX_SPINS 64U
+
+struct ZixMpmcRingImpl {
+  ZixAllocator* allocator;    ///< User allocator
+  uint32_t      reserve_head; ///< End of space reserved by writers
+  uint32_t      write_head;   ///< End of records committed by writers
+  uint32_t      claim_head;   ///< End of records claimed by readers
+  uint32_t      read_head;    ///< End of records released by readers
+  uint32_t      size;         ///< Size of buf in bytes
+  uint32_t      size_mask;    ///< Mask for fast modulo
+  char*         buf;          ///< Contents
+};
+
+ZixMpmcRing*
+zix_mpmc_ring_new(ZixAllocator* const allocator, const uint32_t size)
+{
+  if (size < 8U || size > 2147483648U) {
+    return NULL;
+  }
+
+  ZixMpmcRing* ring = (ZixMpmcRing*)zix_malloc(allocator, sizeof(ZixMpmcRing));
+
+  if (ring) {
+    ring->allocator = allocator;
+    ring->size      = 8U;
+    while (ring->size < size) {
+      ring->size <<= 1U;
+    }
+
+    ring->size_mask = ring->size - 1U;
+    zix_mpmc_ring_reset(ring);
+
+    if (!(ring->buf = (char*)zix_malloc(allocator, ring->size))) {
+      zix_free(allocator, ring);
+      return NULL;
+    }
+  }
+
+  return ring;
+}
+
+void
+zix_mpmc_ring_free(ZixMpmcRing* const ring)
+{
+  if (ring) {
+    zix_free(ring->allocator, ring->buf);
+    zix_free(ring->allocator, ring);
+  }
+}
+
+ZixStatus
+zix_mpmc_ring_mlock(ZixMpmcRing* const ring)
+{
+#if USE_VIRTUALLOCK
+  return (VirtualLock(ring, sizeof(ZixMpmcRing)) &&
+          VirtualLock(ring->buf, ring->size))
+           ? ZIX_STATUS_SUCCESS
+           : ZIX_STATUS_ERROR;
+
+#elif USE_MLOCK
+  return zix_errno_status_if(mlock(ring, sizeof(ZixMpmcRing)) +
+                             mlock(ring->buf, ring->size));
+
+#else
+  (void)ring;
+  return ZIX_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+ZIX_REALTIME void
+zix_mpmc_ring_reset(ZixMpmcRing* const ring)
+{
+  ring->reserve_head = 0U;
+  ring->write_head   = 0U;
+  ring->claim_head   = 0U;
+  ring->read_head    = 0U;
+}
+
+ZIX_REALTIME uint32_t
+zix_mpmc_ring_capacity(const ZixMpmcRing* const ring)
+{
+  return ring->size - HEADER_SIZE;
+}
+
+static inline void
+copy_from_ring(const ZixMpmcRing* const ring,
+               const uint32_t           pos,
+               void* const              dst,
+               const uint32_t           size)
+{
+  const uint32_t i = pos & ring->size_mask;
+  if (i + size <= ring->size) {
+    memcpy(dst, &ring->buf[i], size);
+  } else {
+    const uint32_t first_size = ring->size - i;
+    memcpy(dst, &ring->buf[i], first_size);
+    memcpy((char*)dst + first_size, &ring->buf[0], (size_t)size - first_size);
+  }
+}
+
+static inline void
+copy_to_ring(ZixMpmcRing* const ring,
+             const uint32_t     pos,
+             const void* const  src,
+             const uint32_t     size)
+{
+  const uint32_t i = pos & ring->size_mask;
+  if (i + size <= ring->size) {
+    memcpy(&ring->buf[i], src, size);
+  } else {
+    const uint32_t first_size = ring->size - i;
+    memcpy(&ring->buf[i], src, first_size);
+    memcpy(&ring->buf[0], (const char*)src + first_size, size - first_size);
+  }
+}
+
+static inline void
+wait_for_head(const uint32_t* const head, const uint32_t pos)
+{
+  for (unsigned n_spins = 0U; zix_atomic_load(head) != pos; ++n_spins) {
+#if USE_SCHED_YIELD
+    if (n_spins >= MAX_SPINS) {
+      // The thread we're waiting for has probably been preempted
+      sched_yield();
+      continue;
+    }
+#endif
+
+    zix_atomic_pause();
+  }
+}
+
+ZixStatus
+zix_mpmc_ring_read(ZixMpmcRing* const ring,
+                   void* const        dst,
+                   const uint32_t     capacity,
+                   uint32_t* const    size)
+{
+  uint32_t r   = zix_atomic_load(&ring->claim_head);
+  uint32_t len = 0U;
+  for (;;) {
+    const uint32_t w     = zix_atomic_load(&ring->write_head);
+    const uint32_t space = w - r;
+    if (!space) {
+      return ZIX_STATUS_UNAVAILABLE;
+    }
+
+    if (space > ring->size) {
+      r = zix_atomic_load(&ring->claim_head); // Stale, another reader claimed
+      continue;
+    }
+
+    // The header may be torn if another reader claimed it, checked below
+    copy_from_ring(ring, r, &len, HEADER_SIZE);
+    if (len > space - HEADER_SIZE) {
+      r = zix_atomic_load(&ring->claim_head);
+      continue;
+    }
+
+    if (len > capacity) {
+      uint32_t current = zix_atomic_load(&ring->claim_head);
+      if (current == r) {
+        *size = len;
+        return ZIX_STATUS_NO_SPACE;
+      }
+
+      r = current;
+      continue;
+    }
+
+    if (zix_atomic_cas(&ring->claim_head, &r, r + HEADER_SIZE + len)) {
+      break;
+    }
+  }
+
+  copy_from_ring(ring, r + HEADER_SIZE, dst, len);
+
+  // Release space in the same order it was claimed
+  wait_for_head(&ring->read_head, r);
+  zix_atomic_store(&ring->read_head, r + HEADER_SIZE + len);
+
+  *size = len;
+  return ZIX_STATUS_SUCCESS;
+}
+
+ZIX_NONBLOCKING ZixStatus
+zix_mpmc_ring_begin_write(ZixMpmcRing* const            ring,
+                          const uint32_t                size,
+                          ZixMpmcRingTransaction* const tx)
+{
+  if (!size) {
+    return ZIX_STATUS_BAD_ARG;
+  }
+
+  if (size > ring->size - HEADER_SIZE) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  const uint32_t total = HEADER_SIZE + size;
+  uint32_t       w     = zix_atomic_load(&ring->reserve_head);
+  for (;;) {
+    const uint32_t r    = zix_atomic_load(&ring->read_head);
+    const uint32_t used = w - r;
+    if (used > ring->size) {
+      w = zix_atomic_load(&ring->reserve_head); // Stale, another writer won
+      continue;
+    }
+
+    if (ring->size - used < total) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    if (zix_atomic_cas(&ring->reserve_head, &w, w + total)) {
+      break;
+    }
+  }
+
+  copy_to_ring(ring, w, &size, HEADER_SIZE);
+
+  tx->begin  = w;
+  tx->cursor = w + HEADER_SIZE;
+  tx->end    = w + total;
+  return ZIX_STATUS_SUCCESS;
+}
+
+ZIX_REALTIME ZixStatus
+zix_mpmc_ring_amend_write(ZixMpmcRing* const            ring,
+                          ZixMpmcRingTransaction* const tx,
+                          const void* const             src,
+                          const uint32_t                size)
+{
+  if (size > tx->end - tx->cursor) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  copy_to_ring(ring, tx->cursor, src, size);
+  tx->cursor += size;
+  return ZIX_STATUS_SUCCESS;
+}
+
+ZixStatus
+zix_mpmc_ring_commit_write(ZixMpmcRing* const                  ring,
+                           const ZixMpmcRingTransaction* const tx)
+{
+  // Publish records in the same order their space was reserved
+  wait_for_head(&ring->write_head, tx->begin);
+  zix_atomic_store(&ring->write_head, tx->end);
+  return ZIX_STATUS_SUCCESS;
+}
+
+uint32_t
+zix_mpmc_ring_write(ZixMpmcRing* const ring,
+                    const void* const  src,
+                    const uint32_t     size)
+{
+  ZixMpmcRingTransaction tx = {0U, 0U, 0U};
+  if (zix_mpmc_ring_begin_write(ring, size, &tx)) {
+    return 0U;
+  }
+
+  zix_mpmc_ring_amend_write(ring, &tx, src, size);
+  zix_mpmc_ring_commit_write(ring, &tx);
+  return size;
+}
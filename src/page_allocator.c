@@ -0,0 +1,356 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/page_allocator.h>
+
+#include "atomic.h"
+#include "system.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  Every allocation is within the first region of a region-aligned mapping
+  with a header at the start, so the header can be found by masking the
+  address.  Small regions are dedicated to a single size class and carved up
+  like a slab, and large allocations get a mapping of their own.
+*/
+
+#define REGION_SIZE 2097152U ///< Size and alignment of a region (2 MiB)
+#define HEADER_SIZE 64U      ///< Space reserved for region header
+#define MIN_SHIFT 4U         ///< Log2 of the smallest class size
+#define N_CLASSES 15U        ///< Number of small size classes (up to 256 KiB)
+#define LARGE_CLASS 0xFFU    ///< Class of large allocations
+#define MAX_ALIGN 1048576U   ///< Largest supported alignment
+
+typedef struct BlockImpl Block;
+
+/// A free object, which stores a link to the next one in the same list
+struct BlockImpl {
+  Block* next;
+};
+
+typedef struct RegionImpl Region;
+
+/// The header at the start of every region
+struct RegionImpl {
+  Region* next;        ///< Next small region, or null
+  size_t  size;        ///< Total size of the mapping
+  size_t  data_offset; ///< Offset of a large allocation
+  uint8_t size_class;  ///< Index of the size class, or LARGE_CLASS
+  bool    mapped;      ///< True if mapped from the system (not the parent)
+};
+
+struct ZixPageAllocatorImpl {
+  ZixAllocator   base;                  ///< Base allocator instance
+  ZixAllocator*  parent;                ///< Allocator for fallback regions
+  ZixPageOptions options;               ///< Options for mapping pages
+  int            numa_node;             ///< Preferred NUMA node, or -1
+  uint32_t       lock;                  ///< Non-zero while in use
+  Region*        regions;               ///< List of small regions
+  char*          tops[N_CLASSES];       ///< Next unused object in region
+  char*          ends[N_CLASSES];       ///< End of objects in region
+  Block*         free_lists[N_CLASSES]; ///< Free objects for each class
+};
+
+static unsigned
+find_class(const size_t alignment, const size_t size)
+{
+  const size_t min_size = (size > alignment) ? size : alignment;
+
+  unsigned c = 0U;
+  while ((size_t)1U << (c + MIN_SHIFT) < min_size) {
+    ++c;
+  }
+
+  return c;
+}
+
+static inline size_t
+class_size(const unsigned c)
+{
+  return (size_t)1U << (c + MIN_SHIFT);
+}
+
+static inline Region*
+region_of(const void* const ptr)
+{
+  return (Region*)((uintptr_t)ptr & ~(uintptr_t)(REGION_SIZE - 1U));
+}
+
+static void
+lock_allocator(ZixPageAllocator* const allocator)
+{
+  uint32_t unlocked = 0U;
+  while (!zix_atomic_cas(&allocator->lock, &unlocked, 1U)) {
+    zix_atomic_pause();
+    unlocked = 0U;
+  }
+}
+
+static void
+unlock_allocator(ZixPageAllocator* const allocator)
+{
+  zix_atomic_store(&allocator->lock, 0U);
+}
+
+static Region*
+map_region(ZixPageAllocator* const allocator, const size_t size)
+{
+  Region* region = (Region*)zix_system_map_pages(
+    size, REGION_SIZE, allocator->options, allocator->numa_node);
+
+  if (region) {
+    region->mapped = true;
+  } else if ((region = (Region*)zix_aligned_alloc(
+                allocator->parent, REGION_SIZE, size))) {
+    region->mapped = false;
+  }
+
+  if (region) {
+    region->next        = NULL;
+    region->size        = size;
+    region->data_offset = 0U;
+    region->size_class  = LARGE_CLASS;
+  }
+
+  return region;
+}
+
+static void
+unmap_region(ZixPageAllocator* const allocator, Region* const region)
+{
+  if (region->mapped) {
+    zix_system_unmap_pages(region, region->size);
+  } else {
+    zix_aligned_free(allocator->parent, region);
+  }
+}
+
+// Take a free or unused object of a class, or return null if there are none
+static void*
+take_object(ZixPageAllocator* const allocator, const unsigned c)
+{
+  void* ptr = NULL;
+
+  if (allocator->free_lists[c]) {
+    ptr                      = allocator->free_lists[c];
+    allocator->free_lists[c] = allocator->free_lists[c]->next;
+  } else if (allocator->tops[c] != allocator->ends[c]) {
+    ptr = allocator->tops[c];
+    allocator->tops[c] += class_size(c);
+  }
+
+  return ptr;
+}
+
+static void*
+small_alloc(ZixPageAllocator* const allocator, const unsigned c)
+{
+  lock_allocator(allocator);
+  void* ptr = take_object(allocator, c);
+  unlock_allocator(allocator);
+  if (ptr) {
+    return ptr;
+  }
+
+  // Map a new region without holding the lock, since that may be slow
+  Region* region = map_region(allocator, REGION_SIZE);
+  if (!region) {
+    return NULL;
+  }
+
+  lock_allocator(allocator);
+
+  // Publish the region, unless another thread has already added one
+  if (allocator->tops[c] == allocator->ends[c]) {
+    const size_t size   = class_size(c);
+    const size_t offset = (size > HEADER_SIZE) ? size : HEADER_SIZE;
+
+    region->size_class = (uint8_t)c;
+    region->next       = allocator->regions;
+    allocator->regions = region;
+    allocator->tops[c] = (char*)region + offset;
+    allocator->ends[c] = (char*)region + REGION_SIZE;
+    region             = NULL;
+  }
+
+  ptr = take_object(allocator, c);
+  unlock_allocator(allocator);
+
+  if (region) {
+    unmap_region(allocator, region);
+  }
+
+  return ptr;
+}
+
+static void*
+large_alloc(ZixPageAllocator* const allocator,
+            const size_t            alignment,
+            const size_t            size)
+{
+  const size_t offset = (alignment > HEADER_SIZE) ? alignment : HEADER_SIZE;
+  if (size > SIZE_MAX - offset - REGION_SIZE) {
+    return NULL;
+  }
+
+  const size_t total = (offset + size + REGION_SIZE - 1U) & ~(REGION_SIZE - 1U);
+
+  Region* const region = map_region(allocator, total);
+  if (!region) {
+    return NULL;
+  }
+
+  region->data_offset = offset;
+  return (char*)region + offset;
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_page_aligned_alloc(ZixAllocator* const allocator,
+                       const size_t        alignment,
+                       const size_t        size)
+{
+  ZixPageAllocator* const state = (ZixPageAllocator*)allocator;
+
+  if (alignment > MAX_ALIGN) {
+    return NULL;
+  }
+
+  return (size <= class_size(N_CLASSES - 1U) &&
+          alignment <= class_size(N_CLASSES - 1U))
+           ? small_alloc(state, find_class(alignment, size))
+           : large_alloc(state, alignment, size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_page_malloc(ZixAllocator* const allocator, const size_t size)
+{
+  return zix_page_aligned_alloc(allocator, sizeof(uintmax_t), size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_page_calloc(ZixAllocator* const allocator,
+                const size_t        nmemb,
+                const size_t        size)
+{
+  if (size && nmemb > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  // Fresh pages are already zeroed, but recycled objects and fallbacks aren't
+  const size_t total_size = nmemb * size;
+  void* const  ptr        = zix_page_malloc(allocator, total_size);
+  if (ptr) {
+    memset(ptr, 0, total_size);
+  }
+
+  return ptr;
+}
+
+static void
+zix_page_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixPageAllocator* const state = (ZixPageAllocator*)allocator;
+  if (!ptr) {
+    return;
+  }
+
+  Region* const region = region_of(ptr);
+  if (region->size_class == LARGE_CLASS) {
+    unmap_region(state, region);
+    return;
+  }
+
+  Block* const   block = (Block*)ptr;
+  const unsigned c     = region->size_class;
+
+  lock_allocator(state);
+  block->next          = state->free_lists[c];
+  state->free_lists[c] = block;
+  unlock_allocator(state);
+}
+
+static void*
+zix_page_realloc(ZixAllocator* const allocator,
+                 void* const         ptr,
+                 const size_t        size)
+{
+  if (!ptr) {
+    return zix_page_malloc(allocator, size);
+  }
+
+  // Keep the same memory if it's large enough and not too wasteful
+  const Region* const region = region_of(ptr);
+  const unsigned      c      = region->size_class;
+  const bool          large  = c == LARGE_CLASS;
+  const size_t        old_size =
+    large ? region->size - region->data_offset : class_size(c);
+
+  const bool fits = large ? (size > old_size / 2U) : find_class(1U, size) == c;
+  if (size <= old_size && fits) {
+    return ptr;
+  }
+
+  void* const new_ptr = zix_page_malloc(allocator, size);
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, (size < old_size) ? size : old_size);
+    zix_page_free(allocator, ptr);
+  }
+
+  return new_ptr;
+}
+
+static void
+zix_page_aligned_free(ZixAllocator* const allocator, void* const ptr)
+{
+  zix_page_free(allocator, ptr);
+}
+
+ZixPageAllocator*
+zix_page_allocator_new(ZixAllocator* const  parent,
+                       const ZixPageOptions options,
+                       const int            numa_node)
+{
+  ZixPageAllocator* const allocator =
+    (ZixPageAllocator*)zix_calloc(parent, 1U, sizeof(ZixPageAllocator));
+
+  if (allocator) {
+    allocator->base.malloc        = zix_page_malloc;
+    allocator->base.calloc        = zix_page_calloc;
+    allocator->base.realloc       = zix_page_realloc;
+    allocator->base.free          = zix_page_free;
+    allocator->base.aligned_alloc = zix_page_aligned_alloc;
+    allocator->base.aligned_free  = zix_page_aligned_free;
+    allocator->parent             = parent;
+    allocator->options            = options;
+    allocator->numa_node          = numa_node;
+  }
+
+  return allocator;
+}
+
+void
+zix_page_allocator_free(ZixPageAllocator* const allocator)
+{
+  if (allocator) {
+    for (Region* r = allocator->regions; r;) {
+      Region* const next = r->next;
+      unmap_region(allocator, r);
+      r = next;
+    }
+
+    zix_free(allocator->parent, allocator);
+  }
+}
+
+ZixAllocator*
+zix_page_allocator_base(ZixPageAllocator* const allocator)
+{
+  return &allocator->base;
+}
@@ -0,0 +1,346 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include <zix/pool_allocator.h>
+
+#include "atomic.h"
+#include "errno_status.h"
+#include "zix_config.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/status.h>
+
+#if USE_VIRTUALLOCK
+#  include <windows.h>
+#elif USE_MLOCK
+#  include <sys/mman.h>
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  Objects are identified by a 32-bit index, so the head of the free list can
+  be a 64-bit word with the index of the first free object and a tag that is
+  incremented on every change.  This prevents the ABA problem, where a pop
+  would otherwise succeed with a stale next link if the head was popped and
+  pushed back by other threads in the meantime.  Each free object stores the
+  index of the next one in its first bytes.
+
+  Chunk 0 holds the first `n_objects` (a power of two) objects, and every
+  later chunk k holds objects [n_objects << (k - 1), n_objects << k), so the
+  location of an object can be calculated from its index.
+*/
+
+#define MAX_CHUNKS 32U
+#define NIL_INDEX UINT32_MAX
+
+struct ZixPoolAllocatorImpl {
+  ZixAllocator  base;               ///< Base allocator instance
+  ZixAllocator* parent;             ///< Allocator for the pool and its chunks
+  size_t        object_size;        ///< Maximum size of an allocation
+  size_t        alignment;          ///< Alignment of chunks and objects
+  size_t        stride;             ///< Distance between objects
+  unsigned      first_shift;        ///< Log2 of the size of the first chunk
+  uint32_t      n_chunks;           ///< Number of allocated chunks
+  uint32_t      capacity;           ///< Total number of objects in chunks
+  uint32_t      n_used;             ///< Number of objects ever allocated
+  uint32_t      lock;               ///< Non-zero while the pool is growing
+  uint32_t      mlocked;            ///< Non-zero if new chunks are locked
+  char*         chunks[MAX_CHUNKS]; ///< Chunks of object memory
+  char          pad[ZIX_CACHE_LINE_SIZE];
+  uint64_t      free_head; ///< Tag and index of first free object
+};
+
+static inline unsigned
+floor_log2(const uint32_t n)
+{
+#if defined(__GNUC__)
+  return 31U - (unsigned)__builtin_clz(n);
+#elif defined(_MSC_VER)
+  unsigned long i = 0U;
+  _BitScanReverse(&i, n);
+  return (unsigned)i;
+#else
+  unsigned i = 0U;
+  while (n >> (i + 1U)) {
+    ++i;
+  }
+  return i;
+#endif
+}
+
+static inline uint32_t
+chunk_begin(const ZixPoolAllocator* const pool, const unsigned k)
+{
+  return k ? (1U << (pool->first_shift + k - 1U)) : 0U;
+}
+
+static inline uint32_t
+chunk_capacity(const ZixPoolAllocator* const pool, const unsigned k)
+{
+  return 1U << (pool->first_shift + (k ? k - 1U : 0U));
+}
+
+static inline char*
+object_at(const ZixPoolAllocator* const pool, const uint32_t index)
+{
+  const uint32_t high = index >> pool->first_shift;
+  const unsigned k    = high ? floor_log2(high) + 1U : 0U;
+
+  const size_t offset = (size_t)(index - chunk_begin(pool, k)) * pool->stride;
+
+  return pool->chunks[k] + offset;
+}
+
+static uint32_t
+index_of(const ZixPoolAllocator* const pool, const void* const ptr)
+{
+  const uintptr_t addr     = (uintptr_t)ptr;
+  const uint32_t  n_chunks = zix_atomic_load(&pool->n_chunks);
+
+  for (unsigned k = 0U; k < n_chunks; ++k) {
+    const uintptr_t begin = (uintptr_t)pool->chunks[k];
+    const uintptr_t end   = begin + (chunk_capacity(pool, k) * pool->stride);
+    if (addr >= begin && addr < end) {
+      return chunk_begin(pool, k) + (uint32_t)((addr - begin) / pool->stride);
+    }
+  }
+
+  return NIL_INDEX;
+}
+
+static inline uint64_t
+pack_head(const uint64_t old_head, const uint32_t index)
+{
+  return ((old_head + (1ULL << 32U)) & ~(uint64_t)UINT32_MAX) | index;
+}
+
+static ZixStatus
+lock_chunk(char* const chunk, const size_t size)
+{
+#if USE_VIRTUALLOCK
+  return VirtualLock(chunk, size) ? ZIX_STATUS_SUCCESS : ZIX_STATUS_ERROR;
+#elif USE_MLOCK
+  return zix_errno_status_if(mlock(chunk, size));
+#else
+  (void)chunk;
+  (void)size;
+  return ZIX_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+static bool
+grow(ZixPoolAllocator* const pool, const uint32_t old_capacity)
+{
+  uint32_t unlocked = 0U;
+  while (!zix_atomic_cas(&pool->lock, &unlocked, 1U)) {
+    zix_atomic_pause();
+    unlocked = 0U;
+  }
+
+  // Another thread may have already grown the pool while we were waiting
+  bool           success = zix_atomic_load(&pool->capacity) != old_capacity;
+  const uint32_t k       = pool->n_chunks;
+  if (!success && k < MAX_CHUNKS && pool->first_shift + k <= 32U &&
+      chunk_capacity(pool, k) <= SIZE_MAX / pool->stride) {
+    const size_t size = (size_t)chunk_capacity(pool, k) * pool->stride;
+    char* const  chunk =
+      (char*)zix_aligned_alloc(pool->parent, pool->alignment, size);
+
+    if (chunk && pool->mlocked && lock_chunk(chunk, size)) {
+      zix_aligned_free(pool->parent, chunk);
+    } else if (chunk) {
+      const uint32_t end = chunk_begin(pool, k) + chunk_capacity(pool, k);
+
+      pool->chunks[k] = chunk;
+      zix_atomic_store(&pool->n_chunks, k + 1U);
+      zix_atomic_store(&pool->capacity, end ? end : NIL_INDEX);
+      success = true;
+    }
+  }
+
+  zix_atomic_store(&pool->lock, 0U);
+  return success;
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_pool_aligned_alloc(ZixAllocator* const allocator,
+                       const size_t        alignment,
+                       const size_t        size)
+{
+  ZixPoolAllocator* const pool = (ZixPoolAllocator*)allocator;
+  if (size > pool->object_size || alignment > pool->alignment) {
+    return NULL;
+  }
+
+  for (;;) {
+    // Pop the first free object if there is one
+    uint64_t head = zix_atomic_load64(&pool->free_head);
+    while ((uint32_t)head != NIL_INDEX) {
+      char* const    object = object_at(pool, (uint32_t)head);
+      const uint32_t next   = zix_atomic_load((const uint32_t*)object);
+      if (zix_atomic_cas64(&pool->free_head, &head, pack_head(head, next))) {
+        return object;
+      }
+    }
+
+    // Otherwise, take the next never-used object if there is one
+    uint32_t       n_used   = zix_atomic_load(&pool->n_used);
+    const uint32_t capacity = zix_atomic_load(&pool->capacity);
+    if (n_used < capacity) {
+      if (zix_atomic_cas(&pool->n_used, &n_used, n_used + 1U)) {
+        return object_at(pool, n_used);
+      }
+    } else if (!grow(pool, capacity)) {
+      return NULL;
+    }
+  }
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_pool_malloc(ZixAllocator* const allocator, const size_t size)
+{
+  return zix_pool_aligned_alloc(allocator, 1U, size);
+}
+
+ZIX_MALLOC_FUNC static void*
+zix_pool_calloc(ZixAllocator* const allocator,
+                const size_t        nmemb,
+                const size_t        size)
+{
+  if (size && nmemb > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  const size_t total_size = nmemb * size;
+  void* const  ptr        = zix_pool_malloc(allocator, total_size);
+  if (ptr) {
+    memset(ptr, 0, total_size);
+  }
+
+  return ptr;
+}
+
+static void*
+zix_pool_realloc(ZixAllocator* const allocator,
+                 void* const         ptr,
+                 const size_t        size)
+{
+  const ZixPoolAllocator* const pool = (const ZixPoolAllocator*)allocator;
+
+  if (!ptr) {
+    return zix_pool_malloc(allocator, size);
+  }
+
+  return (size <= pool->object_size) ? ptr : NULL;
+}
+
+static void
+zix_pool_free(ZixAllocator* const allocator, void* const ptr)
+{
+  ZixPoolAllocator* const pool = (ZixPoolAllocator*)allocator;
+  if (!ptr) {
+    return;
+  }
+
+  const uint32_t index = index_of(pool, ptr);
+  if (index == NIL_INDEX) {
+    return; // Not from this pool
+  }
+
+  uint64_t head = zix_atomic_load64(&pool->free_head);
+  do {
+    zix_atomic_store((uint32_t*)ptr, (uint32_t)head);
+  } while (!zix_atomic_cas64(&pool->free_head, &head, pack_head(head, index)));
+}
+
+static void
+zix_pool_aligned_free(ZixAllocator* const allocator, void* const ptr)
+{
+  zix_pool_free(allocator, ptr);
+}
+
+ZixPoolAllocator*
+zix_pool_allocator_new(ZixAllocator* const parent,
+                       const size_t        object_size,
+                       const size_t        alignment,
+                       const uint32_t      n_objects)
+{
+  if (!object_size || !alignment || (alignment & (alignment - 1U)) ||
+      object_size > SIZE_MAX / 4U || alignment > SIZE_MAX / 4U ||
+      n_objects > (1U << 31U)) {
+    return NULL;
+  }
+
+  ZixPoolAllocator* const pool =
+    (ZixPoolAllocator*)zix_malloc(parent, sizeof(ZixPoolAllocator));
+  if (!pool) {
+    return NULL;
+  }
+
+  // Objects must be large and aligned enough for a free list link
+  const size_t min_size  = sizeof(uint32_t);
+  const size_t min_align = sizeof(void*);
+  const size_t size      = (object_size > min_size) ? object_size : min_size;
+  const size_t align     = (alignment > min_align) ? alignment : min_align;
+  const size_t shift = (n_objects > 1U) ? floor_log2(n_objects - 1U) + 1U : 0U;
+
+  memset(pool, 0, sizeof(ZixPoolAllocator));
+  pool->base.malloc        = zix_pool_malloc;
+  pool->base.calloc        = zix_pool_calloc;
+  pool->base.realloc       = zix_pool_realloc;
+  pool->base.free          = zix_pool_free;
+  pool->base.aligned_alloc = zix_pool_aligned_alloc;
+  pool->base.aligned_free  = zix_pool_aligned_free;
+  pool->parent             = parent;
+  pool->object_size        = object_size;
+  pool->alignment          = align;
+  pool->stride             = (size + align - 1U) & ~(align - 1U);
+  pool->first_shift        = (unsigned)shift;
+  pool->free_head          = NIL_INDEX;
+
+  if (!grow(pool, 0U)) {
+    zix_free(parent, pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void
+zix_pool_allocator_free(ZixPoolAllocator* const pool)
+{
+  if (pool) {
+    for (uint32_t k = 0U; k < pool->n_chunks; ++k) {
+      zix_aligned_free(pool->parent, pool->chunks[k]);
+    }
+
+    zix_free(pool->parent, pool);
+  }
+}
+
+ZixAllocator*
+zix_pool_allocator_base(ZixPoolAllocator* const pool)
+{
+  return &pool->base;
+}
+
+ZixStatus
+zix_pool_allocator_mlock(ZixPoolAllocator* const pool)
+{
+  ZixStatus st = lock_chunk((char*)pool, sizeof(ZixPoolAllocator));
+  for (uint32_t k = 0U; !st && k < pool->n_chunks; ++k) {
+    st = lock_chunk(pool->chunks[k],
+                    (size_t)chunk_capacity(pool, k) * pool->stride);
+  }
+
+  if (!st) {
+    zix_atomic_store(&pool->mlocked, 1U);
+  }
+
+  return st;
+}
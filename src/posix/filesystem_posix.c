@@ -3,6 +3,7 @@
 
 #include <zix/filesystem.h>
 
+#include "../atomic.h"
 #include "../errno_status.h"
 #include "../qualifiers.h"
 #include "../system.h"
@@ -21,10 +22,23 @@
 #  include <sys/clonefile.h>
 #endif
 
+#if USE_FICLONE
+#  include <linux/fs.h>
+#  include <sys/ioctl.h>
+#endif
+
 #if USE_REALPATH
 #  include <limits.h>
 #endif
 
+#if USE_MMAP
+#  include <sys/mman.h>
+#endif
+
+#if USE_THREADS
+#  include <zix/thread.h>
+#endif
+
 #include <dirent.h>
 #include <fcntl.h>
 #include <stdint.h>
@@ -44,14 +58,29 @@ zix_posix_status(const int rc)
   return rc ? zix_errno_status(errno) : ZIX_STATUS_SUCCESS;
 }
 
-static ZixStatus
-finish_copy(const int dst_fd, const int src_fd, const ZixStatus status)
+#define SYNC_BATCH_SIZE 64U ///< Maximum number of files synced together
+
+static int
+sync_fd(const int fd, const bool full)
 {
 #ifdef __APPLE__
-  const int rc = dst_fd >= 0 ? fcntl(dst_fd, F_FULLFSYNC) : 0;
+  // Only F_FULLFSYNC flushes the drive cache, which is needed for durability
+  (void)full;
+  return fcntl(fd, F_FULLFSYNC);
 #else
-  const int rc = dst_fd >= 0 ? fdatasync(dst_fd) : 0;
+  return full ? fsync(fd) : fdatasync(fd);
 #endif
+}
+
+static ZixStatus
+finish_copy(const int            dst_fd,
+            const int            src_fd,
+            const ZixCopyOptions options,
+            const ZixStatus      status)
+{
+  const bool sync = dst_fd >= 0 && !(options & ZIX_COPY_OPTION_NO_SYNC);
+  const bool full = options & ZIX_COPY_OPTION_FULL_SYNC;
+  const int  rc   = sync ? sync_fd(dst_fd, full) : 0;
 
   const ZixStatus st0 = zix_posix_status(rc);
   const ZixStatus st1 = zix_system_close_fds(dst_fd, src_fd);
@@ -107,7 +136,7 @@ zix_clonefile(const char* const    src,
 
   ZixStatus         st        = ZIX_STATUS_SUCCESS;
   const ZixFileType dst_type  = zix_file_type(dst);
-  const bool        overwrite = (options == ZIX_COPY_OPTION_OVERWRITE_EXISTING);
+  const bool        overwrite = options & ZIX_COPY_OPTION_OVERWRITE_EXISTING;
   if (overwrite && dst_type == ZIX_FILE_TYPE_REGULAR) {
     st = zix_remove(dst);
   } else if (dst_type != ZIX_FILE_TYPE_NONE) {
@@ -122,17 +151,18 @@ zix_clonefile(const char* const    src,
 #if USE_COPY_FILE_RANGE
 
 static ZixStatus
-zix_copy_file_range(const int src_fd, const int dst_fd, const size_t size)
+zix_copy_file_range(const int src_fd, const int dst_fd, size_t* const remaining)
 {
   errno = 0;
 
-  size_t  remaining = size;
-  ssize_t r         = 0;
-  while (remaining > 0 &&
-         (r = copy_file_range(src_fd, NULL, dst_fd, NULL, remaining, 0U)) > 0) {
-    remaining -= (size_t)r;
+  size_t  n = *remaining;
+  ssize_t r = 0;
+  while (n > 0 &&
+         (r = copy_file_range(src_fd, NULL, dst_fd, NULL, n, 0U)) > 0) {
+    n -= (size_t)r;
   }
 
+  *remaining = n;
   return (r >= 0) ? ZIX_STATUS_SUCCESS
                   : zix_errno_status(
                       (errno == EXDEV || errno == EINVAL) ? ENOSYS : errno);
@@ -144,20 +174,104 @@ static ZixStatus
 copy_blocks(const int    src_fd,
             const int    dst_fd,
             void* const  block,
-            const size_t block_size)
+            const size_t block_size,
+            size_t       remaining)
 {
-  ZixStatus st     = ZIX_STATUS_SUCCESS;
-  ssize_t   n_read = 0;
+  ZixStatus st = ZIX_STATUS_SUCCESS;
+
+  while (!st && remaining) {
+    const size_t  count  = (remaining < block_size) ? remaining : block_size;
+    const ssize_t n_read = read(src_fd, block, count);
+    if (n_read <= 0) {
+      return n_read ? zix_errno_status(errno) : ZIX_STATUS_SUCCESS;
+    }
 
-  while (!st && (n_read = read(src_fd, block, block_size)) > 0) {
     if (write(dst_fd, block, (size_t)n_read) != n_read) {
       st = zix_errno_status(errno);
     }
+
+    remaining -= (size_t)n_read;
   }
 
   return st;
 }
 
+/// A block buffer for copying, which is only allocated when first needed
+typedef struct {
+  ZixAllocator* allocator; ///< Allocator for the block
+  uint32_t      align;     ///< Alignment of the block
+  uint32_t      size;      ///< Size of the block to allocate
+  BlockBuffer   block;     ///< Block, which has zero size until allocated
+} CopyBuffer;
+
+// Copy a range of data from the current position in the source to the dest
+static ZixStatus
+copy_range(const int         src_fd,
+           const int         dst_fd,
+           CopyBuffer* const buffer,
+           size_t            length)
+{
+#if USE_COPY_FILE_RANGE
+  // Try to copy via the kernel on Linux/BSD to take advantage of CoW
+  const ZixStatus st = zix_copy_file_range(src_fd, dst_fd, &length);
+  if (st != ZIX_STATUS_NOT_SUPPORTED) {
+    return st;
+  }
+#endif
+
+  // Allocate a block if this is the first time the kernel couldn't copy
+  BlockBuffer* const block = &buffer->block;
+  if (!block->size) {
+    *block =
+      zix_system_new_block(buffer->allocator, buffer->align, buffer->size);
+  }
+
+  void* const data = block->buffer ? block->buffer : block->fallback;
+  return copy_blocks(src_fd, dst_fd, data, block->size, length);
+}
+
+// Copy all data in a file, skipping any holes so they're preserved in the dest
+static ZixStatus
+copy_data(const int         src_fd,
+          const int         dst_fd,
+          CopyBuffer* const buffer,
+          const off_t       size)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  ZixStatus st     = ZIX_STATUS_SUCCESS;
+  off_t     offset = 0;
+  while (!st && offset < size) {
+    // Find the next range of data, or copy everything if holes aren't supported
+    off_t start = lseek(src_fd, offset, SEEK_DATA);
+    off_t end   = (start >= 0) ? lseek(src_fd, start, SEEK_HOLE) : size;
+    if (start < 0 && errno == ENXIO) {
+      break; // The rest of the file is a hole
+    }
+
+    start = (start < 0) ? offset : start;
+    end   = (end < 0 || end > size) ? size : end;
+
+    // Copy the data to the same place in the destination
+    if (lseek(src_fd, start, SEEK_SET) < 0 ||
+        lseek(dst_fd, start, SEEK_SET) < 0) {
+      return zix_errno_status(errno);
+    }
+
+    const size_t length = (size_t)(end - start);
+
+    st     = copy_range(src_fd, dst_fd, buffer, length);
+    offset = end;
+  }
+
+  // Extend the destination if it ends with a hole that wasn't written
+  return (st || offset >= size) ? st
+                                 : zix_posix_status(ftruncate(dst_fd, size));
+
+#else
+  return copy_range(src_fd, dst_fd, buffer, (size_t)size);
+#endif
+}
+
 ZixStatus
 zix_copy_file(ZixAllocator* const  allocator,
               const char* const    src,
@@ -180,28 +294,27 @@ zix_copy_file(ZixAllocator* const  allocator,
   const int   src_fd = zix_system_open(src, O_RDONLY, 0);
   struct stat src_stat;
   if (src_fd < 0 || fstat(src_fd, &src_stat)) {
-    return finish_copy(-1, src_fd, zix_errno_status(errno));
+    return finish_copy(-1, src_fd, options, zix_errno_status(errno));
   }
 
   // Fail if the source is not a regular file (since we need a size)
   if (!S_ISREG(src_stat.st_mode)) {
-    return finish_copy(-1, src_fd, ZIX_STATUS_BAD_ARG);
+    return finish_copy(-1, src_fd, options, ZIX_STATUS_BAD_ARG);
   }
 
   // Open a new destination file
-  const bool  overwrite = (options == ZIX_COPY_OPTION_OVERWRITE_EXISTING);
+  const bool  overwrite = options & ZIX_COPY_OPTION_OVERWRITE_EXISTING;
   const int   dst_flags = O_WRONLY | O_CREAT | (overwrite ? O_TRUNC : O_EXCL);
   const int   dst_fd    = zix_system_open(dst, dst_flags, 0644);
   struct stat dst_stat;
   if (dst_fd < 0 || fstat(dst_fd, &dst_stat)) {
-    return finish_copy(dst_fd, src_fd, zix_errno_status(errno));
+    return finish_copy(dst_fd, src_fd, options, zix_errno_status(errno));
   }
 
-#if USE_COPY_FILE_RANGE
-  // Try to copy via the kernel on Linux/BSD to take advantage of CoW
-  st = zix_copy_file_range(src_fd, dst_fd, (size_t)src_stat.st_size);
-  if (st != ZIX_STATUS_NOT_SUPPORTED) {
-    return finish_copy(dst_fd, src_fd, st);
+#if USE_FICLONE
+  // Try to share all data with a reflink on Linux filesystems with CoW
+  if (!ioctl(dst_fd, FICLONE, src_fd)) {
+    return finish_copy(dst_fd, src_fd, options, ZIX_STATUS_SUCCESS);
   }
 #endif
 
@@ -213,15 +326,82 @@ zix_copy_file(ZixAllocator* const  allocator,
 
   errno = 0;
 
-  // Allocate a block and copy file content one block at a time
-  const uint32_t align = zix_system_page_size();
-  const uint32_t size  = zix_system_max_block_size(&src_stat, &dst_stat, align);
-  BlockBuffer    block = zix_system_new_block(allocator, align, size);
-  void* const    data  = block.buffer ? block.buffer : block.fallback;
-  st                   = copy_blocks(src_fd, dst_fd, data, block.size);
+  // Copy all data, with a block that's only allocated if the kernel can't copy
+  const uint32_t align  = zix_system_page_size();
+  CopyBuffer     buffer = {
+    allocator,
+    align,
+    zix_system_max_block_size(&src_stat, &dst_stat, align),
+    {0U, NULL, {'\0'}},
+  };
+
+  st = copy_data(src_fd, dst_fd, &buffer, src_stat.st_size);
 
-  zix_system_free_block(allocator, block);
-  return finish_copy(dst_fd, src_fd, st);
+  zix_system_free_block(allocator, buffer.block);
+  return finish_copy(dst_fd, src_fd, options, st);
+}
+
+ZixStatus
+zix_sync_files(const size_t             n_paths,
+               const char* const* const paths,
+               const ZixCopyOptions     options)
+{
+  const bool full = options & ZIX_COPY_OPTION_FULL_SYNC;
+  ZixStatus  st   = ZIX_STATUS_SUCCESS;
+  int        fds[SYNC_BATCH_SIZE];
+
+  for (size_t offset = 0U; offset < n_paths; offset += SYNC_BATCH_SIZE) {
+    const size_t n_left = n_paths - offset;
+    const size_t n      = (n_left < SYNC_BATCH_SIZE) ? n_left : SYNC_BATCH_SIZE;
+
+    // Open every file and start writing it back without waiting
+    for (size_t i = 0U; i < n; ++i) {
+      fds[i] = zix_system_open(paths[offset + i], O_RDONLY, 0);
+      if (fds[i] < 0) {
+        st = st ? st : zix_errno_status(errno);
+      }
+#if USE_SYNC_FILE_RANGE
+      else {
+        (void)sync_file_range(fds[i], 0, 0, SYNC_FILE_RANGE_WRITE);
+      }
+#endif
+    }
+
+    // Wait for every file to be written
+    for (size_t i = 0U; i < n; ++i) {
+      if (fds[i] >= 0) {
+#ifdef __APPLE__
+        (void)full;
+        const int rc = fsync(fds[i]);
+#else
+        const int rc = full ? fsync(fds[i]) : fdatasync(fds[i]);
+#endif
+        if (rc && !st) {
+          st = zix_errno_status(errno);
+        }
+      }
+    }
+
+#ifdef __APPLE__
+    // Flush the drive cache once for the whole batch
+    size_t last = n;
+    while (last > 0U && fds[last - 1U] < 0) {
+      --last;
+    }
+
+    if (last && fcntl(fds[last - 1U], F_FULLFSYNC) && !st) {
+      st = zix_errno_status(errno);
+    }
+#endif
+
+    for (size_t i = 0U; i < n; ++i) {
+      if (fds[i] >= 0) {
+        close(fds[i]);
+      }
+    }
+  }
+
+  return st;
 }
 
 ZixStatus
@@ -284,21 +464,39 @@ zix_remove(const char* const path)
   return zix_posix_status(remove(path));
 }
 
+ZixStatus
+zix_system_dir_for_each(const char* const          path,
+                        void* const                data,
+                        const ZixDirEntryVisitFunc f)
+{
+  DIR* const dir = opendir(path);
+  if (!dir) {
+    return zix_errno_status(errno);
+  }
+
+  // Reset errno to distinguish the end of the directory from an error
+  struct dirent* entry = NULL;
+  errno                = 0;
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  while ((entry = readdir(dir))) {
+    if (!!strcmp(entry->d_name, ".") && !!strcmp(entry->d_name, "..")) {
+      f(path, entry->d_name, data);
+    }
+
+    errno = 0;
+  }
+
+  const ZixStatus st = zix_errno_status(errno);
+  closedir(dir);
+  return st;
+}
+
 void
 zix_dir_for_each(const char* const          path,
                  void* const                data,
                  const ZixDirEntryVisitFunc f)
 {
-  DIR* dir = opendir(path);
-  if (dir) {
-    // NOLINTNEXTLINE(concurrency-mt-unsafe)
-    for (struct dirent* entry = NULL; (entry = readdir(dir));) {
-      if (!!strcmp(entry->d_name, ".") && !!strcmp(entry->d_name, "..")) {
-        f(path, entry->d_name, data);
-      }
-    }
-    closedir(dir);
-  }
+  (void)zix_system_dir_for_each(path, data, f);
 }
 
 char*
@@ -364,6 +562,102 @@ zix_file_unlock(FILE* const file, const ZixFileLockMode mode)
 #endif
 }
 
+#if USE_MMAP && USE_MADVISE
+
+static void
+advise_view(void* const data, const size_t size, const ZixFileMapHints hints)
+{
+  if (hints & ZIX_FILE_MAP_HINT_SEQUENTIAL) {
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+  } else if (hints & ZIX_FILE_MAP_HINT_RANDOM) {
+    (void)madvise(data, size, MADV_RANDOM);
+  }
+
+  if (hints & ZIX_FILE_MAP_HINT_WILL_NEED) {
+    (void)madvise(data, size, MADV_WILLNEED);
+  }
+
+#  ifdef MADV_HUGEPAGE
+  if (hints & ZIX_FILE_MAP_HINT_HUGE) {
+    (void)madvise(data, size, MADV_HUGEPAGE);
+  }
+#  endif
+}
+
+#endif
+
+ZixStatus
+zix_file_map(ZixAllocator* const   allocator,
+             const char* const     path,
+             const ZixFileMapMode  mode,
+             const ZixFileMapHints hints,
+             ZixFileView* const    view)
+{
+  (void)allocator;
+
+  view->data = NULL;
+  view->size = 0U;
+
+#if USE_MMAP
+  const bool write = mode == ZIX_FILE_MAP_READ_WRITE;
+  const int  fd    = zix_system_open(path, write ? O_RDWR : O_RDONLY, 0);
+  if (fd < 0) {
+    return zix_errno_status(errno);
+  }
+
+  struct stat     sb;
+  const ZixStatus st = fstat(fd, &sb)         ? zix_errno_status(errno)
+                       : !S_ISREG(sb.st_mode) ? ZIX_STATUS_BAD_ARG
+                       : ((uintmax_t)sb.st_size > (uintmax_t)SIZE_MAX)
+                         ? ZIX_STATUS_OVERFLOW
+                         : ZIX_STATUS_SUCCESS;
+
+  // Map the file, which stays mapped after the descriptor is closed
+  if (!st && sb.st_size) {
+    const int   prot = write ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* const data = mmap(NULL, (size_t)sb.st_size, prot, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      const ZixStatus map_st = zix_errno_status(errno);
+      close(fd);
+      return map_st;
+    }
+
+#  if USE_MADVISE
+    advise_view(data, (size_t)sb.st_size, hints);
+#  else
+    (void)hints;
+#  endif
+
+    view->data = data;
+    view->size = (size_t)sb.st_size;
+  }
+
+  close(fd);
+  return st;
+
+#else
+  (void)path;
+  (void)mode;
+  (void)hints;
+  return ZIX_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+ZixStatus
+zix_file_unmap(ZixFileView* const view)
+{
+#if USE_MMAP
+  const int rc = view->data ? munmap(view->data, view->size) : 0;
+
+  view->data = NULL;
+  view->size = 0U;
+  return zix_posix_status(rc);
+#else
+  (void)view;
+  return ZIX_STATUS_NOT_SUPPORTED;
+#endif
+}
+
 ZIX_CONST_FUNC static ZixFileType
 stat_file_type(const struct stat* sb)
 {
@@ -406,6 +700,681 @@ zix_symlink_type(const char* const path)
   return lstat(path, &sb) ? ZIX_FILE_TYPE_NONE : stat_file_type(&sb);
 }
 
+static int64_t
+stat_modified(const struct stat* const sb)
+{
+#ifdef __APPLE__
+  const struct timespec* const t = &sb->st_mtimespec;
+#else
+  const struct timespec* const t = &sb->st_mtim;
+#endif
+
+  return ((int64_t)t->tv_sec * 1000000000) + (int64_t)t->tv_nsec;
+}
+
+static void
+set_file_status(ZixFileStatus* const status, const struct stat* const sb)
+{
+  status->type     = stat_file_type(sb);
+  status->size     = (ZixFileOffset)sb->st_size;
+  status->modified = stat_modified(sb);
+  status->inode    = (uint64_t)sb->st_ino;
+  status->device   = (uint64_t)sb->st_dev;
+}
+
+ZixStatus
+zix_file_status(const char* const path, ZixFileStatus* const status)
+{
+  struct stat sb;
+  if (stat(path, &sb)) {
+    const ZixFileStatus none = {ZIX_FILE_TYPE_NONE, 0, 0, 0U, 0U};
+
+    *status = none;
+    return zix_errno_status(errno);
+  }
+
+  set_file_status(status, &sb);
+  return ZIX_STATUS_SUCCESS;
+}
+
+/*
+  Directory trees are walked depth-first, with directories opened relative to
+  their parent where possible.  When using threads, each subdirectory of the
+  root is a job.  If there are too few jobs to keep every thread busy, then
+  each job is split into jobs for its own subdirectories, level by level, up
+  to a maximum depth.  Threads then claim jobs until they're all finished, and
+  the split directories are visited last if the walk is post-order.
+*/
+
+#define WALK_THREAD_STACK_SIZE 65536U ///< Stack size of tree walk threads
+#define WALK_JOBS_PER_THREAD 4U       ///< Number of jobs to split a tree into
+#define WALK_MAX_SPLIT_DEPTH 8U       ///< Maximum depth of split directories
+
+/// A path string that is extended and truncated while walking a tree
+typedef struct {
+  char*  buf;  ///< Path string
+  size_t len;  ///< Length of path string
+  size_t size; ///< Allocated size of buffer
+} WalkPath;
+
+/// A subdirectory to walk in parallel
+typedef struct {
+  char*         path;   ///< Path of directory relative to the root
+  ZixFileStatus status; ///< Status of directory, if requested
+  unsigned      depth;  ///< Depth of directory in the tree
+} WalkJob;
+
+/// A dynamic array of jobs
+typedef struct {
+  WalkJob* jobs;     ///< Array of jobs
+  size_t   n_jobs;   ///< Number of jobs
+  size_t   capacity; ///< Allocated size of jobs array
+} WalkJobs;
+
+typedef struct DirWalkImpl DirWalk;
+
+/// Function called for every file in a tree, with its parent directory or null
+typedef ZixStatus (*WalkVisitFunc)(const DirWalk*         walk,
+                                   DIR*                   parent,
+                                   const ZixDirWalkEntry* entry);
+
+/// The state of walking a tree, shared between all threads
+struct DirWalkImpl {
+  ZixAllocator*     allocator; ///< Allocator for paths and jobs
+  ZixDirWalkOptions options;   ///< Options for walking
+  WalkVisitFunc     visit;     ///< Function to call for every file
+  ZixDirWalkFunc    func;      ///< User function to call for every file
+  void*             data;      ///< User data passed to func
+  const char*       root;      ///< Root path
+  size_t            root_len;  ///< Length of root path with a separator
+  DIR*              root_dir;  ///< Root directory
+  WalkJobs          jobs;      ///< Subdirectories to walk in parallel
+  WalkJobs          splits;    ///< Subdirectories that were split into jobs
+  uint64_t          next_job;  ///< Index of the next job to start
+  uint32_t          status;    ///< First error, or success
+};
+
+static ZixFileType
+dirent_file_type(const struct dirent* const entry)
+{
+#ifdef DT_UNKNOWN
+  switch (entry->d_type) {
+  case DT_REG:
+    return ZIX_FILE_TYPE_REGULAR;
+  case DT_DIR:
+    return ZIX_FILE_TYPE_DIRECTORY;
+  case DT_LNK:
+    return ZIX_FILE_TYPE_SYMLINK;
+  case DT_BLK:
+    return ZIX_FILE_TYPE_BLOCK;
+  case DT_CHR:
+    return ZIX_FILE_TYPE_CHARACTER;
+  case DT_FIFO:
+    return ZIX_FILE_TYPE_FIFO;
+  case DT_SOCK:
+    return ZIX_FILE_TYPE_SOCKET;
+  default:
+    break;
+  }
+#else
+  (void)entry;
+#endif
+
+  return ZIX_FILE_TYPE_NONE; // Unknown, so the file must be queried
+}
+
+/// Append a name to a path, with a separator if necessary
+static ZixStatus
+walk_path_push(ZixAllocator* const allocator,
+               WalkPath* const     path,
+               const char* const   name)
+{
+  const size_t name_len = strlen(name);
+  const bool   sep      = path->len && path->buf[path->len - 1U] != '/';
+  const size_t len      = path->len + (sep ? 1U : 0U) + name_len;
+
+  if (len >= path->size) {
+    const size_t size = (len + 1U) * 2U;
+    char* const  buf  = (char*)zix_realloc(allocator, path->buf, size);
+    if (!buf) {
+      return ZIX_STATUS_NO_MEM;
+    }
+
+    path->buf  = buf;
+    path->size = size;
+  }
+
+  if (sep) {
+    path->buf[path->len++] = '/';
+  }
+
+  memcpy(path->buf + path->len, name, name_len + 1U);
+  path->len = len;
+  return ZIX_STATUS_SUCCESS;
+}
+
+static void
+walk_path_truncate(WalkPath* const path, const size_t len)
+{
+  path->len      = len;
+  path->buf[len] = '\0';
+}
+
+static DIR*
+open_child_dir(DIR* const        parent,
+               const char* const name,
+               const char* const path)
+{
+#if USE_OPENAT
+  (void)path;
+
+  const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW;
+  const int fd    = openat(dirfd(parent), name, flags);
+  DIR*      dir   = (fd >= 0) ? fdopendir(fd) : NULL;
+  if (fd >= 0 && !dir) {
+    close(fd);
+  }
+
+  return dir;
+#else
+  (void)parent;
+  (void)name;
+  return opendir(path);
+#endif
+}
+
+static int
+stat_child(DIR* const         parent,
+           const char* const  name,
+           const char* const  path,
+           struct stat* const sb)
+{
+#if USE_OPENAT
+  (void)path;
+  return fstatat(dirfd(parent), name, sb, AT_SYMLINK_NOFOLLOW);
+#else
+  (void)parent;
+  (void)name;
+  return lstat(path, sb);
+#endif
+}
+
+/// Add an uninitialized job to the end of an array, or return null
+static WalkJob*
+new_walk_job(ZixAllocator* const allocator, WalkJobs* const jobs)
+{
+  if (jobs->n_jobs == jobs->capacity) {
+    const size_t   capacity = jobs->capacity ? (jobs->capacity * 2U) : 64U;
+    WalkJob* const array    = (WalkJob*)zix_realloc(
+      allocator, jobs->jobs, capacity * sizeof(WalkJob));
+    if (!array) {
+      return NULL;
+    }
+
+    jobs->jobs     = array;
+    jobs->capacity = capacity;
+  }
+
+  return &jobs->jobs[jobs->n_jobs++];
+}
+
+static void
+free_walk_jobs(ZixAllocator* const allocator, const WalkJobs* const jobs)
+{
+  for (size_t i = 0U; i < jobs->n_jobs; ++i) {
+    zix_free(allocator, jobs->jobs[i].path);
+  }
+
+  zix_free(allocator, jobs->jobs);
+}
+
+static ZixStatus
+push_walk_job(DirWalk* const             walk,
+              const char* const          path,
+              const unsigned             depth,
+              const ZixFileStatus* const status)
+{
+  const size_t path_len = strlen(path);
+  char* const  copy     = (char*)zix_malloc(walk->allocator, path_len + 1U);
+  if (!copy) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  WalkJob* const job = new_walk_job(walk->allocator, &walk->jobs);
+  if (!job) {
+    zix_free(walk->allocator, copy);
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  memcpy(copy, path, path_len + 1U);
+  job->path  = copy;
+  job->depth = depth;
+  if (status) {
+    job->status = *status;
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+static ZixStatus
+walk_dir(DirWalk* walk, WalkPath* path, DIR* dir, unsigned depth, bool defer);
+
+static ZixStatus
+walk_entry(DirWalk* const             walk,
+           WalkPath* const            path,
+           DIR* const                 dir,
+           const struct dirent* const dirent,
+           const unsigned             depth,
+           const bool                 defer)
+{
+  ZixStatus st = walk_path_push(walk->allocator, path, dirent->d_name);
+  if (st) {
+    return st;
+  }
+
+  const size_t    name_offset = path->len - strlen(dirent->d_name);
+  ZixFileStatus   status      = {ZIX_FILE_TYPE_NONE, 0, 0, 0U, 0U};
+  ZixDirWalkEntry entry       = {
+    path->buf, path->buf + name_offset, NULL, dirent_file_type(dirent), depth};
+
+  // Query the file if necessary, skipping it if it no longer exists
+  if (entry.type == ZIX_FILE_TYPE_NONE ||
+      (walk->options & ZIX_DIR_WALK_STATUS)) {
+    struct stat sb;
+    if (stat_child(dir, dirent->d_name, path->buf, &sb)) {
+      return (errno == ENOENT) ? ZIX_STATUS_SUCCESS : zix_errno_status(errno);
+    }
+
+    set_file_status(&status, &sb);
+    entry.type = status.type;
+    if (walk->options & ZIX_DIR_WALK_STATUS) {
+      entry.status = &status;
+    }
+  }
+
+  if (entry.type != ZIX_FILE_TYPE_DIRECTORY) {
+    return walk->visit(walk, dir, &entry);
+  }
+
+  // Visit a directory before its contents if it's pre-order
+  const bool post_order = walk->options & ZIX_DIR_WALK_POST_ORDER;
+  if (!post_order && (st = walk->visit(walk, dir, &entry))) {
+    return st;
+  }
+
+  // Defer the directory to a job, or walk its contents now
+  if (defer) {
+    return push_walk_job(walk, path->buf + walk->root_len, depth, entry.status);
+  }
+
+  DIR* const child = open_child_dir(dir, dirent->d_name, path->buf);
+  if (!child) {
+    return (errno == ENOENT) ? ZIX_STATUS_SUCCESS : zix_errno_status(errno);
+  }
+
+  st = walk_dir(walk, path, child, depth + 1U, false);
+  closedir(child);
+
+  // Visit a directory after its contents if it's post-order
+  if (!st && post_order) {
+    entry.path = path->buf; // Buffer may have been reallocated
+    entry.name = path->buf + name_offset;
+    st         = walk->visit(walk, dir, &entry);
+  }
+
+  return st;
+}
+
+static ZixStatus
+walk_dir(DirWalk* const  walk,
+         WalkPath* const path,
+         DIR* const      dir,
+         const unsigned  depth,
+         const bool      defer)
+{
+  const size_t dir_len = path->len;
+  ZixStatus    st      = ZIX_STATUS_SUCCESS;
+
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  for (struct dirent* e = NULL;
+       !st && !zix_atomic_load(&walk->status) && (e = readdir(dir));) {
+    if (!!strcmp(e->d_name, ".") && !!strcmp(e->d_name, "..")) {
+      st = walk_entry(walk, path, dir, e, depth, defer);
+      walk_path_truncate(path, dir_len);
+    }
+  }
+
+  return st;
+}
+
+static void
+set_walk_status(DirWalk* const walk, const ZixStatus status)
+{
+  uint32_t success = 0U;
+  (void)zix_atomic_cas(&walk->status, &success, (uint32_t)status);
+}
+
+/// Open the directory of a job, or return null and set `status` on failure
+static DIR*
+open_walk_job(const DirWalk* const walk,
+              WalkPath* const      path,
+              const WalkJob* const job,
+              ZixStatus* const     status)
+{
+  if ((*status = walk_path_push(walk->allocator, path, job->path))) {
+    return NULL;
+  }
+
+  DIR* const dir = open_child_dir(walk->root_dir, job->path, path->buf);
+  if (!dir && errno != ENOENT) {
+    *status = zix_errno_status(errno);
+  }
+
+  return dir;
+}
+
+/// Visit the directory of a job after its contents, with its path in `path`
+static ZixStatus
+visit_walk_job(const DirWalk* const  walk,
+               const WalkPath* const path,
+               const WalkJob* const  job)
+{
+  const char* const     sep   = strrchr(job->path, '/');
+  const char* const     name  = sep ? sep + 1 : job->path;
+  const bool            stat  = walk->options & ZIX_DIR_WALK_STATUS;
+  const ZixDirWalkEntry entry = {path->buf,
+                                 path->buf + path->len - strlen(name),
+                                 stat ? &job->status : NULL,
+                                 ZIX_FILE_TYPE_DIRECTORY,
+                                 job->depth};
+
+  // Only the root is open, so deeper parents must be accessed by path
+  return walk->visit(walk, (job->depth == 1U) ? walk->root_dir : NULL, &entry);
+}
+
+static ZixStatus
+walk_job(DirWalk* const walk, WalkPath* const path, const WalkJob* const job)
+{
+  ZixStatus  st  = ZIX_STATUS_SUCCESS;
+  DIR* const dir = open_walk_job(walk, path, job, &st);
+  if (!dir) {
+    return st; // Success if the directory no longer exists
+  }
+
+  st = walk_dir(walk, path, dir, job->depth + 1U, false);
+  closedir(dir);
+
+  if (!st && (walk->options & ZIX_DIR_WALK_POST_ORDER)) {
+    st = visit_walk_job(walk, path, job);
+  }
+
+  return st;
+}
+
+static void
+run_walk_jobs(DirWalk* const walk)
+{
+  WalkPath     path     = {NULL, 0U, 0U};
+  ZixStatus    st       = walk_path_push(walk->allocator, &path, walk->root);
+  const size_t root_len = path.len;
+
+  while (!st && !zix_atomic_load(&walk->status)) {
+    const uint64_t i = zix_atomic_add64(&walk->next_job, 1U);
+    if (i >= walk->jobs.n_jobs) {
+      break;
+    }
+
+    st = walk_job(walk, &path, &walk->jobs.jobs[i]);
+    walk_path_truncate(&path, root_len);
+  }
+
+  if (st) {
+    set_walk_status(walk, st);
+  }
+
+  zix_free(walk->allocator, path.buf);
+}
+
+#if USE_THREADS
+
+static ZixThreadResult ZIX_THREAD_FUNC
+walk_thread(void* const arg)
+{
+  run_walk_jobs((DirWalk*)arg);
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+run_walk_job_threads(DirWalk* const walk, const unsigned n_threads)
+{
+  // Launch extra threads, but never more than there are directories to walk
+  size_t n_extra = n_threads - 1U;
+  if (n_extra > walk->jobs.n_jobs) {
+    n_extra = walk->jobs.n_jobs;
+  }
+
+  ZixThread* const threads =
+    (ZixThread*)zix_calloc(walk->allocator, n_extra, sizeof(ZixThread));
+
+  size_t n_launched = 0U;
+  while (threads && n_launched < n_extra &&
+         !zix_thread_create(&threads[n_launched],
+                            WALK_THREAD_STACK_SIZE,
+                            walk_thread,
+                            walk)) {
+    ++n_launched;
+  }
+
+  // Walk in this thread as well, which does everything if no threads launched
+  run_walk_jobs(walk);
+
+  for (size_t i = 0U; i < n_launched; ++i) {
+    zix_thread_join(threads[i]);
+  }
+
+  zix_free(walk->allocator, threads);
+}
+
+/// Replace every job with jobs for its subdirectories, and keep it as a split
+static ZixStatus
+split_walk_jobs(DirWalk* const walk, WalkPath* const path)
+{
+  const WalkJobs level   = walk->jobs;
+  const size_t   dir_len = path->len;
+  ZixStatus      st      = ZIX_STATUS_SUCCESS;
+
+  walk->jobs.jobs     = NULL;
+  walk->jobs.n_jobs   = 0U;
+  walk->jobs.capacity = 0U;
+
+  for (size_t i = 0U; i < level.n_jobs; ++i) {
+    const WalkJob* const job = &level.jobs[i];
+    DIR* const           dir = st ? NULL : open_walk_job(walk, path, job, &st);
+    if (dir) {
+      st = walk_dir(walk, path, dir, job->depth + 1U, true);
+      closedir(dir);
+    }
+
+    walk_path_truncate(path, dir_len);
+
+    // Keep the directory to visit later, unless it no longer exists
+    WalkJob* const split =
+      dir ? new_walk_job(walk->allocator, &walk->splits) : NULL;
+    if (split) {
+      *split = *job;
+    } else {
+      st = (st || !dir) ? st : ZIX_STATUS_NO_MEM;
+      zix_free(walk->allocator, job->path);
+    }
+  }
+
+  zix_free(walk->allocator, level.jobs);
+  return st;
+}
+
+static ZixStatus
+run_walk_threads(DirWalk* const  walk,
+                 WalkPath* const root,
+                 const unsigned  n_threads)
+{
+  // Split jobs until there are enough to keep every thread busy
+  const size_t n_wanted = (size_t)n_threads * WALK_JOBS_PER_THREAD;
+  ZixStatus    st       = ZIX_STATUS_SUCCESS;
+  for (unsigned depth = 1U; !st && depth < WALK_MAX_SPLIT_DEPTH &&
+                            walk->jobs.n_jobs && walk->jobs.n_jobs < n_wanted;
+       ++depth) {
+    st = split_walk_jobs(walk, root);
+  }
+
+  if (st) {
+    return st;
+  }
+
+  run_walk_job_threads(walk, n_threads);
+
+  // Visit split directories after their contents, deepest first
+  if (!walk->status && (walk->options & ZIX_DIR_WALK_POST_ORDER)) {
+    const size_t root_len = root->len;
+    for (size_t i = walk->splits.n_jobs; !st && i > 0U; --i) {
+      const WalkJob* const split = &walk->splits.jobs[i - 1U];
+      if (!(st = walk_path_push(walk->allocator, root, split->path))) {
+        st = visit_walk_job(walk, root, split);
+      }
+
+      walk_path_truncate(root, root_len);
+    }
+  }
+
+  return st;
+}
+
+#endif
+
+static ZixStatus
+walk_tree(DirWalk* const walk, const unsigned n_threads)
+{
+  if (!(walk->root_dir = opendir(walk->root))) {
+    return zix_errno_status(errno);
+  }
+
+  WalkPath  root = {NULL, 0U, 0U};
+  ZixStatus st   = walk_path_push(walk->allocator, &root, walk->root);
+
+  // Relative paths of jobs start after the separator that follows the root
+  walk->root_len =
+    root.len + ((root.len && root.buf[root.len - 1U] != '/') ? 1U : 0U);
+
+#if USE_THREADS
+  if (!st && n_threads > 1U) {
+    // Walk the root and collect subdirectories, then walk them in parallel
+    st = walk_dir(walk, &root, walk->root_dir, 1U, true);
+    if (!st) {
+      st = run_walk_threads(walk, &root, n_threads);
+    }
+  } else if (!st) {
+    st = walk_dir(walk, &root, walk->root_dir, 1U, false);
+  }
+#else
+  (void)n_threads;
+  if (!st) {
+    st = walk_dir(walk, &root, walk->root_dir, 1U, false);
+  }
+#endif
+
+  free_walk_jobs(walk->allocator, &walk->splits);
+  free_walk_jobs(walk->allocator, &walk->jobs);
+  zix_free(walk->allocator, root.buf);
+  closedir(walk->root_dir);
+  return st ? st : (ZixStatus)walk->status;
+}
+
+static ZixStatus
+visit_walk_entry(const DirWalk* const         walk,
+                 DIR* const                   parent,
+                 const ZixDirWalkEntry* const entry)
+{
+  (void)parent;
+  return walk->func(walk->data, entry);
+}
+
+ZixStatus
+zix_dir_walk(ZixAllocator* const     allocator,
+             const char* const       path,
+             const ZixDirWalkOptions options,
+             const unsigned          n_threads,
+             const ZixDirWalkFunc    f,
+             void* const             data)
+{
+  DirWalk walk = {allocator,
+                  options,
+                  visit_walk_entry,
+                  f,
+                  data,
+                  path,
+                  0U,
+                  NULL,
+                  {NULL, 0U, 0U},
+                  {NULL, 0U, 0U},
+                  0U,
+                  0U};
+
+  return walk_tree(&walk, n_threads);
+}
+
+static ZixStatus
+remove_walk_entry(const DirWalk* const         walk,
+                  DIR* const                   parent,
+                  const ZixDirWalkEntry* const entry)
+{
+  (void)walk;
+
+#if USE_OPENAT
+  const bool dir = entry->type == ZIX_FILE_TYPE_DIRECTORY;
+  const int  rc  = parent ? unlinkat(dirfd(parent),
+                                   entry->name,
+                                   dir ? AT_REMOVEDIR : 0)
+                          : remove(entry->path);
+#else
+  (void)parent;
+  const int rc = remove(entry->path);
+#endif
+
+  // Ignore files that have already been removed by something else
+  return (rc && errno != ENOENT) ? zix_errno_status(errno) : ZIX_STATUS_SUCCESS;
+}
+
+ZixStatus
+zix_remove_all(ZixAllocator* const allocator,
+               const char* const   path,
+               const unsigned      n_threads)
+{
+  struct stat sb;
+  if (lstat(path, &sb)) {
+    return zix_errno_status(errno);
+  }
+
+  if (!S_ISDIR(sb.st_mode)) {
+    return zix_remove(path);
+  }
+
+  // Remove everything in the directory depth-first, then the directory itself
+  DirWalk walk = {allocator,
+                  ZIX_DIR_WALK_POST_ORDER,
+                  remove_walk_entry,
+                  NULL,
+                  NULL,
+                  path,
+                  0U,
+                  NULL,
+                  {NULL, 0U, 0U},
+                  {NULL, 0U, 0U},
+                  0U,
+                  0U};
+
+  const ZixStatus st = walk_tree(&walk, n_threads);
+  return st ? st : zix_remove(path);
+}
+
 char*
 zix_temp_directory_path(ZixAllocator* const allocator)
 {
@@ -1,12 +1,31 @@
 // Copyright 2007-2025 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
+#include "../errno_status.h"
 #include "../system.h"
 #include "../zix_config.h"
 
+#include <zix/allocator.h>
+#include <zix/page_allocator.h>
+#include <zix/status.h>
+
+#if USE_MEMFD_CREATE || USE_MMAP
+#  include <sys/mman.h>
+#endif
+
+#if USE_MBIND
+#  include <sys/syscall.h>
+#endif
+
+#if USE_GETENTROPY
+#  include <sys/random.h>
+#endif
+
+#include <errno.h>
 #include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -15,6 +34,9 @@
 #  define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
 
+#define ZIX_MAX_NUMA_NODES 1024U
+#define ZIX_MPOL_PREFERRED 1 // From linux/mempolicy.h
+
 #ifdef PAGE_SIZE
 #  define ZIX_DEFAULT_PAGE_SIZE PAGE_SIZE
 #else
@@ -32,6 +54,223 @@ zix_system_page_size(void)
 #endif
 }
 
+void*
+zix_system_map_mirrored(const size_t size)
+{
+#if USE_MEMFD_CREATE
+  const int fd = memfd_create("zix", MFD_CLOEXEC);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  // Reserve enough address space for both copies, then map the file over it
+  char* buf  = NULL;
+  void* addr = NULL;
+  if (!ftruncate(fd, (off_t)size) &&
+      (addr = mmap(NULL,
+                   2U * size,
+                   PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, // NOLINT(hicpp-signed-bitwise)
+                   -1,
+                   0)) != MAP_FAILED) {
+    buf = (char*)addr;
+    for (size_t i = 0U; buf && i < 2U; ++i) {
+      if (mmap(buf + (i * size),
+               size,
+               PROT_READ | PROT_WRITE, // NOLINT(hicpp-signed-bitwise)
+               MAP_SHARED | MAP_FIXED, // NOLINT(hicpp-signed-bitwise)
+               fd,
+               0) == MAP_FAILED) {
+        munmap(addr, 2U * size);
+        buf = NULL;
+      }
+    }
+  }
+
+  close(fd);
+  return buf;
+
+#else
+  (void)size;
+  return NULL;
+#endif
+}
+
+void
+zix_system_unmap_mirrored(void* const buf, const size_t size)
+{
+#if USE_MEMFD_CREATE
+  if (buf) {
+    munmap(buf, 2U * size);
+  }
+#else
+  (void)buf;
+  (void)size;
+#endif
+}
+
+void*
+zix_system_map_pages(const size_t   size,
+                     const size_t   alignment,
+                     const uint32_t options,
+                     const int      numa_node)
+{
+#if USE_MMAP && defined(MAP_ANONYMOUS)
+  const int prot  = PROT_READ | PROT_WRITE;     // NOLINT(hicpp-signed-bitwise)
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
+
+  char* buf = NULL;
+
+#  ifdef MAP_HUGETLB
+  if (options & ZIX_PAGE_OPTION_HUGE) {
+    // Huge pages are aligned to their size, which may not be enough
+    void* const addr = mmap(NULL, size, prot, flags | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED && (uintptr_t)addr % alignment) {
+      munmap(addr, size);
+    } else if (addr != MAP_FAILED) {
+      buf = (char*)addr;
+    }
+  }
+#  endif
+
+  if (!buf) {
+    // Map enough to align the start, then unmap the excess around it
+    if (size > SIZE_MAX - alignment) {
+      return NULL;
+    }
+
+    void* const addr = mmap(NULL, size + alignment, prot, flags, -1, 0);
+    if (addr == MAP_FAILED) {
+      return NULL;
+    }
+
+    const uintptr_t begin = (uintptr_t)addr;
+    const size_t    head  = (alignment - (begin % alignment)) % alignment;
+    const size_t    tail  = alignment - head;
+
+    buf = (char*)addr + head;
+    if (head) {
+      munmap(addr, head);
+    }
+
+    if (tail) {
+      munmap(buf + size, tail);
+    }
+
+#  if USE_MADVISE && defined(MADV_HUGEPAGE)
+    if (options & ZIX_PAGE_OPTION_TRANSPARENT_HUGE) {
+      madvise(buf, size, MADV_HUGEPAGE);
+    }
+#  endif
+  }
+
+#  if USE_MBIND && defined(SYS_mbind)
+  if (numa_node >= 0 && (unsigned)numa_node < ZIX_MAX_NUMA_NODES) {
+    static const size_t bits = 8U * sizeof(unsigned long);
+
+    // Prefer (but don't require) the node, so allocation can't fail later
+    unsigned long mask[ZIX_MAX_NUMA_NODES / (8U * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+
+    const unsigned node = (unsigned)numa_node;
+    mask[node / bits] |= 1UL << (node % bits);
+    syscall(SYS_mbind,
+            buf,
+            size,
+            ZIX_MPOL_PREFERRED,
+            mask,
+            (unsigned long)ZIX_MAX_NUMA_NODES + 1UL,
+            0U);
+  }
+#  else
+  (void)numa_node;
+#  endif
+
+  return buf;
+
+#else
+  (void)size;
+  (void)alignment;
+  (void)options;
+  (void)numa_node;
+  return NULL;
+#endif
+}
+
+void
+zix_system_unmap_pages(void* const buf, const size_t size)
+{
+#if USE_MMAP && defined(MAP_ANONYMOUS)
+  if (buf) {
+    munmap(buf, size);
+  }
+#else
+  (void)buf;
+  (void)size;
+#endif
+}
+
+void*
+zix_system_map_file(const int fd, const size_t size)
+{
+#if USE_MMAP
+  void* const buf = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (buf == MAP_FAILED) {
+    return NULL;
+  }
+
+#  if USE_MADVISE
+  (void)madvise(buf, size, MADV_SEQUENTIAL);
+#  endif
+
+  return buf;
+#else
+  (void)fd;
+  (void)size;
+  return NULL;
+#endif
+}
+
+void
+zix_system_unmap_file(void* const buf, const size_t size)
+{
+#if USE_MMAP
+  if (buf) {
+    munmap(buf, size);
+  }
+#else
+  (void)buf;
+  (void)size;
+#endif
+}
+
+ZixStatus
+zix_system_random(void* const buf, const size_t size)
+{
+#if USE_GETENTROPY
+  return zix_errno_status_if(getentropy(buf, size));
+
+#else
+  const int fd = zix_system_open("/dev/urandom", O_RDONLY, 0);
+  if (fd < 0) {
+    return zix_errno_status(errno);
+  }
+
+  size_t  n = 0U;
+  ssize_t r = 0;
+  while (n < size && (r = read(fd, (char*)buf + n, size - n)) > 0) {
+    n += (size_t)r;
+  }
+
+  const ZixStatus st = (n == size) ? ZIX_STATUS_SUCCESS
+                                   : r ? zix_errno_status(errno)
+                                       : ZIX_STATUS_ERROR;
+
+  close(fd);
+  return st;
+#endif
+}
+
 uint32_t
 zix_system_max_block_size(const struct stat* const s1,
                           const struct stat* const s2,
@@ -63,3 +302,39 @@ zix_system_read(const int fd, void* const buf, const size_t count)
 {
   return read(fd, buf, count);
 }
+
+ssize_t
+zix_system_write(const int fd, const void* const buf, const size_t count)
+{
+  return write(fd, buf, count);
+}
+
+ZixStatus
+zix_system_copy_link(ZixAllocator* const allocator,
+                     const char* const   src,
+                     const char* const   dst)
+{
+  // Read the target into a buffer, growing it until the target fits
+  char*     target = NULL;
+  ZixStatus st     = ZIX_STATUS_SUCCESS;
+  for (size_t size = 256U; !st; size *= 2U) {
+    char* const buf = (char*)zix_realloc(allocator, target, size);
+    if (!buf) {
+      st = ZIX_STATUS_NO_MEM;
+      break;
+    }
+
+    target          = buf;
+    const ssize_t n = readlink(src, target, size);
+    if (n < 0) {
+      st = zix_errno_status(errno);
+    } else if ((size_t)n < size) {
+      target[n] = '\0';
+      st        = zix_errno_status_if(symlink(target, dst));
+      break;
+    }
+  }
+
+  zix_free(allocator, target);
+  return st;
+}
@@ -3,63 +3,67 @@
 
 #include <zix/ring.h>
 
+#include "atomic.h"
 #include "errno_status.h"
+#include "system.h"
 #include "zix_config.h"
 
 #include <zix/allocator.h>
 #include <zix/attributes.h>
 #include <zix/status.h>
 
-#if USE_VIRTUALLOCK
+#ifdef _WIN32
 #  include <windows.h>
 #elif USE_MLOCK
 #  include <sys/mman.h>
 #endif
 
-/*
-  Note that for simplicity, only x86 and x64 are supported with MSVC.  Hopefully
-  stdatomic.h support arrives before anyone cares about running this code on
-  Windows on ARM.
-*/
-#ifdef _MSC_VER
-#  include <intrin.h>
+#if USE_FUTEX
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#if USE_FUTEX || USE_NANOSLEEP
+#  include <time.h>
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
-struct ZixRingImpl {
-  ZixAllocator* allocator;  ///< User allocator
-  uint32_t      write_head; ///< Read index into buf
-  uint32_t      read_head;  ///< Write index into buf
-  uint32_t      size;       ///< Size (capacity) in bytes
-  uint32_t      size_mask;  ///< Mask for fast modulo
-  char*         buf;        ///< Contents
-};
+/*
+  The ring is allocated at the start of a cache line, and each thread's fields
+  are on a separate line, so that writing to one doesn't invalidate the line
+  that the other thread is reading.  The sleeping flag, which the writer
+  checks after every write, is only written when the reader goes to sleep or
+  is woken, so it's also on its own line.  The fields shared by both threads
+  are only written when the ring is created, so they can share a line.
+*/
 
-static inline uint32_t
-zix_atomic_load(const uint32_t* const ptr)
-{
-#ifdef _MSC_VER
-  const uint32_t val = *ptr;
-  _ReadBarrier();
-  return val;
-#else
-  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
-#endif
-}
+#define HEAD_PAD_SIZE (ZIX_CACHE_LINE_SIZE - (2U * sizeof(uint32_t)))
+#define FLAG_PAD_SIZE (ZIX_CACHE_LINE_SIZE - sizeof(uint32_t))
 
-static inline void
-zix_atomic_store(uint32_t* const ptr, // NOLINT(readability-non-const-parameter)
-                 const uint32_t  val)
-{
-#ifdef _MSC_VER
-  _WriteBarrier();
-  *ptr = val;
-#else
-  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
-#endif
-}
+#define NS_PER_SECOND 1000000000U
+#define MAX_WAIT_SPINS 1024U // Maximum busy-wait iterations before sleeping
+#define MAX_SLEEP_NS 1000000U // Longest sleep when waiting isn't supported
+
+struct ZixRingImpl {
+  uint32_t      write_head;       ///< Write index into buf
+  uint32_t      read_head_cache;  ///< Last read head seen by the writer
+  char          write_pad[HEAD_PAD_SIZE];
+  uint32_t      read_head;        ///< Read index into buf
+  uint32_t      write_head_cache; ///< Last write head seen by the reader
+  char          read_pad[HEAD_PAD_SIZE];
+  uint32_t      sleeping;  ///< True if the reader is waiting to be notified
+  char          sleeping_pad[FLAG_PAD_SIZE];
+  ZixAllocator* allocator; ///< User allocator
+  uint32_t      size;      ///< Size (capacity) in bytes
+  uint32_t      size_mask; ///< Mask for fast modulo
+  bool          mirrored;  ///< True if buf is mapped twice consecutively
+  char*         buf;       ///< Contents
+};
 
 static inline uint32_t
 next_power_of_two(uint32_t size)
@@ -75,6 +79,20 @@ next_power_of_two(uint32_t size)
   return size;
 }
 
+static ZixRing*
+new_ring(ZixAllocator* const allocator)
+{
+  ZixRing* const ring = (ZixRing*)zix_aligned_alloc(
+    allocator, ZIX_CACHE_LINE_SIZE, sizeof(ZixRing));
+
+  if (ring) {
+    memset(ring, 0, sizeof(ZixRing));
+    ring->allocator = allocator;
+  }
+
+  return ring;
+}
+
 ZixRing*
 zix_ring_new(ZixAllocator* const allocator, const uint32_t size)
 {
@@ -82,17 +100,15 @@ zix_ring_new(ZixAllocator* const allocator, const uint32_t size)
     return NULL;
   }
 
-  ZixRing* ring = (ZixRing*)zix_malloc(allocator, sizeof(ZixRing));
+  ZixRing* ring = new_ring(allocator);
 
   if (ring) {
-    ring->allocator  = allocator;
-    ring->write_head = 0;
-    ring->read_head  = 0;
-    ring->size       = next_power_of_two(size);
-    ring->size_mask  = ring->size - 1U;
+    ring->size      = next_power_of_two(size);
+    ring->size_mask = ring->size - 1U;
+    ring->mirrored  = false;
 
     if (!(ring->buf = (char*)zix_malloc(allocator, ring->size))) {
-      zix_free(allocator, ring);
+      zix_aligned_free(allocator, ring);
       return NULL;
     }
   }
@@ -100,30 +116,67 @@ zix_ring_new(ZixAllocator* const allocator, const uint32_t size)
   return ring;
 }
 
+ZixRing*
+zix_ring_new_mirrored(ZixAllocator* const allocator, const uint32_t size)
+{
+  if (size < 2U || size > 2147483648U) {
+    return NULL;
+  }
+
+  // Page sizes are powers of two, so this is both a power of two and aligned
+  const uint32_t page_size = zix_system_page_size();
+  const uint32_t rounded   = next_power_of_two(size);
+  const uint32_t real_size = rounded < page_size ? page_size : rounded;
+
+  char* const buf = (char*)zix_system_map_mirrored(real_size);
+  if (!buf) {
+    return zix_ring_new(allocator, size);
+  }
+
+  ZixRing* const ring = new_ring(allocator);
+  if (!ring) {
+    zix_system_unmap_mirrored(buf, real_size);
+    return NULL;
+  }
+
+  ring->size      = real_size;
+  ring->size_mask = real_size - 1U;
+  ring->mirrored  = true;
+  ring->buf       = buf;
+  return ring;
+}
+
 void
 zix_ring_free(ZixRing* const ring)
 {
   if (ring) {
-    zix_free(ring->allocator, ring->buf);
-    zix_free(ring->allocator, ring);
+    if (ring->mirrored) {
+      zix_system_unmap_mirrored(ring->buf, ring->size);
+    } else {
+      zix_free(ring->allocator, ring->buf);
+    }
+
+    zix_aligned_free(ring->allocator, ring);
   }
 }
 
 ZixStatus
 zix_ring_mlock(ZixRing* const ring)
 {
+  const size_t buf_size = (ring->mirrored ? 2U : 1U) * (size_t)ring->size;
+
 #if USE_VIRTUALLOCK
   return (VirtualLock(ring, sizeof(ZixRing)) &&
-          VirtualLock(ring->buf, ring->size))
+          VirtualLock(ring->buf, buf_size))
            ? ZIX_STATUS_SUCCESS
            : ZIX_STATUS_ERROR;
 
 #elif USE_MLOCK
   return zix_errno_status_if(mlock(ring, sizeof(ZixRing)) +
-                             mlock(ring->buf, ring->size));
+                             mlock(ring->buf, buf_size));
 
 #else
-  (void)ring;
+  (void)buf_size;
   return ZIX_STATUS_NOT_SUPPORTED;
 #endif
 }
@@ -131,14 +184,22 @@ zix_ring_mlock(ZixRing* const ring)
 ZIX_REALTIME void
 zix_ring_reset(ZixRing* const ring)
 {
-  ring->write_head = 0;
-  ring->read_head  = 0;
+  ring->write_head       = 0;
+  ring->read_head_cache  = 0;
+  ring->read_head        = 0;
+  ring->write_head_cache = 0;
+  ring->sleeping         = 0;
 }
 
 /*
-  General pattern for public thread-safe functions below: start with a single
-  atomic load of the "other's" index, then do whatever work, and finally end
-  with a single atomic store to "your" index (if it is changed).
+  General pattern for public thread-safe functions below: start with the
+  cached value of the "other's" index, and only do an atomic load of the real
+  one if that doesn't allow for enough space, then do whatever work, and
+  finally end with a single atomic store to "your" index (if it is changed).
+
+  A cached index is always a value that the other thread has published, and
+  the other thread only moves its index forwards, so the space calculated from
+  a cached index is a safe underestimate.
 */
 
 static inline uint32_t
@@ -173,6 +234,30 @@ zix_ring_write_space(const ZixRing* const ring)
   return write_space_internal(ring, r, ring->write_head);
 }
 
+static inline uint32_t
+load_write_head(ZixRing* const ring,
+                const uint32_t r,
+                const uint32_t min_read_space)
+{
+  if (read_space_internal(ring, r, ring->write_head_cache) < min_read_space) {
+    ring->write_head_cache = zix_atomic_load(&ring->write_head);
+  }
+
+  return ring->write_head_cache;
+}
+
+static inline uint32_t
+load_read_head(ZixRing* const ring,
+               const uint32_t w,
+               const uint32_t min_write_space)
+{
+  if (write_space_internal(ring, ring->read_head_cache, w) < min_write_space) {
+    ring->read_head_cache = zix_atomic_load(&ring->read_head);
+  }
+
+  return ring->read_head_cache;
+}
+
 ZIX_REALTIME uint32_t
 zix_ring_capacity(const ZixRing* const ring)
 {
@@ -190,7 +275,7 @@ peek_internal(const ZixRing* const ring,
     return 0;
   }
 
-  if (r + size < ring->size) {
+  if (ring->mirrored || r + size < ring->size) {
     memcpy(dst, &ring->buf[r], size);
   } else {
     const uint32_t first_size = ring->size - r;
@@ -204,16 +289,17 @@ peek_internal(const ZixRing* const ring,
 ZIX_REALTIME uint32_t
 zix_ring_peek(ZixRing* const ring, void* const dst, const uint32_t size)
 {
-  const uint32_t w = zix_atomic_load(&ring->write_head);
+  const uint32_t r = ring->read_head;
+  const uint32_t w = load_write_head(ring, r, size);
 
-  return peek_internal(ring, ring->read_head, w, size, dst);
+  return peek_internal(ring, r, w, size, dst);
 }
 
 ZIX_REALTIME uint32_t
 zix_ring_read(ZixRing* const ring, void* const dst, const uint32_t size)
 {
-  const uint32_t w = zix_atomic_load(&ring->write_head);
   const uint32_t r = ring->read_head;
+  const uint32_t w = load_write_head(ring, r, size);
   if (!peek_internal(ring, r, w, size, dst)) {
     return 0;
   }
@@ -225,8 +311,8 @@ zix_ring_read(ZixRing* const ring, void* const dst, const uint32_t size)
 ZIX_REALTIME uint32_t
 zix_ring_skip(ZixRing* const ring, const uint32_t size)
 {
-  const uint32_t w = zix_atomic_load(&ring->write_head);
   const uint32_t r = ring->read_head;
+  const uint32_t w = load_write_head(ring, r, size);
   if (read_space_internal(ring, r, w) < size) {
     return 0;
   }
@@ -235,11 +321,133 @@ zix_ring_skip(ZixRing* const ring, const uint32_t size)
   return size;
 }
 
+static inline ZixRingVector
+make_vector(const ZixRing* const ring, const uint32_t head, const uint32_t size)
+{
+  const uint32_t first_size =
+    (ring->mirrored || head + size <= ring->size) ? size : ring->size - head;
+
+  const ZixRingVector vec = {{&ring->buf[head], first_size},
+                             {&ring->buf[0], size - first_size}};
+
+  return vec;
+}
+
+ZIX_REALTIME ZixRingVector
+zix_ring_read_vector(ZixRing* const ring)
+{
+  const uint32_t r = ring->read_head;
+  const uint32_t w = zix_atomic_load(&ring->write_head);
+
+  ring->write_head_cache = w;
+  return make_vector(ring, r, read_space_internal(ring, r, w));
+}
+
+static uint64_t
+sleep_reader(ZixRing* const ring, const uint64_t max_ns)
+{
+#if USE_FUTEX
+  const struct timespec timeout = {(time_t)(max_ns / NS_PER_SECOND),
+                                   (long)(max_ns % NS_PER_SECOND)};
+
+#  if USE_CLOCK_GETTIME
+  struct timespec start = {0, 0};
+  struct timespec end   = {0, 0};
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#  endif
+
+  // Block until the writer clears the flag and wakes us (or the timeout)
+  syscall(SYS_futex, &ring->sleeping, FUTEX_WAIT_PRIVATE, 1U, &timeout);
+
+#  if USE_CLOCK_GETTIME
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return ((uint64_t)(end.tv_sec - start.tv_sec) * NS_PER_SECOND) +
+         (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+#  else
+  return max_ns;
+#  endif
+
+#else
+  // Without a way to be woken, sleep in short slices and poll
+  const uint64_t slice_ns = max_ns < MAX_SLEEP_NS ? max_ns : MAX_SLEEP_NS;
+
+  (void)ring;
+
+#  if USE_NANOSLEEP
+  const struct timespec duration = {0, (long)slice_ns};
+  nanosleep(&duration, NULL);
+#  elif defined(_WIN32)
+  Sleep((DWORD)((slice_ns + 999999U) / 1000000U));
+#  endif
+
+  return slice_ns;
+#endif
+}
+
+ZixStatus
+zix_ring_wait_read(ZixRing* const ring,
+                   const uint32_t size,
+                   const uint32_t seconds,
+                   const uint32_t nanoseconds)
+{
+  // Spin briefly, since data may arrive very soon if the writer is active
+  for (unsigned i = 0U; i < MAX_WAIT_SPINS; ++i) {
+    if (zix_ring_read_space(ring) >= size) {
+      return ZIX_STATUS_SUCCESS;
+    }
+
+    zix_atomic_pause();
+  }
+
+  uint64_t remaining = ((uint64_t)seconds * NS_PER_SECOND) + nanoseconds;
+  for (;;) {
+    // Announce that we're sleeping before checking again, to not miss a write
+    zix_atomic_store(&ring->sleeping, 1U);
+    zix_atomic_fence();
+
+    if (zix_ring_read_space(ring) >= size) {
+      zix_atomic_store(&ring->sleeping, 0U);
+      return ZIX_STATUS_SUCCESS;
+    }
+
+    if (!remaining) {
+      zix_atomic_store(&ring->sleeping, 0U);
+      return ZIX_STATUS_TIMEOUT;
+    }
+
+    const uint64_t slept = sleep_reader(ring, remaining);
+    remaining            = slept < remaining ? remaining - slept : 0U;
+  }
+}
+
+ZIX_REALTIME ZixRingVector
+zix_ring_write_vector(ZixRing* const ring)
+{
+  const uint32_t w = ring->write_head;
+  const uint32_t r = zix_atomic_load(&ring->read_head);
+
+  ring->read_head_cache = r;
+  return make_vector(ring, w, write_space_internal(ring, r, w));
+}
+
+ZIX_REALTIME uint32_t
+zix_ring_advance_write(ZixRing* const ring, const uint32_t size)
+{
+  const uint32_t w = ring->write_head;
+  const uint32_t r = load_read_head(ring, w, size);
+  if (write_space_internal(ring, r, w) < size) {
+    return 0;
+  }
+
+  zix_atomic_store(&ring->write_head, (w + size) & ring->size_mask);
+  return size;
+}
+
 ZIX_REALTIME ZixRingTransaction
 zix_ring_begin_write(ZixRing* const ring)
 {
-  const uint32_t r = zix_atomic_load(&ring->read_head);
   const uint32_t w = ring->write_head;
+  const uint32_t r = ring->read_head_cache;
 
   const ZixRingTransaction tx = {r, w};
   return tx;
@@ -251,14 +459,17 @@ zix_ring_amend_write(ZixRing* const            ring,
                      const void* const         src,
                      const uint32_t            size)
 {
-  const uint32_t r = tx->read_head;
   const uint32_t w = tx->write_head;
-  if (write_space_internal(ring, r, w) < size) {
-    return ZIX_STATUS_NO_MEM;
+  if (write_space_internal(ring, tx->read_head, w) < size) {
+    // Not enough space according to the cache, so check the real read head
+    tx->read_head = load_read_head(ring, w, size);
+    if (write_space_internal(ring, tx->read_head, w) < size) {
+      return ZIX_STATUS_NO_MEM;
+    }
   }
 
   const uint32_t end = w + size;
-  if (end <= ring->size) {
+  if (ring->mirrored || end <= ring->size) {
     memcpy(&ring->buf[w], src, size);
     tx->write_head = end & ring->size_mask;
   } else {
@@ -279,6 +490,21 @@ zix_ring_commit_write(ZixRing* const ring, const ZixRingTransaction* const tx)
   return ZIX_STATUS_SUCCESS;
 }
 
+ZIX_NONBLOCKING void
+zix_ring_notify(ZixRing* const ring)
+{
+  // Pairs with the fence in zix_ring_wait_read() so one side sees the other
+  zix_atomic_fence();
+
+  if (zix_atomic_load(&ring->sleeping)) {
+    zix_atomic_store(&ring->sleeping, 0U);
+
+#if USE_FUTEX
+    syscall(SYS_futex, &ring->sleeping, FUTEX_WAKE_PRIVATE, 1);
+#endif
+  }
+}
+
 ZIX_REALTIME uint32_t
 zix_ring_write(ZixRing* const ring, const void* src, const uint32_t size)
 {
@@ -6,6 +6,7 @@
 
 #include <zix/allocator.h>
 #include <zix/attributes.h>
+#include <zix/filesystem.h>
 #include <zix/status.h>
 
 #include <stddef.h>
@@ -43,6 +44,90 @@ zix_system_close_fds(int fd1, int fd2);
 ssize_t
 zix_system_read(int fd, void* ZIX_NONNULL buf, size_t count);
 
+ssize_t
+zix_system_write(int fd, const void* ZIX_NONNULL buf, size_t count);
+
+/**
+   Visit every file in a directory like zix_dir_for_each().
+
+   @return An error if the directory couldn't be opened or read.
+*/
+ZixStatus
+zix_system_dir_for_each(const char* ZIX_NONNULL          path,
+                        void* ZIX_NULLABLE               data,
+                        ZixDirEntryVisitFunc ZIX_NONNULL f);
+
+/**
+   Create a symbolic link with the same target as an existing one.
+
+   The target is copied verbatim, so relative links stay relative.
+
+   @return #ZIX_STATUS_NOT_SUPPORTED if links can't be read on this system.
+*/
+ZixStatus
+zix_system_copy_link(ZixAllocator* ZIX_NULLABLE allocator,
+                     const char* ZIX_NONNULL    src,
+                     const char* ZIX_NONNULL    dst);
+
+/**
+   Map a buffer of `size` bytes twice, consecutively in virtual memory.
+
+   The returned address range is `2 * size` bytes long, and the second half
+   refers to the same physical memory as the first.  The size must be a
+   multiple of the page size.
+
+   @return The mapped buffer, or null if this isn't supported.
+*/
+void* ZIX_ALLOCATED
+zix_system_map_mirrored(size_t size);
+
+/// Unmap a buffer returned by zix_system_map_mirrored()
+void
+zix_system_unmap_mirrored(void* ZIX_NULLABLE buf, size_t size);
+
+/**
+   Map anonymous memory for private use.
+
+   The alignment must be a power of two multiple of the page size, and the
+   size must be a multiple of the alignment.  The options are a set of
+   #ZixPageOption flags which are only hints, and the memory is simply mapped
+   normally if they aren't supported.
+
+   @return The mapped memory, or null if this isn't supported or failed.
+*/
+void* ZIX_ALLOCATED
+zix_system_map_pages(size_t   size,
+                     size_t   alignment,
+                     uint32_t options,
+                     int      numa_node);
+
+/// Unmap memory returned by zix_system_map_pages()
+void
+zix_system_unmap_pages(void* ZIX_NULLABLE buf, size_t size);
+
+/**
+   Map the contents of an open file for reading sequentially.
+
+   @param fd Open file descriptor, which may be closed after mapping.
+   @param size Size of the file, which must be at least one byte.
+   @return The mapped contents, or null if this isn't supported or failed.
+*/
+void* ZIX_ALLOCATED
+zix_system_map_file(int fd, size_t size);
+
+/// Unmap contents returned by zix_system_map_file()
+void
+zix_system_unmap_file(void* ZIX_NULLABLE buf, size_t size);
+
+/**
+   Fill a buffer with random bytes from the system.
+
+   The random source is suitable for generating secret keys.  The size must be
+   at most 256 bytes.
+*/
+ZixStatus
+zix_system_random(void* ZIX_NONNULL buf, size_t size);
+
 ZIX_PURE_FUNC uint32_t
 zix_system_max_block_size(const struct stat* ZIX_NONNULL s1,
                           const struct stat* ZIX_NONNULL s2,
@@ -0,0 +1,356 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "uring.h"
+
+#include "zix_config.h"
+
+#include <zix/filesystem.h>
+#include <zix/status.h>
+
+#if USE_IO_URING
+#  include "atomic.h"
+#  include "errno_status.h"
+
+#  include <fcntl.h>
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+
+#  include <errno.h>
+#  include <stdbool.h>
+#  include <stdint.h>
+#  include <string.h>
+#endif
+
+#include <stddef.h>
+
+#if USE_IO_URING
+
+/*
+  The io_uring interface is used directly via system calls, to avoid a
+  dependency on liburing.  A ring is set up for every batch, and used to run
+  each stage (open, read or write, and close) for many files at once, so the
+  number of system calls doesn't depend on the number of files.
+*/
+
+#  define URING_DEPTH 64U          ///< Maximum number of queued operations
+#  define URING_MAX_IO 0x40000000U ///< Maximum size of a single read or write
+
+typedef struct {
+  int                  fd;        ///< Ring file descriptor
+  void*                sq_ring;   ///< Mapped submission queue ring
+  size_t               sq_size;   ///< Size of submission queue ring
+  void*                cq_ring;   ///< Mapped completion queue ring
+  size_t               cq_size;   ///< Size of completion queue ring
+  struct io_uring_sqe* sqes;      ///< Mapped submission queue entries
+  size_t               sqes_size; ///< Size of submission queue entries
+  uint32_t*            sq_tail;   ///< Submission queue tail
+  const uint32_t*      sq_mask;   ///< Submission queue index mask
+  uint32_t*            sq_array;  ///< Submission queue entry indices
+  uint32_t*            cq_head;   ///< Completion queue head
+  const uint32_t*      cq_tail;   ///< Completion queue tail
+  const uint32_t*      cq_mask;   ///< Completion queue index mask
+  struct io_uring_cqe* cqes;      ///< Completion queue entries
+  uint32_t             n_queued;  ///< Number of queued operations
+} Uring;
+
+static void*
+map_ring(const int fd, const size_t size, const off_t offset)
+{
+  const int   prot  = PROT_READ | PROT_WRITE;    // NOLINT(hicpp-signed-bitwise)
+  const int   flags = MAP_SHARED | MAP_POPULATE; // NOLINT(hicpp-signed-bitwise)
+  void* const ptr   = mmap(NULL, size, prot, flags, fd, offset);
+
+  return (ptr == MAP_FAILED) ? NULL : ptr;
+}
+
+static void
+uring_destroy(Uring* const ring)
+{
+  if (ring->sqes) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+
+  if (ring->cq_ring) {
+    munmap(ring->cq_ring, ring->cq_size);
+  }
+
+  if (ring->sq_ring) {
+    munmap(ring->sq_ring, ring->sq_size);
+  }
+
+  close(ring->fd);
+}
+
+static ZixStatus
+uring_init(Uring* const ring)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  memset(ring, 0, sizeof(Uring));
+
+  // Set up a ring, which may fail if it's not supported or not permitted
+  ring->fd = (int)syscall(__NR_io_uring_setup, URING_DEPTH, &params);
+  if (ring->fd < 0) {
+    return ZIX_STATUS_NOT_SUPPORTED;
+  }
+
+  // Require Linux 5.6 for all the needed operations (indicated by this feature)
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    close(ring->fd);
+    return ZIX_STATUS_NOT_SUPPORTED;
+  }
+
+  const size_t n_sqes = params.sq_entries;
+  const size_t n_cqes = params.cq_entries;
+
+  ring->sq_size   = params.sq_off.array + (n_sqes * sizeof(uint32_t));
+  ring->cq_size   = params.cq_off.cqes + (n_cqes * sizeof(struct io_uring_cqe));
+  ring->sqes_size = n_sqes * sizeof(struct io_uring_sqe);
+
+  ring->sq_ring = map_ring(ring->fd, ring->sq_size, IORING_OFF_SQ_RING);
+  ring->cq_ring = map_ring(ring->fd, ring->cq_size, IORING_OFF_CQ_RING);
+  ring->sqes    = (struct io_uring_sqe*)map_ring(
+    ring->fd, ring->sqes_size, (off_t)IORING_OFF_SQES);
+  if (!ring->sq_ring || !ring->cq_ring || !ring->sqes) {
+    uring_destroy(ring);
+    return ZIX_STATUS_NOT_SUPPORTED;
+  }
+
+  char* const sq = (char*)ring->sq_ring;
+  char* const cq = (char*)ring->cq_ring;
+
+  ring->sq_tail  = (uint32_t*)(sq + params.sq_off.tail);
+  ring->sq_mask  = (const uint32_t*)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (uint32_t*)(sq + params.sq_off.array);
+  ring->cq_head  = (uint32_t*)(cq + params.cq_off.head);
+  ring->cq_tail  = (const uint32_t*)(cq + params.cq_off.tail);
+  ring->cq_mask  = (const uint32_t*)(cq + params.cq_off.ring_mask);
+  ring->cqes     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  return ZIX_STATUS_SUCCESS;
+}
+
+/// Queue an operation, which is submitted by the next uring_run()
+static struct io_uring_sqe*
+uring_push(Uring* const   ring,
+           const uint8_t  opcode,
+           const int      fd,
+           const uint32_t user_data)
+{
+  const uint32_t index = (*ring->sq_tail + ring->n_queued) & *ring->sq_mask;
+
+  struct io_uring_sqe* const sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqe->opcode    = opcode;
+  sqe->fd        = fd;
+  sqe->user_data = user_data;
+
+  ring->sq_array[index] = index;
+  ++ring->n_queued;
+  return sqe;
+}
+
+/// Submit all queued operations and store their results by user data
+static ZixStatus
+uring_run(Uring* const ring, int32_t* const results)
+{
+  const uint32_t n_ops = ring->n_queued;
+
+  zix_atomic_store(ring->sq_tail, *ring->sq_tail + n_ops);
+  ring->n_queued = 0U;
+
+  uint32_t n_submitted = 0U;
+  uint32_t n_completed = 0U;
+  while (n_completed < n_ops) {
+    const long r = syscall(__NR_io_uring_enter,
+                           ring->fd,
+                           n_ops - n_submitted,
+                           n_ops - n_completed,
+                           IORING_ENTER_GETEVENTS,
+                           NULL,
+                           0U);
+
+    if (r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      return zix_errno_status(errno);
+    }
+
+    n_submitted += (r > 0) ? (uint32_t)r : 0U;
+
+    uint32_t       head = *ring->cq_head;
+    const uint32_t tail = zix_atomic_load(ring->cq_tail);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe* const cqe = &ring->cqes[head & *ring->cq_mask];
+
+      results[cqe->user_data] = cqe->res;
+      ++n_completed;
+    }
+
+    zix_atomic_store(ring->cq_head, head);
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+/// Finish a short transfer with synchronous system calls, reading until EOF
+static void
+finish_transfer(ZixFileTransfer* const transfer, const int fd)
+{
+  const bool write = transfer->type == ZIX_FILE_TRANSFER_WRITE;
+
+  ssize_t r = 1;
+  while (transfer->n_bytes < transfer->size && r > 0) {
+    char* const  buf    = (char*)transfer->buffer + transfer->n_bytes;
+    const size_t count  = transfer->size - transfer->n_bytes;
+    const off_t  offset = (off_t)transfer->n_bytes;
+
+    r = write ? pwrite(fd, buf, count, offset) : pread(fd, buf, count, offset);
+    if (r > 0) {
+      transfer->n_bytes += (size_t)r;
+    }
+  }
+
+  if (r < 0) {
+    transfer->status = zix_errno_status(errno);
+  } else if (write && transfer->n_bytes < transfer->size) {
+    transfer->status = ZIX_STATUS_ERROR;
+  }
+}
+
+static ZixStatus
+transfer_chunk(Uring* const           ring,
+               ZixFileTransfer* const transfers,
+               const uint32_t         n_transfers)
+{
+  int     fds[URING_DEPTH];
+  int32_t results[URING_DEPTH];
+
+  // Open all files
+  for (uint32_t i = 0U; i < n_transfers; ++i) {
+    results[i] = -1; // Not opened unless the operation completes
+    const bool write = transfers[i].type == ZIX_FILE_TRANSFER_WRITE;
+    const int  flags = write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY;
+
+    struct io_uring_sqe* const sqe =
+      uring_push(ring, IORING_OP_OPENAT, AT_FDCWD, i);
+
+    sqe->addr       = (uint64_t)(uintptr_t)transfers[i].path;
+    sqe->len        = write ? 0644U : 0U;
+    sqe->open_flags = (uint32_t)(flags | O_CLOEXEC);
+  }
+
+  ZixStatus st = uring_run(ring, results);
+  if (st) {
+    // Close any files that were opened before the failure
+    for (uint32_t i = 0U; i < n_transfers; ++i) {
+      if (results[i] >= 0) {
+        close(results[i]);
+      }
+    }
+
+    return st;
+  }
+
+  // Read or write all opened files
+  for (uint32_t i = 0U; i < n_transfers; ++i) {
+    ZixFileTransfer* const transfer = &transfers[i];
+
+    fds[i]            = results[i];
+    results[i]        = 0;
+    transfer->n_bytes = 0U;
+    transfer->status =
+      (fds[i] < 0) ? zix_errno_status(-fds[i]) : ZIX_STATUS_SUCCESS;
+
+    if (fds[i] >= 0 && transfer->size) {
+      const bool write = transfer->type == ZIX_FILE_TRANSFER_WRITE;
+
+      struct io_uring_sqe* const sqe = uring_push(
+        ring, write ? IORING_OP_WRITE : IORING_OP_READ, fds[i], i);
+
+      sqe->addr = (uint64_t)(uintptr_t)transfer->buffer;
+      sqe->len  = (uint32_t)((transfer->size < URING_MAX_IO) ? transfer->size
+                                                            : URING_MAX_IO);
+    }
+  }
+
+  if ((st = uring_run(ring, results))) {
+    for (uint32_t i = 0U; i < n_transfers; ++i) {
+      if (fds[i] >= 0) {
+        close(fds[i]);
+      }
+    }
+
+    return st;
+  }
+
+  // Check results, and finish any short transfers that may not be complete
+  for (uint32_t i = 0U; i < n_transfers; ++i) {
+    ZixFileTransfer* const transfer = &transfers[i];
+
+    if (fds[i] >= 0) {
+      if (results[i] < 0) {
+        transfer->status = zix_errno_status(-results[i]);
+      } else if ((transfer->n_bytes = (size_t)results[i]) < transfer->size) {
+        finish_transfer(transfer, fds[i]);
+      }
+
+      results[i] = 0;
+      uring_push(ring, IORING_OP_CLOSE, fds[i], i);
+    }
+  }
+
+  // Close all opened files
+  if ((st = uring_run(ring, results))) {
+    return st;
+  }
+
+  for (uint32_t i = 0U; i < n_transfers; ++i) {
+    if (results[i] < 0 && !transfers[i].status) {
+      transfers[i].status = zix_errno_status(-results[i]);
+    }
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+ZixStatus
+zix_uring_transfer_files(const size_t n_transfers,
+                         ZixFileTransfer* const transfers)
+{
+  Uring     ring;
+  ZixStatus st = uring_init(&ring);
+  if (st) {
+    return st;
+  }
+
+  for (size_t offset = 0U; offset < n_transfers; offset += URING_DEPTH) {
+    const size_t n_left = n_transfers - offset;
+    const uint32_t n = (n_left < URING_DEPTH) ? (uint32_t)n_left : URING_DEPTH;
+
+    if ((st = transfer_chunk(&ring, transfers + offset, n))) {
+      // The ring failed unexpectedly, so fail every unfinished transfer
+      for (size_t i = offset; i < n_transfers; ++i) {
+        transfers[i].status = st;
+      }
+      break;
+    }
+  }
+
+  uring_destroy(&ring);
+  return ZIX_STATUS_SUCCESS;
+}
+
+#else
+
+ZixStatus
+zix_uring_transfer_files(const size_t n_transfers,
+                         ZixFileTransfer* const transfers)
+{
+  (void)n_transfers;
+  (void)transfers;
+  return ZIX_STATUS_NOT_SUPPORTED;
+}
+
+#endif
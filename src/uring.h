@@ -0,0 +1,24 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef ZIX_URING_H
+#define ZIX_URING_H
+
+#include <zix/attributes.h>
+#include <zix/filesystem.h>
+#include <zix/status.h>
+
+#include <stddef.h>
+
+/**
+   Make file transfers with batches of io_uring operations.
+
+   @return #ZIX_STATUS_NOT_SUPPORTED if io_uring isn't available, in which case
+   no transfers were attempted, otherwise #ZIX_STATUS_SUCCESS and the status
+   of each transfer is set.
+*/
+ZixStatus
+zix_uring_transfer_files(size_t                       n_transfers,
+                         ZixFileTransfer* ZIX_NONNULL transfers);
+
+#endif // ZIX_URING_H
@@ -5,6 +5,7 @@
 
 #include "../errno_status.h"
 #include "../qualifiers.h"
+#include "../system.h"
 #include "../zix_config.h"
 #include "win32_util.h"
 
@@ -106,6 +107,43 @@ zix_copy_file(ZixAllocator* const  allocator,
   return zix_windows_status(ret);
 }
 
+ZixStatus
+zix_sync_files(const size_t             n_paths,
+               const char* const* const paths,
+               const ZixCopyOptions     options)
+{
+  (void)options; // FlushFileBuffers() always flushes everything
+
+  ZixStatus st = ZIX_STATUS_SUCCESS;
+
+  for (size_t i = 0U; i < n_paths; ++i) {
+    ArgPathChar* const wpath = arg_path_new(NULL, paths[i]);
+
+    const HANDLE handle =
+      CreateFile(wpath,
+                 GENERIC_WRITE,
+                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                 NULL,
+                 OPEN_EXISTING,
+                 FILE_FLAG_BACKUP_SEMANTICS,
+                 NULL);
+
+    arg_path_free(NULL, wpath);
+
+    const bool synced =
+      handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle);
+
+    const ZixStatus file_st = zix_windows_status(synced);
+    if (handle != INVALID_HANDLE_VALUE) {
+      CloseHandle(handle);
+    }
+
+    st = st ? st : file_st;
+  }
+
+  return st;
+}
+
 /// Linear Congruential Generator for making random 32-bit integers
 static inline uint32_t
 lcg32(const uint32_t i)
@@ -169,10 +207,10 @@ zix_remove(const char* const path)
   return zix_windows_status(success);
 }
 
-void
-zix_dir_for_each(const char* const          path,
-                 void* const                data,
-                 const ZixDirEntryVisitFunc f)
+ZixStatus
+zix_system_dir_for_each(const char* const          path,
+                        void* const                data,
+                        const ZixDirEntryVisitFunc f)
 {
   ZIX_CONSTEXPR TCHAR* const dot    = TEXT(".");
   ZIX_CONSTEXPR TCHAR* const dotdot = TEXT("..");
@@ -180,19 +218,23 @@ zix_dir_for_each(const char* const          path,
 #ifdef UNICODE
   const int path_size = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
   if (path_size < 1) {
-    return;
+    return ZIX_STATUS_BAD_ARG;
   }
 
   const size_t path_len = (size_t)path_size - 1U;
   TCHAR* const pat = (TCHAR*)zix_calloc(NULL, path_len + 4U, sizeof(TCHAR));
   if (!pat) {
-    return;
+    return ZIX_STATUS_NO_MEM;
   }
 
   MultiByteToWideChar(CP_UTF8, 0, path, -1, pat, path_size);
 #else
   const size_t path_len = strlen(path);
-  TCHAR* const pat = (TCHAR*)zix_calloc(NULL, path_len + 2U, sizeof(TCHAR));
+  TCHAR* const pat = (TCHAR*)zix_calloc(NULL, path_len + 3U, sizeof(TCHAR));
+  if (!pat) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
   memcpy(pat, path, path_len + 1U);
 #endif
 
@@ -201,21 +243,38 @@ zix_dir_for_each(const char* const          path,
   pat[path_len + 2U] = '\0';
 
   WIN32_FIND_DATA fd;
-  HANDLE          fh = FindFirstFile(pat, &fd);
-  if (fh != INVALID_HANDLE_VALUE) {
-    do {
-      if (!!_tcscmp(fd.cFileName, dot) && !!_tcscmp(fd.cFileName, dotdot)) {
+  const HANDLE    fh = FindFirstFile(pat, &fd);
+  ZixStatus       st = zix_windows_status(fh != INVALID_HANDLE_VALUE);
+  zix_free(NULL, pat);
+  if (st) {
+    return st;
+  }
+
+  do {
+    if (!!_tcscmp(fd.cFileName, dot) && !!_tcscmp(fd.cFileName, dotdot)) {
 #ifdef UNICODE
-        char* const name = zix_wchar_to_utf8(NULL, fd.cFileName);
-        f(path, name, data);
-        zix_free(NULL, name);
+      char* const name = zix_wchar_to_utf8(NULL, fd.cFileName);
+      f(path, name, data);
+      zix_free(NULL, name);
 #else
-        f(path, fd.cFileName, data);
+      f(path, fd.cFileName, data);
 #endif
-      }
-    } while (FindNextFile(fh, &fd));
-  }
+    }
+  } while (FindNextFile(fh, &fd));
+
+  // The search ends with a "no more files" error, anything else is a failure
+  const DWORD e = GetLastError();
   FindClose(fh);
+  return (e == ERROR_NO_MORE_FILES) ? ZIX_STATUS_SUCCESS
+                                    : zix_winerror_status(e);
+}
+
+void
+zix_dir_for_each(const char* const          path,
+                 void* const                data,
+                 const ZixDirEntryVisitFunc f)
+{
+  (void)zix_system_dir_for_each(path, data, f);
 }
 
 ZixStatus
@@ -256,6 +315,79 @@ zix_file_unlock(FILE* const file, const ZixFileLockMode mode)
 #endif
 }
 
+ZixStatus
+zix_file_map(ZixAllocator* const   allocator,
+             const char* const     path,
+             const ZixFileMapMode  mode,
+             const ZixFileMapHints hints,
+             ZixFileView* const    view)
+{
+  const bool  write  = mode == ZIX_FILE_MAP_READ_WRITE;
+  const DWORD access = write ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+  const DWORD flags  = (hints & ZIX_FILE_MAP_HINT_SEQUENTIAL)
+                         ? FILE_FLAG_SEQUENTIAL_SCAN
+                       : (hints & ZIX_FILE_MAP_HINT_RANDOM)
+                         ? FILE_FLAG_RANDOM_ACCESS
+                         : FILE_ATTRIBUTE_NORMAL;
+
+  view->data = NULL;
+  view->size = 0U;
+
+  ArgPathChar* const wpath = arg_path_new(allocator, path);
+  const HANDLE       file  = CreateFile(wpath,
+                                 access,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                 NULL,
+                                 OPEN_EXISTING,
+                                 flags,
+                                 NULL);
+
+  arg_path_free(allocator, wpath);
+  if (file == INVALID_HANDLE_VALUE) {
+    return zix_windows_status(false);
+  }
+
+  LARGE_INTEGER size;
+  ZixStatus     st = zix_windows_status(GetFileSizeEx(file, &size));
+  if (!st && (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX) {
+    st = ZIX_STATUS_OVERFLOW;
+  }
+
+  // Map the file, which stays mapped after both handles are closed
+  if (!st && size.QuadPart) {
+    const HANDLE mapping = CreateFileMapping(
+      file, NULL, write ? PAGE_READWRITE : PAGE_READONLY, 0U, 0U, NULL);
+
+    void* const data =
+      mapping ? MapViewOfFile(
+                  mapping, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0U, 0U, 0U)
+              : NULL;
+
+    st = zix_windows_status(!!data);
+    if (data) {
+      view->data = data;
+      view->size = (size_t)size.QuadPart;
+    }
+
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+  }
+
+  CloseHandle(file);
+  return st;
+}
+
+ZixStatus
+zix_file_unmap(ZixFileView* const view)
+{
+  const bool success = !view->data || UnmapViewOfFile(view->data);
+
+  view->data = NULL;
+  view->size = 0U;
+  return zix_windows_status(success);
+}
+
 #if USE_GETFINALPATHNAMEBYHANDLE && USE_CREATEFILE2
 
 static HANDLE
@@ -396,6 +528,216 @@ zix_symlink_type(const char* const path)
   return type;
 }
 
+static int64_t
+filetime_nanoseconds(const FILETIME time)
+{
+  // Convert from 100 ns intervals since 1601 to nanoseconds since 1970
+  const uint64_t ticks =
+    ((uint64_t)time.dwHighDateTime << 32U) | (uint64_t)time.dwLowDateTime;
+
+  return ((int64_t)ticks - 116444736000000000LL) * 100;
+}
+
+ZixStatus
+zix_file_status(const char* const path, ZixFileStatus* const status)
+{
+  const ZixFileStatus none = {ZIX_FILE_TYPE_NONE, 0, 0, 0U, 0U};
+
+  *status = none;
+
+  ArgPathChar* const wpath = arg_path_new(NULL, path);
+  if (!wpath) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  const HANDLE file =
+    CreateFile(wpath,
+               FILE_READ_ATTRIBUTES,
+               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+               NULL,
+               OPEN_EXISTING,
+               FILE_FLAG_BACKUP_SEMANTICS,
+               NULL);
+
+  arg_path_free(NULL, wpath);
+  if (file == INVALID_HANDLE_VALUE) {
+    return zix_windows_status(false);
+  }
+
+  BY_HANDLE_FILE_INFORMATION info;
+  const ZixStatus            st =
+    zix_windows_status(GetFileInformationByHandle(file, &info));
+
+  if (!st) {
+    const uint64_t size =
+      ((uint64_t)info.nFileSizeHigh << 32U) | (uint64_t)info.nFileSizeLow;
+
+    status->type     = attrs_file_type(info.dwFileAttributes);
+    status->size     = (ZixFileOffset)size;
+    status->modified = filetime_nanoseconds(info.ftLastWriteTime);
+    status->inode =
+      ((uint64_t)info.nFileIndexHigh << 32U) | (uint64_t)info.nFileIndexLow;
+    status->device = (uint64_t)info.dwVolumeSerialNumber;
+  }
+
+  CloseHandle(file);
+  return st;
+}
+
+static ZixStatus
+walk_dir(ZixAllocator*     allocator,
+         const char*       dir_path,
+         ZixDirWalkOptions options,
+         unsigned          depth,
+         ZixDirWalkFunc    f,
+         void*             data);
+
+static ZixStatus
+walk_entry(ZixAllocator* const          allocator,
+           const char* const            path,
+           const char* const            name,
+           const WIN32_FIND_DATA* const fd,
+           const ZixDirWalkOptions      options,
+           const unsigned               depth,
+           const ZixDirWalkFunc         f,
+           void* const                  data)
+{
+  const uint64_t size =
+    ((uint64_t)fd->nFileSizeHigh << 32U) | (uint64_t)fd->nFileSizeLow;
+
+  const ZixFileStatus status = {attrs_file_type(fd->dwFileAttributes),
+                                (ZixFileOffset)size,
+                                filetime_nanoseconds(fd->ftLastWriteTime),
+                                0U,
+                                0U};
+
+  const ZixDirWalkEntry entry = {
+    path,
+    path + strlen(path) - strlen(name),
+    (options & ZIX_DIR_WALK_STATUS) ? &status : NULL,
+    status.type,
+    depth};
+
+  if (entry.type != ZIX_FILE_TYPE_DIRECTORY) {
+    return f(data, &entry);
+  }
+
+  const bool post_order = options & ZIX_DIR_WALK_POST_ORDER;
+  ZixStatus  st         = post_order ? ZIX_STATUS_SUCCESS : f(data, &entry);
+
+  // Walk into the directory, unless it's a link (reparse point)
+  if (!st && !(fd->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+    st = walk_dir(allocator, path, options, depth + 1U, f, data);
+  }
+
+  return (!st && post_order) ? f(data, &entry) : st;
+}
+
+static ZixStatus
+walk_dir(ZixAllocator* const     allocator,
+         const char* const       dir_path,
+         const ZixDirWalkOptions options,
+         const unsigned          depth,
+         const ZixDirWalkFunc    f,
+         void* const             data)
+{
+  ZIX_CONSTEXPR TCHAR* const dot    = TEXT(".");
+  ZIX_CONSTEXPR TCHAR* const dotdot = TEXT("..");
+
+  char* const        pattern  = zix_path_join(allocator, dir_path, "*");
+  ArgPathChar* const wpattern =
+    pattern ? arg_path_new(allocator, pattern) : NULL;
+  if (!wpattern) {
+    zix_free(allocator, pattern);
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  WIN32_FIND_DATA fd;
+  const HANDLE    fh = FindFirstFile(wpattern, &fd);
+  ZixStatus       st = zix_windows_status(fh != INVALID_HANDLE_VALUE);
+  arg_path_free(allocator, wpattern);
+  zix_free(allocator, pattern);
+  if (st) {
+    return st;
+  }
+
+  do {
+    if (!!_tcscmp(fd.cFileName, dot) && !!_tcscmp(fd.cFileName, dotdot)) {
+#ifdef UNICODE
+      char* const name = zix_wchar_to_utf8(allocator, fd.cFileName);
+#else
+      const char* const name = fd.cFileName;
+#endif
+      char* const path = name ? zix_path_join(allocator, dir_path, name) : NULL;
+
+      st = path ? walk_entry(
+                    allocator, path, name, &fd, options, depth, f, data)
+                : ZIX_STATUS_NO_MEM;
+
+      zix_free(allocator, path);
+#ifdef UNICODE
+      zix_free(allocator, name);
+#endif
+    }
+  } while (!st && FindNextFile(fh, &fd));
+
+  FindClose(fh);
+  return st;
+}
+
+ZixStatus
+zix_dir_walk(ZixAllocator* const     allocator,
+             const char* const       path,
+             const ZixDirWalkOptions options,
+             const unsigned          n_threads,
+             const ZixDirWalkFunc    f,
+             void* const             data)
+{
+  (void)n_threads;
+
+  return walk_dir(allocator, path, options, 1U, f, data);
+}
+
+static ZixStatus
+remove_walk_entry(void* const data, const ZixDirWalkEntry* const entry)
+{
+  (void)data;
+  return zix_remove(entry->path);
+}
+
+ZixStatus
+zix_remove_all(ZixAllocator* const allocator,
+               const char* const   path,
+               const unsigned      n_threads)
+{
+  ArgPathChar* const wpath = arg_path_new(allocator, path);
+  if (!wpath) {
+    return ZIX_STATUS_NO_MEM;
+  }
+
+  const DWORD     attrs = GetFileAttributes(wpath);
+  const ZixStatus st    = zix_windows_status(attrs != INVALID_FILE_ATTRIBUTES);
+  arg_path_free(allocator, wpath);
+  if (st) {
+    return st;
+  }
+
+  // Remove links (reparse points) to directories without following them
+  if (!(attrs & FILE_ATTRIBUTE_DIRECTORY) ||
+      (attrs & FILE_ATTRIBUTE_REPARSE_POINT)) {
+    return zix_remove(path);
+  }
+
+  const ZixStatus walk_st = zix_dir_walk(allocator,
+                                         path,
+                                         ZIX_DIR_WALK_POST_ORDER,
+                                         n_threads,
+                                         remove_walk_entry,
+                                         NULL);
+
+  return walk_st ? walk_st : zix_remove(path);
+}
+
 ZixStatus
 zix_create_directory(const char* const dir_path)
 {
@@ -1,9 +1,13 @@
 // Copyright 2007-2025 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
+#define _CRT_RAND_S // For rand_s()
+
 #include "../system.h"
 #include "../zix_config.h"
 
+#include <zix/status.h>
+
 #include <fcntl.h>
 #include <io.h>
 #include <share.h>
@@ -11,6 +15,8 @@
 
 #include <limits.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 uint32_t
 zix_system_page_size(void)
@@ -23,6 +29,94 @@ zix_system_page_size(void)
            : 512U;
 }
 
+void*
+zix_system_map_mirrored(const size_t size)
+{
+  /* This could be implemented with VirtualAlloc2() and MapViewOfFile3() on
+     Windows 10 and later, but for now, callers fall back to a normal buffer. */
+
+  (void)size;
+  return NULL;
+}
+
+void
+zix_system_unmap_mirrored(void* const buf, const size_t size)
+{
+  (void)buf;
+  (void)size;
+}
+
+void*
+zix_system_map_pages(const size_t   size,
+                     const size_t   alignment,
+                     const uint32_t options,
+                     const int      numa_node)
+{
+  /* Aligned regions could be mapped with VirtualAlloc2(), and large pages are
+     available with MEM_LARGE_PAGES if the user has the privilege to lock
+     memory, but for now, callers fall back to their parent allocator. */
+
+  (void)size;
+  (void)alignment;
+  (void)options;
+  (void)numa_node;
+  return NULL;
+}
+
+void
+zix_system_unmap_pages(void* const buf, const size_t size)
+{
+  (void)buf;
+  (void)size;
+}
+
+void*
+zix_system_map_file(const int fd, const size_t size)
+{
+  const HANDLE file    = (HANDLE)_get_osfhandle(fd);
+  const HANDLE mapping = (file == INVALID_HANDLE_VALUE)
+                           ? NULL
+                           : CreateFileMapping(
+                               file, NULL, PAGE_READONLY, 0U, 0U, NULL);
+
+  // The view stays mapped after the mapping handle is closed
+  void* const data =
+    mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0U, 0U, size) : NULL;
+
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+
+  return data;
+}
+
+void
+zix_system_unmap_file(void* const buf, const size_t size)
+{
+  (void)size;
+
+  if (buf) {
+    UnmapViewOfFile(buf);
+  }
+}
+
+ZixStatus
+zix_system_random(void* const buf, const size_t size)
+{
+  // Fill the buffer a word at a time from rand_s(), which uses RtlGenRandom()
+  for (size_t offset = 0U; offset < size; offset += sizeof(unsigned)) {
+    unsigned r = 0U;
+    if (rand_s(&r)) {
+      return ZIX_STATUS_ERROR;
+    }
+
+    const size_t n = (size - offset < sizeof(r)) ? size - offset : sizeof(r);
+    memcpy((char*)buf + offset, &r, n);
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
 uint32_t
 zix_system_max_block_size(const struct stat* const s1,
                           const struct stat* const s2,
@@ -65,3 +159,20 @@ zix_system_read(const int fd, void* const buf, const size_t count)
 {
   return _read(fd, buf, (unsigned)count);
 }
+
+ssize_t
+zix_system_write(const int fd, const void* const buf, const size_t count)
+{
+  return _write(fd, buf, (unsigned)count);
+}
+
+ZixStatus
+zix_system_copy_link(ZixAllocator* const allocator,
+                     const char* const   src,
+                     const char* const   dst)
+{
+  (void)allocator;
+  (void)src;
+  (void)dst;
+  return ZIX_STATUS_NOT_SUPPORTED;
+}
@@ -107,6 +107,15 @@
 #    endif
 #  endif
 
+// Linux 4.5: FICLONE ioctl()
+#  ifndef HAVE_FICLONE
+#    if defined(__linux__) && defined(__has_include)
+#      if __has_include(<linux/fs.h>)
+#        define HAVE_FICLONE 1
+#      endif
+#    endif
+#  endif
+
 // POSIX.1-2001, Windows: fileno()
 #  ifndef HAVE_FILENO
 #    if defined(_WIN32) || defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112L
@@ -121,6 +130,22 @@
 #    endif
 #  endif
 
+// Linux 2.6: futex()
+#  ifndef HAVE_FUTEX
+#    if defined(__linux__)
+#      define HAVE_FUTEX 1
+#    endif
+#  endif
+
+// FreeBSD 12, MacOS 10.12, and glibc 2.25: getentropy()
+#  ifndef HAVE_GETENTROPY
+#    if (defined(__FreeBSD__) && __FreeBSD__ >= 12) || defined(__APPLE__) || \
+      (defined(__GLIBC__) &&                                                \
+       (__GLIBC__ > 2 || __GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#      define HAVE_GETENTROPY 1
+#    endif
+#  endif
+
 // Windows Vista (Desktop, UWP): GetFinalPathNameByHandle()
 #  ifndef HAVE_GETFINALPATHNAMEBYHANDLE
 #    if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0600
@@ -128,6 +153,47 @@
 #    endif
 #  endif
 
+// Linux 2.6.27: inotify_init1()
+#  ifndef HAVE_INOTIFY
+#    if defined(__linux__) && defined(__has_include)
+#      if __has_include(<sys/inotify.h>)
+#        define HAVE_INOTIFY 1
+#      endif
+#    endif
+#  endif
+
+// Linux 5.6: io_uring with file operations
+#  ifndef HAVE_IO_URING
+#    if defined(__linux__) && defined(__has_include)
+#      if __has_include(<linux/io_uring.h>)
+#        define HAVE_IO_URING 1
+#      endif
+#    endif
+#  endif
+
+// BSD, Linux, MacOS: madvise()
+#  ifndef HAVE_MADVISE
+#    if defined(__APPLE__) || defined(__FreeBSD__) || defined(__linux__)
+#      define HAVE_MADVISE 1
+#    endif
+#  endif
+
+// Linux 2.6.7: mbind() system call
+#  ifndef HAVE_MBIND
+#    if defined(__linux__)
+#      define HAVE_MBIND 1
+#    endif
+#  endif
+
+// FreeBSD 13, Linux 3.17 with glibc 2.27: memfd_create()
+#  ifndef HAVE_MEMFD_CREATE
+#    if (defined(__FreeBSD__) && __FreeBSD__ >= 13) || \
+      (defined(__linux__) && defined(__GLIBC__) &&     \
+       (__GLIBC__ > 2 || __GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#      define HAVE_MEMFD_CREATE 1
+#    endif
+#  endif
+
 // POSIX.1-2001: mlock()
 #  ifndef HAVE_MLOCK
 #    if ZIX_POSIX_VERSION >= 200112L
@@ -135,6 +201,27 @@
 #    endif
 #  endif
 
+// POSIX.1-2001: mmap()
+#  ifndef HAVE_MMAP
+#    if ZIX_POSIX_VERSION >= 200112L
+#      define HAVE_MMAP 1
+#    endif
+#  endif
+
+// POSIX.1-2001: nanosleep()
+#  ifndef HAVE_NANOSLEEP
+#    if ZIX_POSIX_VERSION >= 200112L
+#      define HAVE_NANOSLEEP 1
+#    endif
+#  endif
+
+// POSIX.1-2008: openat(), fdopendir(), fstatat(), and unlinkat()
+#  ifndef HAVE_OPENAT
+#    if ZIX_POSIX_VERSION >= 200809L
+#      define HAVE_OPENAT 1
+#    endif
+#  endif
+
 // POSIX.1-2001: pathconf()
 #  ifndef HAVE_PATHCONF
 #    if ZIX_POSIX_VERSION >= 200112L
@@ -170,6 +257,13 @@
 #    endif
 #  endif
 
+// POSIX.1-2001: sched_yield()
+#  ifndef HAVE_SCHED_YIELD
+#    if ZIX_POSIX_VERSION >= 200112L
+#      define HAVE_SCHED_YIELD 1
+#    endif
+#  endif
+
 // Windows Vista (Desktop, UWP): _sopen_s()
 #  ifndef HAVE_SOPEN_S
 #    if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0600
@@ -184,6 +278,21 @@
 #    endif
 #  endif
 
+// Linux 2.6.17 and glibc 2.6: sync_file_range()
+#  ifndef HAVE_SYNC_FILE_RANGE
+#    if defined(__linux__) && defined(__GLIBC__) && \
+      (__GLIBC__ > 2 || __GLIBC__ == 2 && __GLIBC_MINOR__ >= 6)
+#      define HAVE_SYNC_FILE_RANGE 1
+#    endif
+#  endif
+
+// POSIX.1-2001 or Windows: threads
+#  ifndef HAVE_THREADS
+#    if ZIX_POSIX_VERSION >= 200112L || defined(_WIN32)
+#      define HAVE_THREADS 1
+#    endif
+#  endif
+
 // Windows XP (Desktop): VirtualLock
 #  ifndef HAVE_VIRTUALLOCK
 #    if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0501 && !ZIX_WINAPI_UWP
@@ -237,6 +346,12 @@
 #  define USE_CREATESYMBOLICLINK 0
 #endif
 
+#if defined(HAVE_FICLONE) && HAVE_FICLONE
+#  define USE_FICLONE 1
+#else
+#  define USE_FICLONE 0
+#endif
+
 #if defined(HAVE_FILENO) && HAVE_FILENO
 #  define USE_FILENO 1
 #else
@@ -249,18 +364,78 @@
 #  define USE_FLOCK 0
 #endif
 
+#if defined(HAVE_FUTEX) && HAVE_FUTEX
+#  define USE_FUTEX 1
+#else
+#  define USE_FUTEX 0
+#endif
+
+#if defined(HAVE_GETENTROPY) && HAVE_GETENTROPY
+#  define USE_GETENTROPY 1
+#else
+#  define USE_GETENTROPY 0
+#endif
+
 #if defined(HAVE_GETFINALPATHNAMEBYHANDLE) && HAVE_GETFINALPATHNAMEBYHANDLE
 #  define USE_GETFINALPATHNAMEBYHANDLE 1
 #else
 #  define USE_GETFINALPATHNAMEBYHANDLE 0
 #endif
 
+#if defined(HAVE_INOTIFY) && HAVE_INOTIFY
+#  define USE_INOTIFY 1
+#else
+#  define USE_INOTIFY 0
+#endif
+
+#if defined(HAVE_IO_URING) && HAVE_IO_URING
+#  define USE_IO_URING 1
+#else
+#  define USE_IO_URING 0
+#endif
+
+#if defined(HAVE_MADVISE) && HAVE_MADVISE
+#  define USE_MADVISE 1
+#else
+#  define USE_MADVISE 0
+#endif
+
+#if defined(HAVE_MBIND) && HAVE_MBIND
+#  define USE_MBIND 1
+#else
+#  define USE_MBIND 0
+#endif
+
+#if defined(HAVE_MEMFD_CREATE) && HAVE_MEMFD_CREATE
+#  define USE_MEMFD_CREATE 1
+#else
+#  define USE_MEMFD_CREATE 0
+#endif
+
 #if defined(HAVE_MLOCK) && HAVE_MLOCK
 #  define USE_MLOCK 1
 #else
 #  define USE_MLOCK 0
 #endif
 
+#if defined(HAVE_MMAP) && HAVE_MMAP
+#  define USE_MMAP 1
+#else
+#  define USE_MMAP 0
+#endif
+
+#if defined(HAVE_NANOSLEEP) && HAVE_NANOSLEEP
+#  define USE_NANOSLEEP 1
+#else
+#  define USE_NANOSLEEP 0
+#endif
+
+#if defined(HAVE_OPENAT) && HAVE_OPENAT
+#  define USE_OPENAT 1
+#else
+#  define USE_OPENAT 0
+#endif
+
 #if defined(HAVE_PATHCONF) && HAVE_PATHCONF
 #  define USE_PATHCONF 1
 #else
@@ -285,6 +460,12 @@
 #  define USE_REALPATH 0
 #endif
 
+#if defined(HAVE_SCHED_YIELD) && HAVE_SCHED_YIELD
+#  define USE_SCHED_YIELD 1
+#else
+#  define USE_SCHED_YIELD 0
+#endif
+
 #if defined(HAVE_SEM_TIMEDWAIT) && HAVE_SEM_TIMEDWAIT
 #  define USE_SEM_TIMEDWAIT 1
 #else
@@ -303,6 +484,18 @@
 #  define USE_SYSCONF 0
 #endif
 
+#if defined(HAVE_SYNC_FILE_RANGE) && HAVE_SYNC_FILE_RANGE
+#  define USE_SYNC_FILE_RANGE 1
+#else
+#  define USE_SYNC_FILE_RANGE 0
+#endif
+
+#if defined(HAVE_THREADS) && HAVE_THREADS
+#  define USE_THREADS 1
+#else
+#  define USE_THREADS 0
+#endif
+
 #if defined(HAVE_VIRTUALLOCK) && HAVE_VIRTUALLOCK
 #  define USE_VIRTUALLOCK 1
 #else
@@ -6,11 +6,17 @@
 #include "failing_allocator.h"
 
 #include <zix/allocator.h>
+#include <zix/arena_allocator.h>
 #include <zix/bump_allocator.h>
+#include <zix/caching_allocator.h>
+#include <zix/counting_allocator.h>
+#include <zix/page_allocator.h>
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 static void
 test_allocator(void)
@@ -118,6 +124,395 @@ test_bump_allocator(void)
   zix_free(&allocator.base, malloced);  // Correct, but a noop
 }
 
+static void
+test_arena_allocator(void)
+{
+  ZixArenaAllocator* const arena = zix_arena_allocator_new(NULL, 64U);
+  ZixAllocator* const      base  = zix_arena_allocator_base(arena);
+
+  // Allocate within the initial block
+  char* const first = (char*)zix_malloc(base, 3U);
+  assert(first);
+  assert((uintptr_t)first % sizeof(uintmax_t) == 0U);
+  memcpy(first, "ab", 3U);
+
+  // Freeing the last allocation reclaims its space
+  char* const second = (char*)zix_malloc(base, 16U);
+  zix_free(base, second);
+  assert((char*)zix_malloc(base, 16U) == second);
+
+  // Realloc the last allocation in place, then beyond the initial block
+  const ZixArenaMark mark = zix_arena_allocator_mark(arena);
+
+  char* const calloced = (char*)zix_calloc(base, 4U, 4U);
+  assert(calloced);
+  assert(!calloced[0] && !calloced[15]);
+  calloced[15] = 15;
+  assert(zix_realloc(base, calloced, 24U) == calloced);
+
+  char* const moved = (char*)zix_realloc(base, calloced, 100U);
+  assert(moved);
+  assert(moved != calloced);
+  assert(moved[15] == 15);
+  memset(moved + 16U, 1, 84U);
+
+  // Reallocating an earlier allocation copies it to a new one
+  char* const copied = (char*)zix_realloc(base, first, 8U);
+  assert(copied);
+  assert(copied != first);
+  assert(!strcmp(copied, "ab"));
+  assert(!strcmp(first, "ab"));
+
+  // Make allocations of various alignments that each need a new block
+  for (size_t align = 8U; align <= 4096U; align *= 2U) {
+    char* const aligned = (char*)zix_aligned_alloc(base, align, 100U);
+    assert(aligned);
+    assert((uintptr_t)aligned % align == 0U);
+    memset(aligned, 2, 100U);
+    zix_aligned_free(base, aligned);
+  }
+
+  // Rewind, which releases the new blocks but keeps earlier allocations
+  zix_arena_allocator_rewind(arena, mark);
+  assert(!strcmp(first, "ab"));
+  assert((char*)zix_malloc(base, 16U) == calloced);
+
+  assert(!zix_realloc(base, base, 16U)); // Not from this arena
+
+  // Reset to release everything, then allocate from the start again
+  zix_arena_allocator_reset(arena);
+  assert((char*)zix_malloc(base, 8U) == first);
+
+  zix_arena_allocator_free(arena);
+}
+
+static void
+test_arena_allocator_failure(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  // Fail to create the arena
+  zix_failing_allocator_reset(&allocator, 0U);
+  assert(!zix_arena_allocator_new(&allocator.base, 64U));
+  assert(!zix_arena_allocator_new(&allocator.base, SIZE_MAX));
+
+  // Fail to allocate a new block
+  zix_failing_allocator_reset(&allocator, 1U);
+  ZixArenaAllocator* const arena = zix_arena_allocator_new(&allocator.base, 8U);
+  ZixAllocator* const      base  = zix_arena_allocator_base(arena);
+  void* const              ptr   = zix_malloc(base, 8U);
+  assert(ptr);
+  assert(!zix_malloc(base, 8U));
+  assert(!zix_realloc(base, ptr, 16U));
+  zix_arena_allocator_free(arena);
+}
+
+typedef struct {
+  size_t n_samples;  ///< Number of sampled allocations
+  size_t total_size; ///< Total size of sampled allocations
+} SampleCounts;
+
+static void
+count_sample(void* const handle, const void* const ptr, const size_t size)
+{
+  SampleCounts* const counts = (SampleCounts*)handle;
+
+  assert(ptr);
+  ++counts->n_samples;
+  counts->total_size += size;
+}
+
+static void
+test_counting_allocator(void)
+{
+  ZixCountingAllocator* const counting = zix_counting_allocator_new(NULL);
+  ZixAllocator* const         base     = zix_counting_allocator_base(counting);
+
+  ZixAllocationStats stats = zix_counting_allocator_stats(counting);
+  assert(!stats.live_bytes && !stats.peak_bytes && !stats.n_allocations);
+
+  char* const malloced = (char*)zix_malloc(base, 100U);
+  char* const calloced = (char*)zix_calloc(base, 3U, 100U);
+  char* const aligned  = (char*)zix_aligned_alloc(base, 4096U, 4096U);
+  assert((uintptr_t)malloced % sizeof(uintmax_t) == 0U);
+  assert((uintptr_t)calloced % sizeof(uintmax_t) == 0U);
+  assert((uintptr_t)aligned % 4096U == 0U);
+  assert(!calloced[0] && !calloced[299]);
+
+  stats = zix_counting_allocator_stats(counting);
+  assert(stats.live_bytes == 4496U);
+  assert(stats.peak_bytes == 4496U);
+  assert(stats.n_live == 3U);
+  assert(stats.n_allocations == 3U);
+  assert(stats.class_counts[7] == 1U);  // 100 bytes
+  assert(stats.class_counts[9] == 1U);  // 300 bytes
+  assert(stats.class_counts[12] == 1U); // 4096 bytes
+
+  // Reallocation counts as a new allocation
+  memset(malloced, 1, 100U);
+  char* const realloced = (char*)zix_realloc(base, malloced, 1000U);
+  assert(realloced[0] == 1 && realloced[99] == 1);
+
+  stats = zix_counting_allocator_stats(counting);
+  assert(stats.live_bytes == 5396U);
+  assert(stats.n_live == 3U);
+  assert(stats.n_allocations == 4U);
+  assert(stats.class_counts[10] == 1U);
+
+  zix_aligned_free(base, aligned);
+  zix_free(base, calloced);
+  zix_free(base, NULL);
+  zix_aligned_free(base, NULL);
+
+  stats = zix_counting_allocator_stats(counting);
+  assert(stats.live_bytes == 1000U);
+  assert(stats.peak_bytes == 5396U);
+  assert(stats.n_live == 1U);
+
+  // Sample about one allocation for every 1000 bytes
+  SampleCounts counts = {0U, 0U};
+  zix_counting_allocator_sample(counting, 1000U, count_sample, &counts);
+
+  char* small[100] = {NULL};
+  for (size_t i = 0U; i < 100U; ++i) {
+    small[i] = (char*)zix_realloc(base, NULL, 100U);
+  }
+
+  assert(counts.n_samples == 10U);
+  assert(counts.total_size == 1000U);
+
+  zix_counting_allocator_sample(counting, 1000U, NULL, NULL);
+  for (size_t i = 0U; i < 100U; ++i) {
+    zix_free(base, small[i]);
+  }
+
+  zix_free(base, realloced);
+  stats = zix_counting_allocator_stats(counting);
+  assert(!stats.live_bytes);
+  assert(!stats.n_live);
+  assert(stats.n_allocations == 104U);
+  assert(!stats.n_failures);
+
+  zix_counting_allocator_free(counting);
+}
+
+static void
+test_counting_allocator_failure(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  zix_failing_allocator_reset(&allocator, 0U);
+  assert(!zix_counting_allocator_new(&allocator.base));
+
+  zix_failing_allocator_reset(&allocator, 2U);
+  ZixCountingAllocator* const counting =
+    zix_counting_allocator_new(&allocator.base);
+
+  ZixAllocator* const base = zix_counting_allocator_base(counting);
+  char* const         ptr  = (char*)zix_malloc(base, 16U);
+  assert(ptr);
+  assert(!zix_malloc(base, 16U));
+  assert(!zix_calloc(base, 2U, 8U));
+  assert(!zix_realloc(base, ptr, 32U));
+  assert(!zix_aligned_alloc(base, 64U, 64U));
+
+  const ZixAllocationStats stats = zix_counting_allocator_stats(counting);
+  assert(stats.live_bytes == 16U);
+  assert(stats.n_allocations == 1U);
+  assert(stats.n_failures == 4U);
+
+  zix_free(base, ptr);
+  zix_counting_allocator_free(counting);
+}
+
+static void
+test_page_allocator(const ZixPageOptions options, const int numa_node)
+{
+  ZixPageAllocator* const pages =
+    zix_page_allocator_new(NULL, options, numa_node);
+
+  ZixAllocator* const base = zix_page_allocator_base(pages);
+
+  // Allocate many page-sized objects which are aligned to their size
+  char* objects[600] = {NULL};
+  for (size_t i = 0U; i < 600U; ++i) {
+    objects[i] = (char*)zix_aligned_alloc(base, 4096U, 4096U);
+    assert(objects[i]);
+    assert((uintptr_t)objects[i] % 4096U == 0U);
+    memset(objects[i], (int)(i & 0x7FU), 4096U);
+  }
+
+  for (size_t i = 0U; i < 600U; ++i) {
+    assert(objects[i][0] == (char)(i & 0x7FU));
+    assert(objects[i][4095] == (char)(i & 0x7FU));
+  }
+
+  // Freed objects are reused
+  char* const freed = objects[42];
+  zix_aligned_free(base, freed);
+  objects[42] = (char*)zix_calloc(base, 1024U, 4U);
+  assert(objects[42] == freed);
+  assert(!objects[42][0] && !objects[42][4095]);
+
+  // Small allocations and reallocation
+  char* const small = (char*)zix_malloc(base, 3U);
+  assert((uintptr_t)small % sizeof(uintmax_t) == 0U);
+  memcpy(small, "ab", 3U);
+  assert(zix_realloc(base, small, 12U) == small);
+
+  char* const grown = (char*)zix_realloc(base, small, 100U);
+  assert(grown != small);
+  assert(!strcmp(grown, "ab"));
+
+  // Large allocations that get their own mapping
+  char* const large = (char*)zix_aligned_alloc(base, 65536U, 3U << 20U);
+  assert(large);
+  assert((uintptr_t)large % 65536U == 0U);
+  large[0]                = 1;
+  large[(3U << 20U) - 1U] = 2;
+
+  char* const larger = (char*)zix_realloc(base, large, 5U << 20U);
+  assert(larger);
+  assert(larger[0] == 1);
+  assert(larger[(3U << 20U) - 1U] == 2);
+  assert(zix_realloc(base, larger, 4U << 20U) == larger);
+
+  char* const shrunk = (char*)zix_realloc(base, larger, 256U);
+  assert(shrunk[0] == 1);
+
+  assert(!zix_aligned_alloc(base, 2097152U, 64U));
+
+  zix_free(base, shrunk);
+  zix_free(base, grown);
+  zix_free(base, NULL);
+  for (size_t i = 0U; i < 600U; ++i) {
+    zix_aligned_free(base, objects[i]);
+  }
+
+  zix_page_allocator_free(pages);
+}
+
+static void
+test_page_allocator_failure(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  zix_failing_allocator_reset(&allocator, 0U);
+  assert(!zix_page_allocator_new(&allocator.base, ZIX_PAGE_OPTION_NONE, -1));
+}
+
+static void
+test_caching_allocator(void)
+{
+  assert(!zix_caching_allocator_new(NULL, 0U));
+
+  ZixCachingAllocator* const caching = zix_caching_allocator_new(NULL, 2U);
+  ZixAllocator* const        base    = zix_caching_allocator_base(caching);
+
+  // Allocate objects of every small size, which must not overlap
+  char* ptrs[257] = {NULL};
+  for (size_t i = 0U; i < 257U; ++i) {
+    ptrs[i] = (char*)zix_malloc(base, i * 16U);
+    assert(ptrs[i]);
+    assert((uintptr_t)ptrs[i] % sizeof(uintmax_t) == 0U);
+    memset(ptrs[i], (int)(i & 0xFFU), i * 16U);
+  }
+
+  for (size_t i = 0U; i < 257U; ++i) {
+    for (size_t j = 0U; j < i * 16U; ++j) {
+      assert(ptrs[i][j] == (char)(i & 0xFFU));
+    }
+  }
+
+  // Freed memory is reused for the same size class
+  char* const freed = ptrs[4];
+  zix_free(base, freed);
+  ptrs[4] = (char*)zix_malloc(base, 60U);
+  assert(ptrs[4] == freed);
+  memset(ptrs[4], 4, 60U);
+
+  // Reallocating within a class keeps the same memory
+  char* const realloced = (char*)zix_realloc(base, ptrs[4], 50U);
+  assert(realloced == ptrs[4]);
+
+  // Reallocating to a larger size copies the contents
+  ptrs[4] = (char*)zix_realloc(base, realloced, 5000U);
+  assert(ptrs[4]);
+  assert(ptrs[4] != realloced);
+  assert(ptrs[4][0] == 4 && ptrs[4][49] == 4);
+
+  for (size_t i = 0U; i < 257U; ++i) {
+    zix_free(base, ptrs[i]);
+  }
+
+  // Allocate zeroed memory from a class with recycled memory
+  char* const calloced = (char*)zix_calloc(base, 8U, 8U);
+  assert(calloced);
+  for (size_t i = 0U; i < 64U; ++i) {
+    assert(!calloced[i]);
+  }
+
+  // Allocate aligned memory, both small and large
+  for (size_t align = 16U; align <= 32768U; align *= 2U) {
+    char* const small = (char*)zix_aligned_alloc(base, align, 16U);
+    char* const large = (char*)zix_aligned_alloc(base, align, 8192U);
+    assert((uintptr_t)small % align == 0U);
+    assert((uintptr_t)large % align == 0U);
+    small[0]     = 1;
+    large[8191U] = 2;
+    zix_aligned_free(base, large);
+    zix_aligned_free(base, small);
+  }
+
+  assert(!zix_aligned_alloc(base, 65536U, 16U));
+
+  // Large allocations that are still live are freed with the allocator
+  void* const large1 = zix_malloc(base, 100000U);
+  void* const large2 = zix_malloc(base, 100000U);
+  void* const large3 = zix_malloc(base, 100000U);
+  assert(large1 && large2 && large3);
+  zix_free(base, large2);
+
+  zix_free(base, calloced);
+  zix_free(base, NULL);
+  zix_caching_allocator_free(caching);
+}
+
+static void
+test_caching_allocator_failure(void)
+{
+  static const size_t sizes[] = {16U, 512U, 4096U, 8192U};
+  static const size_t n_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+  // Count allocations with no failures
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  ZixCachingAllocator* caching = zix_caching_allocator_new(&allocator.base, 1U);
+  ZixAllocator*        base    = zix_caching_allocator_base(caching);
+  void*                ptr     = NULL;
+  for (size_t i = 0U; i < n_sizes; ++i) {
+    assert((ptr = zix_malloc(base, sizes[i])));
+  }
+  zix_caching_allocator_free(caching);
+
+  // Test that each allocation failing is handled gracefully
+  const size_t n_new_allocs = zix_failing_allocator_reset(&allocator, 0);
+  for (size_t i = 0U; i < n_new_allocs; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+
+    if ((caching = zix_caching_allocator_new(&allocator.base, 1U))) {
+      bool failed = false;
+      base        = zix_caching_allocator_base(caching);
+      for (size_t j = 0U; j < n_sizes; ++j) {
+        failed = failed || !zix_malloc(base, sizes[j]);
+      }
+
+      assert(failed);
+      zix_caching_allocator_free(caching);
+    }
+  }
+}
+
 static void
 test_failing_allocator(void)
 {
@@ -136,7 +531,17 @@ int
 main(void)
 {
   test_allocator();
+  test_arena_allocator();
+  test_arena_allocator_failure();
   test_bump_allocator();
+  test_caching_allocator();
+  test_caching_allocator_failure();
+  test_counting_allocator();
+  test_counting_allocator_failure();
+  test_page_allocator(ZIX_PAGE_OPTION_NONE, -1);
+  test_page_allocator(ZIX_PAGE_OPTION_TRANSPARENT_HUGE, 0);
+  test_page_allocator(ZIX_PAGE_OPTION_HUGE, -1);
+  test_page_allocator_failure();
   test_failing_allocator();
 
   return 0;
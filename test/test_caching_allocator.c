@@ -0,0 +1,144 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "test_args.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/caching_allocator.h>
+#include <zix/status.h>
+#include <zix/thread.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_THREADS 4U
+
+typedef struct {
+  ZixAllocator* allocator; ///< Shared caching allocator
+  unsigned      index;     ///< Index of this thread
+  size_t        n_objects; ///< Number of objects to allocate
+  char**        mine;      ///< Objects allocated by this thread
+  char**        theirs;    ///< Objects allocated by the next thread
+} Context;
+
+static size_t
+object_size(const unsigned thread, const size_t i)
+{
+  return 1U + ((thread * 37U + i * 13U) % 600U);
+}
+
+static ZixThreadResult ZIX_THREAD_FUNC
+allocate(void* const arg)
+{
+  Context* const ctx = (Context*)arg;
+
+  for (size_t i = 0U; i < ctx->n_objects; ++i) {
+    const size_t size = object_size(ctx->index, i);
+
+    ctx->mine[i] = (char*)zix_malloc(ctx->allocator, size);
+    assert(ctx->mine[i]);
+    memset(ctx->mine[i], (int)ctx->index, size);
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static ZixThreadResult ZIX_THREAD_FUNC
+churn(void* const arg)
+{
+  Context* const ctx = (Context*)arg;
+
+  for (size_t i = 0U; i < ctx->n_objects; ++i) {
+    // Free an object allocated by another thread, and make a new one here
+    assert(ctx->theirs[i][0] == (char)((ctx->index + 1U) % N_THREADS));
+    zix_free(ctx->allocator, ctx->theirs[i]);
+
+    const size_t size = object_size(ctx->index, i);
+    char* const  ptr  = (char*)zix_malloc(ctx->allocator, size);
+    assert(ptr);
+    memset(ptr, 0xFF, size);
+    zix_free(ctx->allocator, ptr);
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+run(ZixThreadFunc func, Context* const contexts)
+{
+  ZixThread threads[N_THREADS];
+
+  for (unsigned i = 0U; i < N_THREADS; ++i) {
+    assert(!zix_thread_create(&threads[i], 65536U, func, &contexts[i]));
+  }
+
+  for (unsigned i = 0U; i < N_THREADS; ++i) {
+    assert(!zix_thread_join(threads[i]));
+  }
+}
+
+static int
+test_threads(const size_t n_objects, const unsigned n_caches)
+{
+  ZixCachingAllocator* const caching =
+    zix_caching_allocator_new(NULL, n_caches);
+  assert(caching);
+
+  ZixAllocator* const base = zix_caching_allocator_base(caching);
+  char** const        objects =
+    (char**)zix_calloc(NULL, N_THREADS * n_objects, sizeof(char*));
+  assert(objects);
+
+  Context contexts[N_THREADS];
+  for (unsigned i = 0U; i < N_THREADS; ++i) {
+    contexts[i].allocator = base;
+    contexts[i].index     = i;
+    contexts[i].n_objects = n_objects;
+    contexts[i].mine      = objects + (i * n_objects);
+    contexts[i].theirs    = objects + (((i + 1U) % N_THREADS) * n_objects);
+  }
+
+  // Allocate objects in every thread, then free them from another
+  run(allocate, contexts);
+  run(churn, contexts);
+
+  // Allocate again, which reclaims memory from the remote frees
+  run(allocate, contexts);
+  for (unsigned i = 0U; i < N_THREADS; ++i) {
+    for (size_t j = 0U; j < n_objects; ++j) {
+      assert(contexts[i].mine[j][0] == (char)i);
+      zix_free(base, contexts[i].mine[j]);
+    }
+  }
+
+  zix_free(NULL, objects);
+  zix_caching_allocator_free(caching);
+  return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    printf("Usage: %s [N_OBJECTS] [N_CACHES]\n", argv[0]);
+    return 1;
+  }
+
+  const size_t n_objects =
+    (argc > 1) ? zix_test_size_arg(argv[1], 1U, 1U << 20U) : 4096U;
+
+  const unsigned n_caches =
+    (argc > 2) ? (unsigned)zix_test_size_arg(argv[2], 1U, 64U) : 2U;
+
+  printf("Testing %zu objects in %u threads with %u caches\n",
+         n_objects,
+         N_THREADS,
+         n_caches);
+
+  return test_threads(n_objects, n_caches);
+}
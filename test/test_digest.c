@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 // Just basic smoke tests to ensure the hash functions are reacting to data
 
@@ -116,7 +117,144 @@ test_digest_aligned(void)
   }
 }
 
-ZIX_PURE_FUNC int
+static void
+test_incremental(void)
+{
+  uint8_t data[67] = {0U};
+  for (size_t i = 0U; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)((i * 31U) + 7U);
+  }
+
+  // Hash every prefix of the data in every possible chunk size
+  for (size_t len = 0U; len <= sizeof(data); ++len) {
+    for (size_t chunk = 1U; chunk <= 9U; ++chunk) {
+      ZixDigest32State state32;
+      ZixDigest64State state64;
+      ZixDigestState   state;
+      zix_digest32_init(&state32, 42U);
+      zix_digest64_init(&state64, 42U, len);
+      zix_digest_init(&state, 42U, len);
+
+      for (size_t offset = 0U; offset < len; offset += chunk) {
+        const size_t n = (len - offset < chunk) ? len - offset : chunk;
+        zix_digest32_update(&state32, &data[offset], n);
+        zix_digest64_update(&state64, &data[offset], n);
+        zix_digest_update(&state, &data[offset], n);
+      }
+
+      assert(zix_digest32_final(&state32) == zix_digest32(42U, data, len));
+      assert(zix_digest64_final(&state64) == zix_digest64(42U, data, len));
+      assert(zix_digest_final(&state) == zix_digest(42U, data, len));
+    }
+  }
+}
+
+static void
+test_digest64_wide(void)
+{
+  uint64_t data[68] = {0U};
+  uint8_t* bytes    = (uint8_t*)data;
+  for (size_t i = 0U; i < sizeof(data); ++i) {
+    bytes[i] = (uint8_t)((i * 31U) + 7U);
+  }
+
+  // Short inputs are hashed exactly like zix_digest64()
+  for (size_t len = 0U; len < 256U; ++len) {
+    assert(zix_digest64_wide(42U, bytes, len) == zix_digest64(42U, bytes, len));
+  }
+
+  // Long inputs of every possible tail size react to each byte
+  const size_t len = 256U + 33U;
+  for (size_t end = 256U; end <= len; ++end) {
+    const uint64_t h = zix_digest64_wide(42U, bytes, end);
+    assert(h != zix_digest64_wide(43U, bytes, end));
+    assert(h != zix_digest64_wide(42U, bytes, end - 1U));
+  }
+
+  const uint64_t h = zix_digest64_wide(42U, bytes, len);
+  for (size_t i = 0U; i < len; ++i) {
+    bytes[i] ^= 1U;
+    assert(zix_digest64_wide(42U, bytes, len) != h);
+    bytes[i] ^= 1U;
+  }
+
+  // Swapping lanes changes the result
+  const uint64_t first = data[0];
+  data[0]              = data[1];
+  data[1]              = first;
+  assert(zix_digest64_wide(42U, bytes, len) != h);
+  data[1] = data[0];
+  data[0] = first;
+
+  // Unaligned input gives the same result as aligned input
+  uint8_t unaligned[sizeof(data) + 1U] = {0U};
+  for (size_t i = 0U; i < len; ++i) {
+    unaligned[i + 1U] = bytes[i];
+  }
+
+  assert(zix_digest64_wide(42U, &unaligned[1], len) == h);
+}
+
+static void
+test_digest64_batch(void)
+{
+  uint8_t data[96] = {0U};
+  for (size_t i = 0U; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)((i * 31U) + 7U);
+  }
+
+  // Make keys of varying lengths and alignments
+  const void* bufs[13] = {NULL};
+  size_t      lens[13] = {0U};
+  for (size_t i = 0U; i < 13U; ++i) {
+    bufs[i] = &data[i];
+    lens[i] = (i * 29U) % 80U;
+  }
+
+  // Hash every prefix of the keys so every number of leftover keys is tested
+  for (size_t n = 0U; n <= 13U; ++n) {
+    uint64_t out[13] = {0U};
+    zix_digest64_batch(42U, bufs, lens, n, out);
+    for (size_t i = 0U; i < n; ++i) {
+      assert(out[i] == zix_digest64(42U, bufs[i], lens[i]));
+    }
+
+    for (size_t i = n; i < 13U; ++i) {
+      assert(!out[i]);
+    }
+  }
+}
+
+static void
+test_digest64_keyed(void)
+{
+  // Test vectors from the SipHash reference implementation
+  const ZixDigestKey key = {0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL};
+
+  uint8_t data[63] = {0U};
+  for (size_t i = 0U; i < sizeof(data); ++i) {
+    data[i] = (uint8_t)i;
+  }
+
+  assert(zix_digest64_keyed(&key, data, 0U) == 0x726FDB47DD0E0E31ULL);
+  assert(zix_digest64_keyed(&key, data, 63U) == 0x958A324CEB064572ULL);
+
+  // Unaligned input gives the same result as aligned input
+  uint8_t unaligned[sizeof(data) + 1U] = {0U};
+  memcpy(&unaligned[1], data, sizeof(data));
+  assert(zix_digest64_keyed(&key, &unaligned[1], 63U) == 0x958A324CEB064572ULL);
+
+  // Different random keys give different results
+  ZixDigestKey key1 = {0U, 0U};
+  ZixDigestKey key2 = {0U, 0U};
+  assert(!zix_digest_random_key(&key1));
+  assert(!zix_digest_random_key(&key2));
+  assert(key1.k0 != key2.k0 || key1.k1 != key2.k1);
+  assert(zix_digest64_keyed(&key1, data, sizeof(data)) !=
+         zix_digest64_keyed(&key2, data, sizeof(data)));
+}
+
+int
 main(void)
 {
   test_digest32();
@@ -127,5 +265,10 @@ main(void)
   test_digest64_aligned();
   test_digest_aligned();
 
+  test_incremental();
+  test_digest64_wide();
+  test_digest64_batch();
+  test_digest64_keyed();
+
   return 0;
 }
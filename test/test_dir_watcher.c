@@ -0,0 +1,298 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "failing_allocator.h"
+
+#include <zix/allocator.h>
+#include <zix/dir_watcher.h>
+#include <zix/filesystem.h>
+#include <zix/path.h>
+#include <zix/ring.h>
+#include <zix/status.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENTS 4U
+#define MAX_NAME_SIZE 8U
+
+typedef struct {
+  ZixDirEventType type;
+  char            name[MAX_NAME_SIZE];
+  char            old_name[MAX_NAME_SIZE];
+} RecordedEvent;
+
+typedef struct {
+  unsigned      n_batches;
+  size_t        n_events;
+  RecordedEvent events[MAX_EVENTS];
+} RecordedEvents;
+
+static void
+record_event(RecordedEvents* const recorded,
+             const ZixDirEventType type,
+             const char* const     name,
+             const char* const     old_name)
+{
+  assert(recorded->n_events < MAX_EVENTS);
+  assert(strlen(name) < MAX_NAME_SIZE);
+  assert(!old_name || strlen(old_name) < MAX_NAME_SIZE);
+
+  RecordedEvent* const event = &recorded->events[recorded->n_events++];
+  event->type                = type;
+  memcpy(event->name, name, strlen(name) + 1U);
+  if (old_name) {
+    memcpy(event->old_name, old_name, strlen(old_name) + 1U);
+  }
+}
+
+static void
+record_events(void* const              data,
+              const size_t             n_events,
+              const ZixDirEvent* const events)
+{
+  RecordedEvents* const recorded = (RecordedEvents*)data;
+
+  assert(n_events);
+  ++recorded->n_batches;
+  for (size_t i = 0U; i < n_events; ++i) {
+    record_event(recorded, events[i].type, events[i].name, events[i].old_name);
+  }
+}
+
+static RecordedEvents
+read_events(ZixDirWatcher* const watcher, const ZixStatus expected_status)
+{
+  RecordedEvents recorded;
+  memset(&recorded, 0, sizeof(recorded));
+
+  const ZixStatus st = zix_dir_watcher_wait(watcher, 0U, 10000000U);
+  assert(!st || st == ZIX_STATUS_TIMEOUT);
+
+  assert(zix_dir_watcher_read(watcher, record_events, &recorded) ==
+         expected_status);
+
+  return recorded;
+}
+
+static void
+check_event(const RecordedEvents* const recorded,
+            const size_t                index,
+            const ZixDirEventType       type,
+            const char* const           name,
+            const char* const           old_name)
+{
+  assert(index < recorded->n_events);
+
+  const RecordedEvent* const event = &recorded->events[index];
+  assert(event->type == type);
+  assert(!strcmp(event->name, name));
+  assert(!strcmp(event->old_name, old_name ? old_name : ""));
+}
+
+static void
+write_file(const char* const dir,
+           const char* const name,
+           const char* const mode)
+{
+  char* const path = zix_path_join(NULL, dir, name);
+  FILE* const f    = fopen(path, mode);
+  assert(f);
+  assert(fwrite(name, 1U, strlen(name), f) == strlen(name));
+  assert(!fclose(f));
+  zix_free(NULL, path);
+}
+
+static void
+rename_file(const char* const dir,
+            const char* const old_name,
+            const char* const new_name)
+{
+  char* const old_path = zix_path_join(NULL, dir, old_name);
+  char* const new_path = zix_path_join(NULL, dir, new_name);
+  assert(!rename(old_path, new_path));
+  zix_free(NULL, new_path);
+  zix_free(NULL, old_path);
+}
+
+static void
+remove_file(const char* const dir, const char* const name)
+{
+  char* const path = zix_path_join(NULL, dir, name);
+  assert(!zix_remove(path));
+  zix_free(NULL, path);
+}
+
+static void
+read_ring_event(ZixRing* const        ring,
+                RecordedEvents* const recorded,
+                const char* const     name)
+{
+  ZixDirEventHeader header = {0U, 0U, 0U};
+  char              name_buf[MAX_NAME_SIZE];
+
+  assert(zix_ring_read(ring, &header, sizeof(header)) == sizeof(header));
+  assert(header.name_size == strlen(name) + 1U);
+  assert(!header.old_name_size);
+  assert(zix_ring_read(ring, name_buf, header.name_size) == header.name_size);
+  record_event(recorded, (ZixDirEventType)header.type, name_buf, NULL);
+}
+
+static void
+test_watch(const ZixDirWatchOptions options)
+{
+  char* const temp = zix_temp_directory_path(NULL);
+  assert(temp);
+
+  char* const pattern = zix_path_join(NULL, temp, "zixXXXXXX");
+  char* const dir     = zix_create_temporary_directory(NULL, pattern);
+  assert(dir);
+
+  // Watching a missing directory or a regular file fails
+  char* const a_path = zix_path_join(NULL, dir, "a");
+  assert(!zix_dir_watcher_new(NULL, a_path, options));
+  write_file(dir, "a", "wb");
+  assert(!zix_dir_watcher_new(NULL, a_path, options));
+
+  // Existing files aren't reported
+  ZixDirWatcher* const watcher = zix_dir_watcher_new(NULL, dir, options);
+  assert(watcher);
+
+  RecordedEvents recorded = read_events(watcher, ZIX_STATUS_SUCCESS);
+  assert(!recorded.n_batches);
+
+  // Creating a file (and writing to it) is reported as a single creation
+  write_file(dir, "b", "wb");
+  recorded = read_events(watcher, ZIX_STATUS_SUCCESS);
+  assert(recorded.n_batches == 1U);
+  assert(recorded.n_events == 1U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_CREATED, "b", NULL);
+
+  // Modifying a file is reported
+  write_file(dir, "a", "ab");
+  recorded = read_events(watcher, ZIX_STATUS_SUCCESS);
+  assert(recorded.n_events == 1U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_MODIFIED, "a", NULL);
+
+  // Renaming a file within the directory is reported as a rename
+  rename_file(dir, "b", "c");
+  recorded = read_events(watcher, ZIX_STATUS_SUCCESS);
+  assert(recorded.n_events == 1U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_RENAMED, "c", "b");
+
+  // Deleting a file is reported
+  remove_file(dir, "a");
+  recorded = read_events(watcher, ZIX_STATUS_SUCCESS);
+  assert(recorded.n_events == 1U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_DELETED, "a", NULL);
+
+  // Events that don't fit in a ring are kept and written by the next read
+  ZixRing* const ring = zix_ring_new(NULL, 16U);
+  assert(ring);
+  write_file(dir, "d", "wb");
+  write_file(dir, "e", "wb");
+  write_file(dir, "xyz", "wb");
+  memset(&recorded, 0, sizeof(recorded));
+  assert(zix_dir_watcher_wait(watcher, 0U, 10000000U) == ZIX_STATUS_SUCCESS);
+  assert(zix_dir_watcher_read_ring(watcher, ring) == ZIX_STATUS_NO_MEM);
+  read_ring_event(ring, &recorded, "d");
+  assert(!zix_ring_read_space(ring));
+  assert(zix_dir_watcher_wait(watcher, 0U, 0U) == ZIX_STATUS_SUCCESS);
+
+  // An event that's too large for the ring is discarded as an overflow
+  assert(zix_dir_watcher_read_ring(watcher, ring) == ZIX_STATUS_OVERFLOW);
+  read_ring_event(ring, &recorded, "e");
+  assert(!zix_ring_read_space(ring));
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_CREATED, "d", NULL);
+  check_event(&recorded, 1U, ZIX_DIR_EVENT_CREATED, "e", NULL);
+  zix_ring_free(ring);
+
+  // Removing the directory reports the deletion of its contents
+  remove_file(dir, "c");
+  remove_file(dir, "d");
+  remove_file(dir, "e");
+  remove_file(dir, "xyz");
+  assert(!zix_remove(dir));
+  recorded = read_events(watcher, ZIX_STATUS_NOT_FOUND);
+  assert(recorded.n_batches == 1U);
+  assert(recorded.n_events == 4U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_DELETED, "c", NULL);
+  check_event(&recorded, 1U, ZIX_DIR_EVENT_DELETED, "d", NULL);
+  check_event(&recorded, 2U, ZIX_DIR_EVENT_DELETED, "e", NULL);
+  check_event(&recorded, 3U, ZIX_DIR_EVENT_DELETED, "xyz", NULL);
+
+  // After which nothing more is reported
+  recorded = read_events(watcher, ZIX_STATUS_NOT_FOUND);
+  assert(!recorded.n_batches);
+
+  zix_dir_watcher_free(watcher);
+  zix_free(NULL, a_path);
+  zix_free(NULL, dir);
+  free(pattern);
+  zix_free(NULL, temp);
+}
+
+static void
+test_failed_alloc(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  char* const temp = zix_temp_directory_path(NULL);
+  assert(temp);
+
+  char* const pattern = zix_path_join(NULL, temp, "zixXXXXXX");
+  char* const dir     = zix_create_temporary_directory(NULL, pattern);
+  assert(dir);
+  write_file(dir, "a", "wb");
+
+  // Successfully create a polling watcher to count the number of allocations
+  ZixDirWatcher* watcher =
+    zix_dir_watcher_new(&allocator.base, dir, ZIX_DIR_WATCH_POLL);
+  assert(watcher);
+  zix_dir_watcher_free(watcher);
+
+  // Test that each allocation failing is handled gracefully
+  const size_t n_new_allocs = zix_failing_allocator_reset(&allocator, 0);
+  for (size_t i = 0U; i < n_new_allocs; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+    assert(!zix_dir_watcher_new(&allocator.base, dir, ZIX_DIR_WATCH_POLL));
+  }
+
+  // Test that failing to read events is handled gracefully
+  zix_failing_allocator_reset(&allocator, SIZE_MAX);
+  watcher = zix_dir_watcher_new(&allocator.base, dir, ZIX_DIR_WATCH_POLL);
+  assert(watcher);
+  write_file(dir, "b", "wb");
+  zix_failing_allocator_reset(&allocator, 0U);
+
+  RecordedEvents recorded;
+  memset(&recorded, 0, sizeof(recorded));
+  assert(zix_dir_watcher_read(watcher, record_events, &recorded) ==
+         ZIX_STATUS_NO_MEM);
+
+  zix_failing_allocator_reset(&allocator, SIZE_MAX);
+  assert(!zix_dir_watcher_read(watcher, record_events, &recorded));
+  assert(recorded.n_events == 1U);
+  check_event(&recorded, 0U, ZIX_DIR_EVENT_CREATED, "b", NULL);
+  zix_dir_watcher_free(watcher);
+
+  remove_file(dir, "b");
+  remove_file(dir, "a");
+  assert(!zix_remove(dir));
+  zix_free(NULL, dir);
+  free(pattern);
+  zix_free(NULL, temp);
+}
+
+int
+main(void)
+{
+  test_watch(0U);
+  test_watch(ZIX_DIR_WATCH_POLL);
+  test_failed_alloc();
+  return 0;
+}
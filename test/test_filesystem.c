@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -248,6 +249,21 @@ test_copy_file(const char* data_file_path)
   assert(zix_file_type(copy_path) == ZIX_FILE_TYPE_NONE);
   assert(!zix_copy_file(NULL, tmp_file_path, copy_path, 0U));
   assert(zix_file_equals(NULL, tmp_file_path, copy_path));
+
+  // Successful overwriting copies with every durability level
+  static const ZixCopyOptions sync_options[] = {
+    ZIX_COPY_OPTION_NO_SYNC, ZIX_COPY_OPTION_NONE, ZIX_COPY_OPTION_FULL_SYNC};
+
+  for (size_t i = 0U; i < sizeof(sync_options) / sizeof(sync_options[0]); ++i) {
+    const ZixCopyOptions options =
+      ZIX_COPY_OPTION_OVERWRITE_EXISTING | sync_options[i];
+
+    assert(zix_copy_file(NULL, tmp_file_path, copy_path, sync_options[i]) ==
+           ZIX_STATUS_EXISTS);
+    assert(!zix_copy_file(NULL, tmp_file_path, copy_path, options));
+    assert(zix_file_equals(NULL, tmp_file_path, copy_path));
+  }
+
   assert(!zix_remove(copy_path));
 
   if (zix_file_type("/dev/random") == ZIX_FILE_TYPE_CHARACTER) {
@@ -296,6 +312,272 @@ test_copy_file(const char* data_file_path)
   free(temp_dir);
 }
 
+static void
+test_copy_sparse_file(void)
+{
+  static const long hole_size = 0x400000L;
+
+  char* const temp_dir = create_temp_dir("zixXXXXXX");
+  char* const src_path = zix_path_join(NULL, temp_dir, "zix_test_sparse");
+  char* const dst_path = zix_path_join(NULL, temp_dir, "zix_test_copy");
+
+  // Write a file with data at the start and end, and a hole in the middle
+  FILE* const f = fopen(src_path, "wb");
+  assert(f);
+  assert(fwrite("start", 1U, 5U, f) == 5U);
+  assert(!fseek(f, hole_size, SEEK_CUR));
+  assert(fwrite("end", 1U, 3U, f) == 3U);
+  assert(!fclose(f));
+
+  // Copy it and check that the contents match
+  assert(!zix_copy_file(NULL, src_path, dst_path, 0U));
+  assert(zix_file_size(dst_path) == hole_size + 8);
+  assert(zix_file_equals(NULL, src_path, dst_path));
+
+#if defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112L
+  // Extend the file with a hole at the end and copy it again
+  assert(!truncate(src_path, 2L * hole_size));
+  assert(!zix_copy_file(
+    NULL, src_path, dst_path, ZIX_COPY_OPTION_OVERWRITE_EXISTING));
+  assert(zix_file_size(dst_path) == 2L * hole_size);
+  assert(zix_file_equals(NULL, src_path, dst_path));
+
+  // If the file is sparse, check that the copy is too
+  struct stat src_stat;
+  struct stat dst_stat;
+  assert(!stat(src_path, &src_stat));
+  assert(!stat(dst_path, &dst_stat));
+  if (src_stat.st_blocks * 512 < src_stat.st_size) {
+    assert(dst_stat.st_blocks <= src_stat.st_blocks);
+  }
+#endif
+
+  assert(!zix_remove(dst_path));
+  assert(!zix_remove(src_path));
+  assert(!zix_remove(temp_dir));
+  free(dst_path);
+  free(src_path);
+  free(temp_dir);
+}
+
+static void
+test_copy_tree(void)
+{
+  static const char* const dir_names[] = {"sub", "sub/deep", "empty"};
+  static const char* const file_names[] = {
+    "a.txt", "b.txt", "sub/c.txt", "sub/deep/d.txt", "sub/deep/e.txt"};
+
+  static const size_t n_dirs  = sizeof(dir_names) / sizeof(char*);
+  static const size_t n_files = sizeof(file_names) / sizeof(char*);
+
+  char* const temp_dir = create_temp_dir("zixXXXXXX");
+  char* const src_dir  = zix_path_join(NULL, temp_dir, "src");
+  char* const dst_dir  = zix_path_join(NULL, temp_dir, "dst");
+  assert(!zix_create_directory(src_dir));
+
+  // Create a small source tree
+  for (size_t i = 0U; i < n_dirs; ++i) {
+    char* const path = zix_path_join(NULL, src_dir, dir_names[i]);
+    assert(!zix_create_directory(path));
+    free(path);
+  }
+
+  for (size_t i = 0U; i < n_files; ++i) {
+    char* const path = zix_path_join(NULL, src_dir, file_names[i]);
+    assert(!write_to_path(path, file_names[i]));
+    free(path);
+  }
+
+#ifndef _WIN32
+  // Add relative links to a file and to a parent directory
+  static const char* const link_names[]   = {"link.txt", "sub/up"};
+  static const char* const link_targets[] = {"a.txt", ".."};
+  static const ZixFileType link_types[]   = {ZIX_FILE_TYPE_REGULAR,
+                                             ZIX_FILE_TYPE_DIRECTORY};
+
+  static const size_t n_links = sizeof(link_names) / sizeof(char*);
+
+  for (size_t i = 0U; i < n_links; ++i) {
+    char* const path = zix_path_join(NULL, src_dir, link_names[i]);
+    assert(!zix_create_symlink(link_targets[i], path));
+    free(path);
+  }
+#endif
+
+  // Fail to copy a file or nonexistent directory
+  char* const a_path = zix_path_join(NULL, src_dir, "a.txt");
+  assert(zix_copy_tree(NULL, a_path, dst_dir, 0U, 1U) == ZIX_STATUS_BAD_ARG);
+  assert(zix_copy_tree(NULL, "/does/not/exist", dst_dir, 0U, 1U) ==
+         ZIX_STATUS_BAD_ARG);
+  free(a_path);
+
+  // Copy the tree, then fail to copy it again since it already exists
+  assert(!zix_copy_tree(NULL, src_dir, dst_dir, 0U, 4U));
+  assert(zix_copy_tree(NULL, src_dir, dst_dir, 0U, 4U) == ZIX_STATUS_EXISTS);
+
+  // Copy again over the existing tree, in one thread, and without syncing
+  assert(!zix_copy_tree(
+    NULL, src_dir, dst_dir, ZIX_COPY_OPTION_OVERWRITE_EXISTING, 1U));
+  assert(!zix_copy_tree(NULL,
+                        src_dir,
+                        dst_dir,
+                        ZIX_COPY_OPTION_OVERWRITE_EXISTING |
+                          ZIX_COPY_OPTION_NO_SYNC,
+                        2U));
+
+  // Count the allocations made while copying over the existing tree
+  ZixFailingAllocator allocator = zix_failing_allocator();
+  assert(!zix_copy_tree(&allocator.base,
+                        src_dir,
+                        dst_dir,
+                        ZIX_COPY_OPTION_OVERWRITE_EXISTING,
+                        1U));
+
+  // Failing to allocate copy buffers is fine, but paths aren't
+  const size_t n_allocs = zix_failing_allocator_reset(&allocator, 0U);
+  for (size_t i = 0U; i < n_allocs; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+    const ZixStatus st = zix_copy_tree(&allocator.base,
+                                       src_dir,
+                                       dst_dir,
+                                       ZIX_COPY_OPTION_OVERWRITE_EXISTING,
+                                       1U);
+    assert(!st || st == ZIX_STATUS_NO_MEM);
+  }
+
+  // Check and remove everything in reverse order
+#ifndef _WIN32
+  for (size_t i = 0U; i < n_links; ++i) {
+    char* const src_path = zix_path_join(NULL, src_dir, link_names[i]);
+    char* const dst_path = zix_path_join(NULL, dst_dir, link_names[i]);
+    assert(zix_symlink_type(dst_path) == ZIX_FILE_TYPE_SYMLINK);
+    assert(zix_file_type(dst_path) == link_types[i]);
+    assert(!zix_remove(dst_path));
+    assert(!zix_remove(src_path));
+    free(dst_path);
+    free(src_path);
+  }
+#endif
+
+  for (size_t i = 0U; i < n_files; ++i) {
+    char* const src_path = zix_path_join(NULL, src_dir, file_names[i]);
+    char* const dst_path = zix_path_join(NULL, dst_dir, file_names[i]);
+    assert(zix_file_type(dst_path) == ZIX_FILE_TYPE_REGULAR);
+    assert(zix_file_equals(NULL, src_path, dst_path));
+    assert(!zix_remove(dst_path));
+    assert(!zix_remove(src_path));
+    free(dst_path);
+    free(src_path);
+  }
+
+  for (size_t i = 0U; i < n_dirs; ++i) {
+    const size_t d        = n_dirs - i - 1U;
+    char* const  src_path = zix_path_join(NULL, src_dir, dir_names[d]);
+    char* const  dst_path = zix_path_join(NULL, dst_dir, dir_names[d]);
+    assert(zix_file_type(dst_path) == ZIX_FILE_TYPE_DIRECTORY);
+    assert(!zix_remove(dst_path));
+    assert(!zix_remove(src_path));
+    free(dst_path);
+    free(src_path);
+  }
+
+  assert(!zix_remove(dst_dir));
+  assert(!zix_remove(src_dir));
+  assert(!zix_remove(temp_dir));
+  free(dst_dir);
+  free(src_dir);
+  free(temp_dir);
+}
+
+static void
+test_transfer_files(void)
+{
+  // Enough files to be submitted together where that's supported
+  static const size_t n_files = 130U;
+
+  char* const temp_dir = create_temp_dir("zixXXXXXX");
+  char*       paths[130];
+  char        contents[130][16];
+  char        buffers[130][32];
+
+  ZixFileTransfer transfers[130];
+  memset(transfers, 0, sizeof(transfers));
+
+  // Write several files at once
+  for (size_t i = 0U; i < n_files; ++i) {
+    char name[16] = {'\0'};
+    snprintf(name, sizeof(name), "f%u", (unsigned)i);
+    memset(contents[i], 'a' + (int)(i % 26U), sizeof(contents[i]));
+
+    paths[i]             = zix_path_join(NULL, temp_dir, name);
+    transfers[i].type    = ZIX_FILE_TRANSFER_WRITE;
+    transfers[i].path    = paths[i];
+    transfers[i].buffer  = contents[i];
+    transfers[i].size    = 1U + (i % 16U);
+    transfers[i].n_bytes = 0U;
+    transfers[i].status  = ZIX_STATUS_ERROR;
+  }
+
+  assert(!zix_transfer_files(n_files, transfers));
+  for (size_t i = 0U; i < n_files; ++i) {
+    assert(!transfers[i].status);
+    assert(transfers[i].n_bytes == 1U + (i % 16U));
+    assert(zix_file_size(paths[i]) == (ZixFileOffset)(1U + (i % 16U)));
+  }
+
+  // Read them back into larger buffers, with one smaller buffer
+  for (size_t i = 0U; i < n_files; ++i) {
+    transfers[i].type   = ZIX_FILE_TRANSFER_READ;
+    transfers[i].buffer = buffers[i];
+    transfers[i].size   = (i == 7U) ? 4U : sizeof(buffers[i]);
+  }
+
+  assert(!zix_transfer_files(n_files, transfers));
+  for (size_t i = 0U; i < n_files; ++i) {
+    const size_t size = (i == 7U) ? 4U : (1U + (i % 16U));
+    assert(!transfers[i].status);
+    assert(transfers[i].n_bytes == size);
+    assert(!memcmp(buffers[i], contents[i], size));
+  }
+
+  // Fail to read a nonexistent file, in a large and small batch
+  transfers[3].path = "/does/not/exist";
+  assert(zix_transfer_files(n_files, transfers) == ZIX_STATUS_NOT_FOUND);
+  assert(transfers[3].status == ZIX_STATUS_NOT_FOUND);
+  assert(!transfers[2].status && !transfers[4].status);
+  assert(zix_transfer_files(2U, transfers + 2U) == ZIX_STATUS_NOT_FOUND);
+  assert(!transfers[2].status);
+  assert(transfers[3].status == ZIX_STATUS_NOT_FOUND);
+
+  for (size_t i = 0U; i < n_files; ++i) {
+    assert(!zix_remove(paths[i]));
+    free(paths[i]);
+  }
+
+  assert(!zix_remove(temp_dir));
+  free(temp_dir);
+}
+
+static void
+test_sync_files(void)
+{
+  char* const temp_dir  = create_temp_dir("zixXXXXXX");
+  char* const file_path = zix_path_join(NULL, temp_dir, "zix_test_file");
+  assert(!write_to_path(file_path, "test\n"));
+
+  const char* const paths[] = {file_path, temp_dir, "/does/not/exist"};
+
+  assert(!zix_sync_files(0U, paths, 0U));
+  assert(!zix_sync_files(2U, paths, 0U));
+  assert(!zix_sync_files(2U, paths, ZIX_COPY_OPTION_FULL_SYNC));
+  assert(zix_sync_files(3U, paths, 0U) == ZIX_STATUS_NOT_FOUND);
+
+  assert(!zix_remove(file_path));
+  assert(!zix_remove(temp_dir));
+  free(file_path);
+  free(temp_dir);
+}
+
 static void
 test_flock(void)
 {
@@ -351,6 +633,297 @@ visit(const char* const path, const char* const name, void* const data)
   }
 }
 
+static void
+test_file_map(void)
+{
+  char* const temp_dir   = create_temp_dir("zixXXXXXX");
+  char* const file_path  = zix_path_join(NULL, temp_dir, "zix_test_file");
+  char* const empty_path = zix_path_join(NULL, temp_dir, "zix_test_empty");
+  assert(!write_to_path(file_path, "test\n"));
+  assert(!write_to_path(empty_path, ""));
+
+  ZixFileView view = {NULL, 0U};
+  ZixStatus   st   = zix_file_map(
+    NULL, file_path, ZIX_FILE_MAP_READ, ZIX_FILE_MAP_HINT_NONE, &view);
+  if (st == ZIX_STATUS_NOT_SUPPORTED) {
+    assert(!view.data);
+    assert(!view.size);
+  } else {
+    // Map for reading with every hint
+    for (uint32_t hint = 0U; hint < 4U; ++hint) {
+      assert(!zix_file_unmap(&view));
+      assert(!view.data);
+      assert(!zix_file_map(
+        NULL, file_path, ZIX_FILE_MAP_READ, 1U << hint, &view));
+      assert(view.size == 5U);
+      assert(!memcmp(view.data, "test\n", 5U));
+    }
+
+    assert(!zix_file_unmap(&view));
+
+    // Map for writing and modify the file
+    assert(!zix_file_map(NULL,
+                         file_path,
+                         ZIX_FILE_MAP_READ_WRITE,
+                         ZIX_FILE_MAP_HINT_RANDOM,
+                         &view));
+    assert(view.size == 5U);
+    memcpy(view.data, "TEST", 4U);
+    assert(!zix_file_unmap(&view));
+
+    char        buf[8] = {0};
+    FILE* const f      = fopen(file_path, "rb");
+    assert(f);
+    assert(fread(buf, 1U, sizeof(buf), f) == 5U);
+    assert(!strcmp(buf, "TEST\n"));
+    fclose(f);
+
+    // Map an empty file
+    assert(!zix_file_map(
+      NULL, empty_path, ZIX_FILE_MAP_READ, ZIX_FILE_MAP_HINT_NONE, &view));
+    assert(!view.data);
+    assert(!view.size);
+    assert(!zix_file_unmap(&view));
+
+    // Fail to map a nonexistent file or a directory
+    st = zix_file_map(NULL,
+                      "/does/not/exist",
+                      ZIX_FILE_MAP_READ,
+                      ZIX_FILE_MAP_HINT_NONE,
+                      &view);
+    assert(st == ZIX_STATUS_NOT_FOUND);
+    assert(zix_file_map(
+      NULL, temp_dir, ZIX_FILE_MAP_READ, ZIX_FILE_MAP_HINT_NONE, &view));
+    assert(!view.data);
+  }
+
+  assert(!zix_remove(empty_path));
+  assert(!zix_remove(file_path));
+  assert(!zix_remove(temp_dir));
+  free(empty_path);
+  free(file_path);
+  free(temp_dir);
+}
+
+/// A file in the tree used to test walking
+typedef struct {
+  const char* path;   ///< Path relative to the root
+  const char* name;   ///< Name of file
+  ZixFileType type;   ///< Type of file
+  unsigned    depth;  ///< Depth in the tree
+  int         parent; ///< Index of parent directory, or -1
+} WalkFile;
+
+#define N_WALK_FILES 7U
+
+static const WalkFile walk_files[N_WALK_FILES] = {
+  {"a", "a", ZIX_FILE_TYPE_REGULAR, 1U, -1},
+  {"d1", "d1", ZIX_FILE_TYPE_DIRECTORY, 1U, -1},
+  {"d1/b", "b", ZIX_FILE_TYPE_REGULAR, 2U, 1},
+  {"d1/d2", "d2", ZIX_FILE_TYPE_DIRECTORY, 2U, 1},
+  {"d1/d2/c", "c", ZIX_FILE_TYPE_REGULAR, 3U, 3},
+  {"d3", "d3", ZIX_FILE_TYPE_DIRECTORY, 1U, -1},
+  {"l", "l", ZIX_FILE_TYPE_SYMLINK, 1U, -1},
+};
+
+typedef struct {
+  const char*       root;                   ///< Root path
+  ZixDirWalkOptions options;                ///< Walk options
+  bool              parallel;               ///< True if visits are parallel
+  unsigned          stop_after;             ///< Stop after this many visits
+  unsigned          n_total;                ///< Total number of visits
+  unsigned          n_visits[N_WALK_FILES]; ///< Number of visits of each file
+  unsigned          order[N_WALK_FILES];    ///< Visit order of each file
+} WalkCounts;
+
+static ZixStatus
+count_walk_entry(void* const data, const ZixDirWalkEntry* const entry)
+{
+  WalkCounts* const counts   = (WalkCounts*)data;
+  const size_t      root_len = strlen(counts->root);
+  const size_t      path_len = strlen(entry->path);
+  const size_t      name_len = strlen(entry->name);
+
+  // Check that the path is the root path joined with a name
+  assert(!strncmp(entry->path, counts->root, root_len));
+  assert(path_len > root_len + name_len);
+  assert(entry->name == entry->path + path_len - name_len);
+
+  // Find the file by name
+  unsigned i = 0U;
+  while (i < N_WALK_FILES && !!strcmp(walk_files[i].name, entry->name)) {
+    ++i;
+  }
+
+  assert(i < N_WALK_FILES);
+  assert(entry->depth == walk_files[i].depth);
+  assert(entry->type == walk_files[i].type ||
+         (walk_files[i].type == ZIX_FILE_TYPE_SYMLINK &&
+          entry->type == ZIX_FILE_TYPE_DIRECTORY));
+
+  // Check that the status is only given if requested
+  if (counts->options & ZIX_DIR_WALK_STATUS) {
+    assert(entry->status);
+    assert(entry->status->type == entry->type);
+    assert(entry->status->modified > 0);
+    assert(entry->type != ZIX_FILE_TYPE_REGULAR || entry->status->size == 4);
+  } else {
+    assert(!entry->status);
+  }
+
+  ++counts->n_visits[i];
+  if (!counts->parallel) {
+    counts->order[i] = ++counts->n_total;
+    if (counts->n_total == counts->stop_after) {
+      return ZIX_STATUS_ERROR;
+    }
+  }
+
+  return ZIX_STATUS_SUCCESS;
+}
+
+static void
+test_dir_walk(void)
+{
+  char* const temp_dir = create_temp_dir("zixXXXXXX");
+
+  // Create a small tree with a directory link
+  char* paths[N_WALK_FILES] = {NULL};
+  for (unsigned i = 0U; i < N_WALK_FILES; ++i) {
+    paths[i] = zix_path_join(NULL, temp_dir, walk_files[i].path);
+    if (walk_files[i].type == ZIX_FILE_TYPE_DIRECTORY) {
+      assert(!zix_create_directory(paths[i]));
+    } else if (walk_files[i].type == ZIX_FILE_TYPE_REGULAR) {
+      assert(!write_to_path(paths[i], "test"));
+    }
+  }
+
+  const bool have_link =
+    !zix_create_directory_symlink(paths[1], paths[N_WALK_FILES - 1U]);
+
+  // Walk the tree with every combination of options
+  for (ZixDirWalkOptions options = 0U; options < 4U; ++options) {
+    for (unsigned n_threads = 1U; n_threads <= 3U; n_threads += 2U) {
+      WalkCounts counts = {temp_dir, options, n_threads > 1U, 0U, 0U, {0}, {0}};
+
+      assert(!zix_dir_walk(
+        NULL, temp_dir, options, n_threads, count_walk_entry, &counts));
+
+      for (unsigned i = 0U; i < N_WALK_FILES; ++i) {
+        const bool exists = have_link || i < N_WALK_FILES - 1U;
+        assert(counts.n_visits[i] == (exists ? 1U : 0U));
+
+        // Check that directories are visited before or after their contents
+        const int parent = walk_files[i].parent;
+        if (!counts.parallel && parent >= 0) {
+          assert((options & ZIX_DIR_WALK_POST_ORDER)
+                   ? counts.order[parent] > counts.order[i]
+                   : counts.order[parent] < counts.order[i]);
+        }
+      }
+    }
+  }
+
+  // Stop the walk early by returning an error from the visitor
+  WalkCounts stopped = {temp_dir, 0U, false, 2U, 0U, {0}, {0}};
+  assert(zix_dir_walk(NULL, temp_dir, 0U, 1U, count_walk_entry, &stopped) ==
+         ZIX_STATUS_ERROR);
+  assert(stopped.n_total == 2U);
+
+  // Fail to walk a nonexistent directory or a file
+  WalkCounts counts = {temp_dir, 0U, false, 0U, 0U, {0}, {0}};
+  assert(zix_dir_walk(
+           NULL, "/does/not/exist", 0U, 1U, count_walk_entry, &counts) ==
+         ZIX_STATUS_NOT_FOUND);
+  assert(zix_dir_walk(NULL, paths[0], 0U, 1U, count_walk_entry, &counts));
+  assert(!counts.n_total);
+
+  // Count the allocations needed for a walk, then check failures of each
+  ZixFailingAllocator allocator = zix_failing_allocator();
+  assert(!zix_dir_walk(
+    &allocator.base, temp_dir, 0U, 1U, count_walk_entry, &counts));
+
+  const size_t n_allocs = zix_failing_allocator_reset(&allocator, 0U);
+  for (size_t i = 0U; i < n_allocs; ++i) {
+    memset(&counts, 0, sizeof(counts));
+    counts.root = temp_dir;
+    zix_failing_allocator_reset(&allocator, i);
+    assert(zix_dir_walk(&allocator.base,
+                        temp_dir,
+                        0U,
+                        1U,
+                        count_walk_entry,
+                        &counts) == ZIX_STATUS_NO_MEM);
+  }
+
+  // Remove everything in reverse order
+  for (unsigned i = 0U; i < N_WALK_FILES; ++i) {
+    char* const path = paths[N_WALK_FILES - i - 1U];
+    assert(!zix_remove(path) || (!have_link && !i));
+    free(path);
+  }
+
+  assert(!zix_remove(temp_dir));
+  free(temp_dir);
+}
+
+static void
+test_remove_all(void)
+{
+  char* const temp_dir    = create_temp_dir("zixXXXXXX");
+  char* const outside_dir = zix_path_join(NULL, temp_dir, "outside");
+  char* const keep_path   = zix_path_join(NULL, outside_dir, "keep");
+  char* const tree_dir    = zix_path_join(NULL, temp_dir, "tree");
+  char* const link_path   = zix_path_join(NULL, tree_dir, "l");
+  assert(!zix_create_directory(outside_dir));
+  assert(!write_to_path(keep_path, "keep"));
+
+  // Fail to remove a nonexistent file
+  assert(zix_remove_all(NULL, tree_dir, 1U) == ZIX_STATUS_NOT_FOUND);
+
+  // Remove a single file
+  assert(!write_to_path(tree_dir, "file"));
+  assert(!zix_remove_all(NULL, tree_dir, 1U));
+  assert(zix_file_type(tree_dir) == ZIX_FILE_TYPE_NONE);
+
+  for (unsigned n_threads = 0U; n_threads <= 4U; ++n_threads) {
+    // Create a tree with a link to a directory outside of it
+    assert(!zix_create_directory(tree_dir));
+    for (unsigned i = 0U; i < N_WALK_FILES; ++i) {
+      char* const path = zix_path_join(NULL, tree_dir, walk_files[i].path);
+      if (walk_files[i].type == ZIX_FILE_TYPE_DIRECTORY) {
+        assert(!zix_create_directory(path));
+      } else if (walk_files[i].type == ZIX_FILE_TYPE_REGULAR) {
+        assert(!write_to_path(path, "test"));
+      }
+      free(path);
+    }
+
+    (void)zix_create_directory_symlink(outside_dir, link_path);
+
+    // Fail to remove the tree without memory, then remove it
+    if (!n_threads) {
+      ZixFailingAllocator allocator = zix_failing_allocator();
+      zix_failing_allocator_reset(&allocator, 0U);
+      assert(zix_remove_all(&allocator.base, tree_dir, 1U) ==
+             ZIX_STATUS_NO_MEM);
+      assert(zix_file_type(tree_dir) == ZIX_FILE_TYPE_DIRECTORY);
+    }
+
+    assert(!zix_remove_all(NULL, tree_dir, n_threads));
+    assert(zix_file_type(tree_dir) == ZIX_FILE_TYPE_NONE);
+    assert(zix_file_type(keep_path) == ZIX_FILE_TYPE_REGULAR);
+  }
+
+  assert(!zix_remove_all(NULL, temp_dir, 2U));
+  assert(zix_file_type(temp_dir) == ZIX_FILE_TYPE_NONE);
+  free(link_path);
+  free(tree_dir);
+  free(keep_path);
+  free(outside_dir);
+  free(temp_dir);
+}
+
 static void
 test_dir_for_each(void)
 {
@@ -507,6 +1080,22 @@ test_file_equals(const char* const data_file_path)
   // Same path
   assert(check_file_equals(path1, path1));
 
+  // Large files with equal sizes, which may be compared by mapping them
+  const size_t large_size = 0x200000U;
+  char* const  large      = (char*)malloc(large_size + 1U);
+  assert(large);
+  memset(large, 'a', large_size);
+  large[large_size] = '\0';
+  assert(!write_to_path(path1, large));
+  assert(!write_to_path(path2, large));
+  assert(check_file_equals(path1, path2));
+
+  // Large files that differ only in the last byte
+  large[large_size - 1U] = 'b';
+  assert(!write_to_path(path2, large));
+  assert(!check_file_equals(path1, path2));
+  free(large);
+
   // Different devices
   if (data_file_path) {
     assert(!check_file_equals(data_file_path, path2));
@@ -551,6 +1140,81 @@ test_file_size(void)
   free(temp_dir);
 }
 
+static bool
+file_status_equals(const ZixFileStatus* const a, const ZixFileStatus* const b)
+{
+  return a->type == b->type && a->size == b->size &&
+         a->modified == b->modified && a->inode == b->inode &&
+         a->device == b->device;
+}
+
+static void
+test_file_status(void)
+{
+  static const size_t n_files = 10U;
+
+  char* const temp_dir  = create_temp_dir("zixXXXXXX");
+  char* const file_path = zix_path_join(NULL, temp_dir, "zix_test_file");
+  assert(!write_to_path(file_path, "test"));
+
+  // Get the status of a file, a directory, and a nonexistent file
+  ZixFileStatus status = {ZIX_FILE_TYPE_UNKNOWN, 1, 1, 1U, 1U};
+  assert(!zix_file_status(file_path, &status));
+  assert(status.type == ZIX_FILE_TYPE_REGULAR);
+  assert(status.size == 4);
+  assert(status.size == zix_file_size(file_path));
+  assert(status.modified > 0);
+
+  assert(!zix_file_status(temp_dir, &status));
+  assert(status.type == ZIX_FILE_TYPE_DIRECTORY);
+  assert(status.modified > 0);
+
+  assert(zix_file_status("/does/not/exist", &status) == ZIX_STATUS_NOT_FOUND);
+  assert(status.type == ZIX_FILE_TYPE_NONE);
+  assert(!status.size);
+  assert(!status.modified);
+
+  // Make a batch of paths with a directory and a missing file at the end
+  char*          file_paths[10] = {NULL};
+  const char*    paths[12]      = {NULL};
+  ZixFileStatus  statuses[12]   = {{ZIX_FILE_TYPE_NONE, 0, 0, 0U, 0U}};
+  const size_t   n_paths        = n_files + 2U;
+  char           name[16]       = {'f', '0', '\0'};
+  for (size_t i = 0U; i < n_files; ++i) {
+    name[1]       = (char)('0' + i);
+    file_paths[i] = zix_path_join(NULL, temp_dir, name);
+    paths[i]      = file_paths[i];
+    assert(!write_to_path(paths[i], name));
+  }
+
+  paths[n_files]      = temp_dir;
+  paths[n_files + 1U] = "/does/not/exist";
+
+  // Get the status of the batch, and of smaller batches
+  for (size_t n = n_paths; n > 0U; n -= 3U) {
+    const ZixStatus st = zix_file_status_many(n, paths, statuses);
+    assert(st == ((n == n_paths) ? ZIX_STATUS_NOT_FOUND : ZIX_STATUS_SUCCESS));
+
+    for (size_t i = 0U; i < n; ++i) {
+      const ZixStatus single_st = zix_file_status(paths[i], &status);
+      assert(single_st == ((i == n_files + 1U) ? ZIX_STATUS_NOT_FOUND
+                                               : ZIX_STATUS_SUCCESS));
+      assert(file_status_equals(&statuses[i], &status));
+      assert(i >= n_files || statuses[i].size == 2);
+    }
+  }
+
+  for (size_t i = 0U; i < n_files; ++i) {
+    assert(!zix_remove(file_paths[i]));
+    free(file_paths[i]);
+  }
+
+  assert(!zix_remove(file_path));
+  assert(!zix_remove(temp_dir));
+  free(file_path);
+  free(temp_dir);
+}
+
 static void
 test_create_symlink(void)
 {
@@ -662,13 +1326,21 @@ main(const int argc, char** const argv)
   test_canonical_path();
   test_file_type();
   test_copy_file(data_file_path);
+  test_copy_sparse_file();
+  test_copy_tree();
+  test_sync_files();
   test_flock();
+  test_file_map();
   test_dir_for_each();
+  test_dir_walk();
+  test_remove_all();
   test_create_temporary_directory();
   test_create_directory_like();
   test_create_directories();
   test_file_equals(data_file_path);
+  test_transfer_files();
   test_file_size();
+  test_file_status();
   test_create_symlink();
   test_create_directory_symlink();
   test_create_hard_link();
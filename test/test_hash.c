@@ -347,6 +347,63 @@ test_all_tombstones(void)
 #undef N_STRINGS
 }
 
+static ZixDigestKey attacked_seed = {0U, 0U};
+
+/// Keyed hash function that collides for every key until a table is reseeded
+ZIX_PURE_FUNC static size_t
+attacked_string_hash(const char* const str, const ZixDigestKey* const seed)
+{
+  if (seed->k0 == attacked_seed.k0 && seed->k1 == attacked_seed.k1) {
+    return 42U;
+  }
+
+  return (size_t)zix_digest64_keyed(seed, str, strlen(str));
+}
+
+static void
+test_keyed(void)
+{
+#define N_STRINGS 1024U
+
+  ZixHash* hash =
+    zix_hash_new(NULL, identity, decent_string_hash, string_equal);
+  assert(!zix_hash_seed(hash));
+  zix_hash_free(hash);
+
+  hash = zix_hash_new_keyed(NULL, identity, attacked_string_hash, string_equal);
+  assert(hash);
+
+  const ZixDigestKey* const seed = zix_hash_seed(hash);
+  assert(seed);
+  attacked_seed = *seed;
+
+  // Insert many keys which initially all collide
+  static char strings[N_STRINGS][16];
+  for (unsigned i = 0U; i < N_STRINGS; ++i) {
+    snprintf(strings[i], sizeof(strings[i]), "%u", i);
+    assert(!zix_hash_insert(hash, strings[i]));
+  }
+
+  // Check that the table has been reseeded and everything can still be found
+  assert(zix_hash_seed(hash)->k0 != attacked_seed.k0 ||
+         zix_hash_seed(hash)->k1 != attacked_seed.k1);
+
+  assert(zix_hash_size(hash) == N_STRINGS);
+  for (unsigned i = 0U; i < N_STRINGS; ++i) {
+    assert(zix_hash_find_record(hash, strings[i]) == strings[i]);
+  }
+
+  for (unsigned i = 0U; i < N_STRINGS; ++i) {
+    const char* removed = NULL;
+    assert(!zix_hash_remove(hash, strings[i], &removed));
+    assert(removed == strings[i]);
+  }
+
+  zix_hash_free(hash);
+
+#undef N_STRINGS
+}
+
 static void
 test_failed_alloc(void)
 {
@@ -369,6 +426,7 @@ main(void)
   zix_hash_free(NULL);
 
   test_all_tombstones();
+  test_keyed();
   test_failed_alloc();
 
   static const size_t n_elems = 1024U;
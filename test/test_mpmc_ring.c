@@ -0,0 +1,274 @@
+// Copyright 2011-2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "failing_allocator.h"
+#include "test_args.h"
+
+#include <zix/attributes.h>
+#include <zix/mpmc_ring.h>
+#include <zix/status.h>
+#include <zix/thread.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_WRITERS 3U
+#define N_READERS 3U
+#define MAX_PAYLOAD 24U
+
+typedef struct {
+  uint32_t writer; ///< Index of the writer that wrote this record
+  uint32_t seq;    ///< Sequence number within the writer
+  uint8_t  payload[MAX_PAYLOAD];
+} Record;
+
+typedef struct {
+  uint32_t id;                   ///< Index of this reader or writer
+  unsigned n_records;            ///< Number of records read or written
+  uint32_t last_seq[N_WRITERS];  ///< Last sequence number seen per writer
+  unsigned n_seen[N_WRITERS];    ///< Number of records read per writer
+} Context;
+
+static ZixMpmcRing* ring     = NULL;
+static unsigned     n_writes = 0U;
+
+static uint32_t
+record_size(const uint32_t seq)
+{
+  return (uint32_t)(2U * sizeof(uint32_t)) + (seq % (MAX_PAYLOAD + 1U));
+}
+
+static ZixThreadResult ZIX_THREAD_FUNC
+writer(void* const arg)
+{
+  Context* const ctx = (Context*)arg;
+
+  for (uint32_t seq = 0U; seq < n_writes; ++seq) {
+    Record record = {ctx->id, seq, {0U}};
+    for (uint32_t i = 0U; i < MAX_PAYLOAD; ++i) {
+      record.payload[i] = (uint8_t)(ctx->id + seq + i);
+    }
+
+    const uint32_t size = record_size(seq);
+    if (seq % 2U) {
+      while (zix_mpmc_ring_write(ring, &record, size) != size) {
+      }
+    } else {
+      // Write the header and payload separately in a transaction
+      ZixMpmcRingTransaction tx = {0U, 0U, 0U};
+      while (zix_mpmc_ring_begin_write(ring, size, &tx)) {
+      }
+
+      const uint32_t head_size = (uint32_t)(2U * sizeof(uint32_t));
+      assert(!zix_mpmc_ring_amend_write(ring, &tx, &record, head_size));
+      assert(!zix_mpmc_ring_amend_write(
+        ring, &tx, record.payload, size - head_size));
+      assert(zix_mpmc_ring_amend_write(ring, &tx, &record, 1U) ==
+             ZIX_STATUS_NO_MEM);
+      assert(!zix_mpmc_ring_commit_write(ring, &tx));
+    }
+
+    ++ctx->n_records;
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static ZixThreadResult ZIX_THREAD_FUNC
+reader(void* const arg)
+{
+  Context* const ctx = (Context*)arg;
+
+  Record   record = {0U, 0U, {0U}};
+  uint32_t size   = 0U;
+  for (;;) {
+    const ZixStatus st =
+      zix_mpmc_ring_read(ring, &record, (uint32_t)sizeof(record), &size);
+    if (st == ZIX_STATUS_UNAVAILABLE) {
+      continue;
+    }
+
+    assert(!st);
+    if (size == 1U) {
+      break; // Stop record
+    }
+
+    // Check that the record is intact
+    assert(record.writer < N_WRITERS);
+    assert(size == record_size(record.seq));
+    for (uint32_t i = 0U; i < size - 2U * sizeof(uint32_t); ++i) {
+      assert(record.payload[i] == (uint8_t)(record.writer + record.seq + i));
+    }
+
+    // Check that records from each writer are read in order
+    const uint32_t w = record.writer;
+    assert(!ctx->n_seen[w] || record.seq > ctx->last_seq[w]);
+    ctx->last_seq[w] = record.seq;
+    ++ctx->n_seen[w];
+    ++ctx->n_records;
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+test_threaded(const uint32_t size)
+{
+  printf("Testing %u writers of %u records with %u readers on a %u byte ring\n",
+         N_WRITERS,
+         n_writes,
+         N_READERS,
+         size);
+
+  ring = zix_mpmc_ring_new(NULL, size);
+  assert(ring);
+
+  const ZixStatus st = zix_mpmc_ring_mlock(ring);
+  assert(!st || st == ZIX_STATUS_NOT_SUPPORTED || st == ZIX_STATUS_UNAVAILABLE);
+
+  static const size_t stack_size = 65536U;
+
+  Context   writer_contexts[N_WRITERS];
+  Context   reader_contexts[N_READERS];
+  ZixThread writers[N_WRITERS];
+  ZixThread readers[N_READERS];
+  memset(writer_contexts, 0, sizeof(writer_contexts));
+  memset(reader_contexts, 0, sizeof(reader_contexts));
+
+  for (uint32_t i = 0U; i < N_READERS; ++i) {
+    reader_contexts[i].id = i;
+    assert(!zix_thread_create(
+      &readers[i], stack_size, reader, &reader_contexts[i]));
+  }
+
+  for (uint32_t i = 0U; i < N_WRITERS; ++i) {
+    writer_contexts[i].id = i;
+    assert(!zix_thread_create(
+      &writers[i], stack_size, writer, &writer_contexts[i]));
+  }
+
+  for (uint32_t i = 0U; i < N_WRITERS; ++i) {
+    assert(!zix_thread_join(writers[i]));
+    assert(writer_contexts[i].n_records == n_writes);
+  }
+
+  // Send one stop record to each reader
+  for (uint32_t i = 0U; i < N_READERS; ++i) {
+    while (zix_mpmc_ring_write(ring, "q", 1U) != 1U) {
+    }
+  }
+
+  unsigned n_read = 0U;
+  for (uint32_t i = 0U; i < N_READERS; ++i) {
+    assert(!zix_thread_join(readers[i]));
+    n_read += reader_contexts[i].n_records;
+  }
+
+  assert(n_read == N_WRITERS * n_writes);
+
+  zix_mpmc_ring_free(ring);
+  ring = NULL;
+}
+
+static void
+test_sequential(void)
+{
+  zix_mpmc_ring_free(NULL);
+
+  assert(!zix_mpmc_ring_new(NULL, 0U));
+  assert(!zix_mpmc_ring_new(NULL, 7U));
+  assert(!zix_mpmc_ring_new(NULL, 2147483649U));
+
+  ZixMpmcRing* const r = zix_mpmc_ring_new(NULL, 12U);
+  assert(r);
+  assert(zix_mpmc_ring_capacity(r) == 12U);
+
+  char     buf[16] = {0};
+  uint32_t size    = 0U;
+  assert(zix_mpmc_ring_read(r, buf, sizeof(buf), &size) ==
+         ZIX_STATUS_UNAVAILABLE);
+
+  // Write records that wrap around the end of the buffer several times
+  for (unsigned i = 0U; i < 8U; ++i) {
+    assert(zix_mpmc_ring_write(r, "hello", 5U) == 5U);
+    assert(!zix_mpmc_ring_write(r, "world", 5U));
+
+    assert(zix_mpmc_ring_read(r, buf, 4U, &size) == ZIX_STATUS_NO_SPACE);
+    assert(size == 5U);
+    assert(!zix_mpmc_ring_read(r, buf, sizeof(buf), &size));
+    assert(size == 5U);
+    assert(!strncmp(buf, "hello", 5U));
+
+    assert(zix_mpmc_ring_write(r, "world", 5U) == 5U);
+    assert(!zix_mpmc_ring_read(r, buf, sizeof(buf), &size));
+    assert(size == 5U);
+    assert(!strncmp(buf, "world", 5U));
+    assert(zix_mpmc_ring_read(r, buf, sizeof(buf), &size) ==
+           ZIX_STATUS_UNAVAILABLE);
+  }
+
+  // Fail to write an empty record, and write the largest possible record
+  ZixMpmcRingTransaction tx = {0U, 0U, 0U};
+  assert(zix_mpmc_ring_begin_write(r, 0U, &tx) == ZIX_STATUS_BAD_ARG);
+  assert(!zix_mpmc_ring_write(r, "", 0U));
+  assert(zix_mpmc_ring_read(r, buf, sizeof(buf), &size) ==
+         ZIX_STATUS_UNAVAILABLE);
+  assert(!zix_mpmc_ring_write(r, "0123456789abc", 13U));
+  assert(zix_mpmc_ring_write(r, "0123456789ab", 12U) == 12U);
+  assert(!zix_mpmc_ring_read(r, buf, sizeof(buf), &size));
+  assert(size == 12U);
+  assert(!strncmp(buf, "0123456789ab", 12U));
+
+  // Write with a transaction and reset before committing
+  assert(!zix_mpmc_ring_begin_write(r, 4U, &tx));
+  assert(zix_mpmc_ring_begin_write(r, 8U, &tx) == ZIX_STATUS_NO_MEM);
+  zix_mpmc_ring_reset(r);
+  assert(zix_mpmc_ring_read(r, buf, sizeof(buf), &size) ==
+         ZIX_STATUS_UNAVAILABLE);
+
+  zix_mpmc_ring_free(r);
+}
+
+static void
+test_failed_alloc(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  // Successfully allocate a ring to count the number of allocations
+  ring = zix_mpmc_ring_new(&allocator.base, 512);
+  assert(ring);
+
+  // Test that each allocation failing is handled gracefully
+  const size_t n_new_allocs = zix_failing_allocator_reset(&allocator, 0);
+  for (size_t i = 0U; i < n_new_allocs; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+    assert(!zix_mpmc_ring_new(&allocator.base, 512));
+  }
+
+  zix_mpmc_ring_free(ring);
+  ring = NULL;
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    printf("Usage: %s SIZE [N_WRITES]\n", argv[0]);
+    return 1;
+  }
+
+  const uint32_t size =
+    (argc > 1) ? (uint32_t)zix_test_size_arg(argv[1], 64U, 1U << 20U) : 1024U;
+
+  n_writes = (argc > 2) ? (unsigned)zix_test_size_arg(argv[2], 4U, 1U << 20U)
+                        : 1U << 10U;
+
+  test_sequential();
+  test_failed_alloc();
+  test_threaded(size);
+  return 0;
+}
@@ -0,0 +1,173 @@
+// Copyright 2025 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "failing_allocator.h"
+#include "test_args.h"
+
+#include <zix/allocator.h>
+#include <zix/attributes.h>
+#include <zix/pool_allocator.h>
+#include <zix/status.h>
+#include <zix/thread.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_THREADS 4U
+#define OBJECT_SIZE 40U
+
+typedef struct {
+  ZixAllocator* allocator; ///< Shared pool allocator
+  uint32_t      id;        ///< Index of this thread
+  unsigned      n_rounds;  ///< Number of allocate and free rounds
+} Context;
+
+static void
+test_sequential(void)
+{
+  assert(!zix_pool_allocator_new(NULL, 0U, 8U, 4U));
+  assert(!zix_pool_allocator_new(NULL, 16U, 0U, 4U));
+  assert(!zix_pool_allocator_new(NULL, 16U, 24U, 4U));
+
+  ZixPoolAllocator* const pool = zix_pool_allocator_new(NULL, 24U, 32U, 3U);
+  ZixAllocator* const     base = zix_pool_allocator_base(pool);
+
+  const ZixStatus st = zix_pool_allocator_mlock(pool);
+  assert(!st || st == ZIX_STATUS_NOT_SUPPORTED || st == ZIX_STATUS_UNAVAILABLE);
+
+  // Allocate enough objects to grow the pool several times
+  char* objects[64] = {NULL};
+  for (unsigned i = 0U; i < 64U; ++i) {
+    objects[i] = (char*)zix_malloc(base, 1U + (i % 24U));
+    assert(objects[i]);
+    assert((uintptr_t)objects[i] % 32U == 0U);
+    memset(objects[i], (int)i, 24U);
+  }
+
+  for (unsigned i = 0U; i < 64U; ++i) {
+    for (unsigned j = 0U; j < 24U; ++j) {
+      assert(objects[i][j] == (char)i);
+    }
+  }
+
+  // Objects that are too large or aligned fail, and realloc never moves
+  assert(!zix_malloc(base, 25U));
+  assert(!zix_aligned_alloc(base, 64U, 8U));
+  assert(zix_realloc(base, objects[0], 24U) == objects[0]);
+  assert(!zix_realloc(base, objects[0], 25U));
+
+  // Freed objects are reused last in, first out
+  zix_free(base, objects[7]);
+  zix_aligned_free(base, objects[3]);
+  zix_free(base, NULL);
+  zix_free(base, base); // Not from this pool
+  assert(zix_realloc(base, NULL, 8U) == objects[3]);
+
+  char* const calloced = (char*)zix_calloc(base, 2U, 12U);
+  assert(calloced == objects[7]);
+  for (unsigned j = 0U; j < 24U; ++j) {
+    assert(!calloced[j]);
+  }
+
+  assert(!zix_calloc(base, 5U, 5U));
+
+  zix_pool_allocator_free(pool);
+  zix_pool_allocator_free(NULL);
+}
+
+static void
+test_failed_alloc(void)
+{
+  ZixFailingAllocator allocator = zix_failing_allocator();
+
+  // Fail to allocate the pool or its first chunk
+  for (size_t i = 0U; i < 2U; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+    assert(!zix_pool_allocator_new(&allocator.base, 8U, 8U, 2U));
+  }
+
+  // Fail to grow the pool
+  zix_failing_allocator_reset(&allocator, 2U);
+  ZixPoolAllocator* const pool =
+    zix_pool_allocator_new(&allocator.base, 8U, 8U, 2U);
+
+  ZixAllocator* const base = zix_pool_allocator_base(pool);
+  assert(zix_malloc(base, 8U));
+  assert(zix_malloc(base, 8U));
+  assert(!zix_malloc(base, 8U));
+
+  zix_pool_allocator_free(pool);
+}
+
+static ZixThreadResult ZIX_THREAD_FUNC
+churn(void* const arg)
+{
+  Context* const ctx = (Context*)arg;
+  char*          objects[16];
+
+  for (unsigned r = 0U; r < ctx->n_rounds; ++r) {
+    const unsigned n = 1U + ((ctx->id + r) % 16U);
+
+    for (unsigned i = 0U; i < n; ++i) {
+      objects[i] = (char*)zix_malloc(ctx->allocator, OBJECT_SIZE);
+      assert(objects[i]);
+      memset(objects[i], (int)ctx->id, OBJECT_SIZE);
+    }
+
+    // Check that no other thread was given the same object in the meantime
+    for (unsigned i = 0U; i < n; ++i) {
+      for (unsigned j = 0U; j < OBJECT_SIZE; ++j) {
+        assert(objects[i][j] == (char)ctx->id);
+      }
+
+      zix_free(ctx->allocator, objects[i]);
+    }
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+test_threaded(const unsigned n_rounds)
+{
+  ZixPoolAllocator* const pool =
+    zix_pool_allocator_new(NULL, OBJECT_SIZE, 8U, 4U);
+
+  Context   contexts[N_THREADS];
+  ZixThread threads[N_THREADS];
+  for (uint32_t i = 0U; i < N_THREADS; ++i) {
+    contexts[i].allocator = zix_pool_allocator_base(pool);
+    contexts[i].id        = i + 1U;
+    contexts[i].n_rounds  = n_rounds;
+    assert(!zix_thread_create(&threads[i], 65536U, churn, &contexts[i]));
+  }
+
+  for (uint32_t i = 0U; i < N_THREADS; ++i) {
+    assert(!zix_thread_join(threads[i]));
+  }
+
+  zix_pool_allocator_free(pool);
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 2) {
+    printf("Usage: %s [N_ROUNDS]\n", argv[0]);
+    return 1;
+  }
+
+  const unsigned n_rounds =
+    (argc > 1) ? (unsigned)zix_test_size_arg(argv[1], 1U, 1U << 20U) : 4096U;
+
+  printf("Testing %u rounds in %u threads\n", n_rounds, N_THREADS);
+
+  test_sequential();
+  test_failed_alloc();
+  test_threaded(n_rounds);
+  return 0;
+}
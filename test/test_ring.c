@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define MSG_SIZE 20U
 
@@ -180,6 +181,138 @@ test_capacity(void)
   }
 }
 
+static void
+test_vectors(void)
+{
+  static const char* const data = "abcdefg";
+
+  ZixRing* const r = zix_ring_new(NULL, 8U);
+  assert(r);
+
+  // Empty vectors
+  ZixRingVector vec = zix_ring_read_vector(r);
+  assert(vec.first.size == 0U);
+  assert(vec.second.size == 0U);
+
+  // Move the heads near the end of the buffer
+  char buf[8] = {0};
+  assert(zix_ring_write(r, data, 5U) == 5U);
+  assert(zix_ring_read(r, buf, 5U) == 5U);
+
+  // Write in place, wrapping around the end
+  vec = zix_ring_write_vector(r);
+  assert(vec.first.size == 3U);
+  assert(vec.second.size == 4U);
+  assert(vec.first.size + vec.second.size == zix_ring_write_space(r));
+  memcpy(vec.first.data, data, vec.first.size);
+  memcpy(vec.second.data, data + vec.first.size, vec.second.size);
+  assert(!zix_ring_advance_write(r, 8U));
+  assert(zix_ring_read_space(r) == 0U);
+  assert(zix_ring_advance_write(r, 7U) == 7U);
+  assert(zix_ring_write_space(r) == 0U);
+
+  // Read in place, wrapping around the end
+  vec = zix_ring_read_vector(r);
+  assert(vec.first.size == 3U);
+  assert(vec.second.size == 4U);
+  assert(!memcmp(vec.first.data, data, vec.first.size));
+  assert(!memcmp(vec.second.data, data + vec.first.size, vec.second.size));
+  assert(zix_ring_skip(r, 7U) == 7U);
+
+  vec = zix_ring_write_vector(r);
+  assert(vec.first.size == 4U);
+  assert(vec.second.size == 3U);
+
+  zix_ring_free(r);
+}
+
+static void
+test_mirrored(void)
+{
+  static const char* const data = "abcdefg";
+
+  assert(!zix_ring_new_mirrored(NULL, 1U));
+  assert(!zix_ring_new_mirrored(NULL, 2147483649U));
+
+  ZixRing* const r = zix_ring_new_mirrored(NULL, 8U);
+  assert(r);
+
+  const ZixStatus st = zix_ring_mlock(r);
+  assert(!st || st == ZIX_STATUS_NOT_SUPPORTED || st == ZIX_STATUS_UNAVAILABLE);
+
+  // Move the heads near the end of the buffer
+  const uint32_t capacity = zix_ring_capacity(r);
+  char* const    buf      = (char*)calloc(capacity, 1U);
+  assert(capacity >= 7U);
+  assert(zix_ring_write(r, buf, capacity - 2U) == capacity - 2U);
+  assert(zix_ring_read(r, buf, capacity - 2U) == capacity - 2U);
+
+  // Write and read across the end of the buffer
+  assert(zix_ring_write(r, data, 7U) == 7U);
+  assert(zix_ring_peek(r, buf, 7U) == 7U);
+  assert(!memcmp(buf, data, 7U));
+
+  const ZixRingVector vec = zix_ring_read_vector(r);
+  assert(vec.first.size + vec.second.size == 7U);
+  assert(!memcmp(vec.first.data, data, vec.first.size));
+  assert(!memcmp(vec.second.data, data + vec.first.size, vec.second.size));
+
+  assert(zix_ring_read(r, buf, 7U) == 7U);
+  assert(!memcmp(buf, data, 7U));
+
+  free(buf);
+  zix_ring_free(r);
+}
+
+#define N_NOTIFIED_WRITES 1024U
+
+static ZixThreadResult ZIX_THREAD_FUNC
+notifying_writer(void* const arg)
+{
+  ZixRing* const r = (ZixRing*)arg;
+
+  for (uint32_t i = 0U; i < N_NOTIFIED_WRITES; ++i) {
+    while (!zix_ring_write(r, &i, sizeof(i))) {
+    }
+
+    zix_ring_notify(r);
+  }
+
+  return ZIX_THREAD_RESULT;
+}
+
+static void
+test_wait(void)
+{
+  ZixRing* const r = zix_ring_new(NULL, 64U);
+  assert(r);
+
+  // Time out on an empty ring
+  assert(zix_ring_wait_read(r, 1U, 0U, 0U) == ZIX_STATUS_TIMEOUT);
+  assert(zix_ring_wait_read(r, 1U, 0U, 1000000U) == ZIX_STATUS_TIMEOUT);
+
+  // Wait for data that's already there
+  zix_ring_notify(r);
+  assert(zix_ring_write(r, "ab", 2U) == 2U);
+  assert(!zix_ring_wait_read(r, 2U, 0U, 0U));
+  assert(zix_ring_wait_read(r, 3U, 0U, 0U) == ZIX_STATUS_TIMEOUT);
+  assert(zix_ring_skip(r, 2U) == 2U);
+
+  // Wait for data written by another thread
+  ZixThread writer_thread; // NOLINT(cppcoreguidelines-init-variables)
+  assert(!zix_thread_create(&writer_thread, 1024U, notifying_writer, r));
+
+  for (uint32_t i = 0U; i < N_NOTIFIED_WRITES; ++i) {
+    uint32_t value = 0U;
+    assert(!zix_ring_wait_read(r, sizeof(value), 10U, 0U));
+    assert(zix_ring_read(r, &value, sizeof(value)) == sizeof(value));
+    assert(value == i);
+  }
+
+  assert(!zix_thread_join(writer_thread));
+  zix_ring_free(r);
+}
+
 static void
 test_failed_alloc(void)
 {
@@ -197,6 +330,19 @@ test_failed_alloc(void)
   }
 
   zix_ring_free(ring);
+
+  // Test the same with a mirrored ring
+  allocator = zix_failing_allocator();
+  ring      = zix_ring_new_mirrored(&allocator.base, 512);
+  assert(ring);
+
+  const size_t n_mirrored_allocs = zix_failing_allocator_reset(&allocator, 0);
+  for (size_t i = 0U; i < n_mirrored_allocs; ++i) {
+    zix_failing_allocator_reset(&allocator, i);
+    assert(!zix_ring_new_mirrored(&allocator.base, 512));
+  }
+
+  zix_ring_free(ring);
 }
 
 int
@@ -214,6 +360,9 @@ main(int argc, char** argv)
                         : size * 1024;
 
   test_capacity();
+  test_vectors();
+  test_mirrored();
+  test_wait();
   test_failed_alloc();
   test_ring(size);
   return 0;